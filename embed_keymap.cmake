@@ -1,5 +1,8 @@
 # Convert keymap.png to C header file for embedding
-# Usage: cmake -DPNG_FILE=path/to/keymap.png -DHEADER_FILE=path/to/output.h -P embed_keymap.cmake
+# Usage: cmake -DPNG_FILE=path/to/keymap.png -DHEADER_FILE=path/to/output.h [-DSYMBOL=name] -P embed_keymap.cmake
+# Defines <SYMBOL>_data and <SYMBOL>_size (default symbol: embedded_keymap).
+# Native builds use the much faster tools/embed_asset.c; this script is the
+# fallback for cross builds, where that host tool can't run.
 
 if(NOT PNG_FILE OR NOT HEADER_FILE)
     message(FATAL_ERROR "Usage: cmake -DPNG_FILE=<input.png> -DHEADER_FILE=<output.h> -P embed_keymap.cmake")
@@ -9,6 +12,10 @@ if(NOT EXISTS "${PNG_FILE}")
     message(FATAL_ERROR "PNG file does not exist: ${PNG_FILE}")
 endif()
 
+if(NOT SYMBOL)
+    set(SYMBOL embedded_keymap)
+endif()
+
 # Read the PNG file as binary
 file(READ "${PNG_FILE}" PNG_DATA HEX)
 
@@ -47,16 +54,15 @@ while(BYTE_INDEX LESS BYTE_COUNT)
 endwhile()
 
 # Generate header file
-get_filename_component(PNG_NAME "${PNG_FILE}" NAME_WE)
-string(TOUPPER "${PNG_NAME}" PNG_NAME_UPPER)
+string(TOUPPER "${SYMBOL}_H" GUARD)
 
 file(WRITE "${HEADER_FILE}" "/* Generated from ${PNG_FILE} */\n")
-file(APPEND "${HEADER_FILE}" "#ifndef KEYMAP_EMBEDDED_H\n")
-file(APPEND "${HEADER_FILE}" "#define KEYMAP_EMBEDDED_H\n\n")
-file(APPEND "${HEADER_FILE}" "static const unsigned char embedded_keymap_data[] = {\n")
+file(APPEND "${HEADER_FILE}" "#ifndef ${GUARD}\n")
+file(APPEND "${HEADER_FILE}" "#define ${GUARD}\n\n")
+file(APPEND "${HEADER_FILE}" "static const unsigned char ${SYMBOL}_data[] = {\n")
 file(APPEND "${HEADER_FILE}" "${C_ARRAY}\n")
 file(APPEND "${HEADER_FILE}" "};\n\n")
-file(APPEND "${HEADER_FILE}" "static const unsigned int embedded_keymap_size = ${BYTE_COUNT};\n\n")
-file(APPEND "${HEADER_FILE}" "#endif /* KEYMAP_EMBEDDED_H */\n")
+file(APPEND "${HEADER_FILE}" "static const unsigned int ${SYMBOL}_size = ${BYTE_COUNT};\n\n")
+file(APPEND "${HEADER_FILE}" "#endif /* ${GUARD} */\n")
 
 message(STATUS "Generated ${HEADER_FILE} from ${PNG_FILE} (${BYTE_COUNT} bytes)")
\ No newline at end of file
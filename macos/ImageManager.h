@@ -5,10 +5,17 @@
 
 - (instancetype)initWithConfig:(Config)config;
 - (BOOL)loadOverlay;
+/* loadOverlay on a background queue; nothing else may touch the overlay
+   until waitForOverlay, which blocks for the remaining work and returns
+   the load result */
+- (void)prepareOverlayInBackground;
+- (BOOL)waitForOverlay;
 - (BOOL)reloadOverlayIfNeeded;
 - (const unsigned char *)getOverlayData;
 - (int)getOverlayWidth;
 - (int)getOverlayHeight;
 - (void)updateConfig:(Config)newConfig;
+/* Leave opacity to the presenter's global alpha; pixel passes only invert */
+- (void)setPresenterOpacity:(BOOL)enabled;
 
 @end
@@ -3,16 +3,24 @@
 #import "../shared/config.h"
 #import "../shared/overlay.h"
 #import "../shared/log.h"
+#import "../shared/overlay_disk_cache.h"
+#import "../shared/overlay_bytes.h"
+#import "../shared/overlay_layout.h"
+#import "../shared/overlay_bundle.h"
 
 @interface ImageManager () {
     Config _config;
     Overlay _overlay;
-    unsigned char *_originalImageData;
-    int _originalImageSize;
+    OverlaySource _source; /* decoded once; size changes only resample */
+    OverlayBytes _originalImage; /* mapped file or embedded keymap, never copied */
+    uint64_t _sourceId; /* overlay_disk_cache_source_id of the mapped bytes */
     float _lastScale;
     int _lastCustomWidth;
     int _lastCustomHeight;
     int _lastUseCustom;
+    BOOL _presenterOpacity;
+    dispatch_group_t _loadGroup; /* prepareOverlayInBackground in flight */
+    BOOL _loadResult;
 }
 @end
 
@@ -22,8 +30,6 @@
     self = [super init];
     if (self) {
         _config = config;
-        _originalImageData = NULL;
-        _originalImageSize = 0;
         _lastScale = -1.0f;
         _lastCustomWidth = -1;
         _lastCustomHeight = -1;
@@ -33,82 +39,148 @@
 }
 
 - (void)dealloc {
-    if (_originalImageData) {
-        free(_originalImageData);
-        _originalImageData = NULL;
-    }
     free_overlay(&_overlay);
+    overlay_source_free(&_source);
+    overlay_bytes_release(&_originalImage);
 }
 
-- (BOOL)loadOverlay {
+/* Screen metrics are AppKit state: read them on the calling (main) thread */
+- (void)getMaxWidth:(int *)max_w height:(int *)max_h {
     NSScreen *screen = [NSScreen mainScreen];
     CGFloat scale = [screen backingScaleFactor];
-    int max_w = 0;
-    int max_h = 0;
 
     if (_config.use_custom_size) {
-        max_w = _config.custom_width_px > 0 ? _config.custom_width_px : (int)([screen frame].size.width * scale * _config.scale);
-        max_h = _config.custom_height_px > 0 ? _config.custom_height_px : (int)([screen frame].size.height * scale * _config.scale);
+        *max_w = _config.custom_width_px > 0 ? _config.custom_width_px : (int)([screen frame].size.width * scale * _config.scale);
+        *max_h = _config.custom_height_px > 0 ? _config.custom_height_px : (int)([screen frame].size.height * scale * _config.scale);
     } else {
-        max_w = (int)([screen frame].size.width * scale * _config.scale);
-        max_h = (int)([screen frame].size.height * scale * _config.scale);
+        *max_w = (int)([screen frame].size.width * scale * _config.scale);
+        *max_h = (int)([screen frame].size.height * scale * _config.scale);
     }
+}
 
-    if (!_originalImageData) {
-        /* Try multiple locations for keymap.png */
-        NSArray *searchPaths = @[
-            @"keymap.png",
-            @"assets/keymap.png",
-            @"../assets/keymap.png",
-            [[NSBundle mainBundle] pathForResource:@"keymap" ofType:@"png"] ?: @"",
-        ];
-
-        for (NSString *pathStr in searchPaths) {
-            if ([pathStr length] == 0) continue;
-            NSData *d = [NSData dataWithContentsOfFile:pathStr];
-            if (d) {
-                _originalImageSize = (int)[d length];
-                _originalImageData = malloc(_originalImageSize);
-                if (_originalImageData) {
-                    memcpy(_originalImageData, [d bytes], _originalImageSize);
-                    logger_log("Loaded overlay from: %s", [pathStr UTF8String]);
-                    break;
-                }
-            }
-        }
+- (BOOL)loadOverlay {
+    int max_w = 0;
+    int max_h = 0;
+    [self getMaxWidth:&max_w height:&max_h];
+    return [self loadOverlayWithMaxWidth:max_w height:max_h config:_config];
+}
 
-        if (!_originalImageData) {
-            int size;
-            const unsigned char *data = get_default_keymap(&size);
-            if (data && size > 0) {
-                _originalImageData = malloc(size);
-                if (_originalImageData) {
-                    memcpy(_originalImageData, data, size);
-                    _originalImageSize = size;
-                    logger_log("Using embedded keymap (build-time)");
-                }
-            }
-        }
+- (void)prepareOverlayInBackground {
+    if (_loadGroup) return;
+    int max_w = 0;
+    int max_h = 0;
+    [self getMaxWidth:&max_w height:&max_h];
+    /* updateConfig: may replace _config while the block runs: build from a
+       copy taken now; a size change made meanwhile differs from the recorded
+       size, so reloadOverlayIfNeeded builds it */
+    Config config = _config;
+    _loadGroup = dispatch_group_create();
+    dispatch_group_async(_loadGroup, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        self->_loadResult = [self loadOverlayWithMaxWidth:max_w height:max_h config:config];
+    });
+}
+
+- (BOOL)waitForOverlay {
+    if (_loadGroup) {
+        dispatch_group_wait(_loadGroup, DISPATCH_TIME_FOREVER);
+        _loadGroup = nil;
     }
+    return _loadResult;
+}
 
-    if (!_originalImageData || _originalImageSize <= 0) {
-        logger_log("Failed to load overlay image");
-        return NO;
+- (BOOL)loadOverlayWithMaxWidth:(int)max_w height:(int)max_h config:(Config)config {
+    /* A decoded source needs nothing more from the file */
+    if (!_source.pixels && !_originalImage.data) {
+        /* Try multiple locations for a keymap.json layout, then keymap.bundle
+           (keymap_predecode --bundle), keymap.qoi (keymap_predecode --qoi) and
+           keymap.png, then the embedded keymap */
+        NSString *bundleLayout = [[NSBundle mainBundle] pathForResource:@"keymap" ofType:@"json"];
+        NSString *bundlePath = [[NSBundle mainBundle] pathForResource:@"keymap" ofType:@"png"];
+        /* "" never opens: a missing bundle resource must not end the list */
+        const char *searchPaths[] = {
+            "keymap.json",
+            "assets/keymap.json",
+            "../assets/keymap.json",
+            bundleLayout ? [bundleLayout fileSystemRepresentation] : "",
+            "keymap.bundle",
+            "assets/keymap.bundle",
+            "../assets/keymap.bundle",
+            "keymap.qoi",
+            "assets/keymap.qoi",
+            "../assets/keymap.qoi",
+            "keymap.png",
+            "assets/keymap.png",
+            "../assets/keymap.png",
+            bundlePath ? [bundlePath fileSystemRepresentation] : NULL,
+            NULL
+        };
+
+        if (overlay_bytes_open(searchPaths, &_originalImage) != OVERLAY_OK) {
+            logger_log("Failed to load overlay image");
+            return NO;
+        }
+        switch (_originalImage.kind) {
+            case OVERLAY_BYTES_MAPPED:
+                logger_log("Mapped overlay image (%zu bytes)", _originalImage.size); break;
+            case OVERLAY_BYTES_EMBEDDED:
+                logger_log("Using embedded keymap (build-time)"); break;
+            default:
+                logger_log("Using embedded keymap (pre-decoded RGBA)"); break;
+        }
+        _sourceId = overlay_disk_cache_source_id(_originalImage.data, _originalImage.size);
     }
 
-    OverlayError result = load_overlay_mem(_originalImageData, _originalImageSize,
-                                           max_w, max_h, &_overlay);
+    /* Warm start: resized pixels from a previous run, no decode or resize */
+    const char *cacheDir = get_default_cache_dir();
+    overlay_set_resize_filter((OverlayResizeFilter)config.resize_filter);
+    uint64_t cacheKey = overlay_disk_cache_key(_sourceId, max_w, max_h, overlay_get_resize_filter());
+    BOOL cached = overlay_disk_cache_load(cacheDir, cacheKey, &_overlay) == OVERLAY_OK;
+
+    OverlayError result = OVERLAY_OK;
+    BOOL isLayout = overlay_layout_detect(_originalImage.data, _originalImage.size);
+    BOOL isBundle = overlay_bundle_detect(_originalImage.data, _originalImage.size);
+    if (!cached && isLayout) {
+        /* Rasterized straight at the target size: no source, no resize */
+        OverlayLayout *layout = NULL;
+        result = overlay_layout_parse((const char *)_originalImage.data, _originalImage.size, &layout);
+        if (result == OVERLAY_OK) {
+            result = overlay_layout_render(layout, max_w, max_h, &_overlay);
+            overlay_layout_free(layout);
+        }
+    } else if (!cached && isBundle) {
+        /* Decodes only the pre-rendered size nearest the target */
+        result = load_overlay_mem(_originalImage.data, (int)_originalImage.size, max_w, max_h, &_overlay);
+    } else if (!cached && !_source.pixels) {
+        result = _originalImage.kind == OVERLAY_BYTES_EMBEDDED_RGBA
+            ? overlay_source_wrap(_originalImage.data, _originalImage.width,
+                                  _originalImage.height, &_source)
+            : overlay_source_load_mem(_originalImage.data, (int)_originalImage.size, &_source);
+        /* Optional: without the pyramid every resize reads the full source */
+        if (result == OVERLAY_OK && overlay_source_build_mips(&_source) != OVERLAY_OK) {
+            logger_log("Mip pyramid incomplete; resizing from the full source");
+        }
+    }
+    if (!cached && !isLayout && !isBundle && result == OVERLAY_OK) {
+        result = overlay_from_source(&_source, max_w, max_h, &_overlay);
+    }
 
     if (result != OVERLAY_OK) {
         logger_log("Failed to process overlay: %d", result);
+        [self releaseSourceLean:config.memory_lean];
         return NO;
     }
 
-    apply_effects(&_overlay, _config.opacity, _config.invert);
-    _lastScale = _config.scale;
-    _lastCustomWidth = _config.custom_width_px;
-    _lastCustomHeight = _config.custom_height_px;
-    _lastUseCustom = _config.use_custom_size;
+    if (cached) {
+        logger_log("Overlay pixels loaded from cache");
+    } else if (overlay_disk_cache_store(cacheDir, cacheKey, &_overlay) == OVERLAY_OK) {
+        overlay_disk_cache_evict(cacheDir, OVERLAY_DISK_CACHE_MAX_BYTES, &cacheKey);
+    }
+    apply_effects(&_overlay, _presenterOpacity ? 1.0f : config.opacity, config.invert);
+    [self releaseSourceLean:config.memory_lean];
+    _lastScale = config.scale;
+    _lastCustomWidth = config.custom_width_px;
+    _lastCustomHeight = config.custom_height_px;
+    _lastUseCustom = config.use_custom_size;
 
     return YES;
 }
@@ -118,7 +190,9 @@
         _config.custom_width_px == _lastCustomWidth &&
         _config.custom_height_px == _lastCustomHeight &&
         _config.use_custom_size == _lastUseCustom) {
-        return YES; /* No changes needed */
+        /* Same size: effect changes are one pass from the pristine base */
+        apply_effects(&_overlay, [self pixelOpacity], _config.invert);
+        return YES;
     }
 
     _lastScale = _config.scale;
@@ -146,4 +220,29 @@
     _config = newConfig;
 }
 
+- (void)setPresenterOpacity:(BOOL)enabled {
+    _presenterOpacity = enabled;
+}
+
+/* The file is only read while building, so it is unmapped afterwards: a
+   mapped file truncated in place faults on the next read. The decoded
+   source and _sourceId cover later size changes; layouts and bundles map
+   the file again. Memory-lean mode drops the decoded source too, which
+   the next size change decodes again. */
+- (void)releaseSourceLean:(BOOL)lean {
+    size_t saved = 0;
+    if (lean) {
+        saved = overlay_source_heap_bytes(&_source);
+        if (_originalImage.kind == OVERLAY_BYTES_MAPPED) saved += _originalImage.size;
+        overlay_source_free(&_source);
+    }
+    overlay_bytes_release(&_originalImage);
+    if (saved > 0) logger_log("Memory-lean: released %zu bytes of source image", saved);
+}
+
+/* Opacity baked into the pixels; 1.0 when the window applies it instead */
+- (float)pixelOpacity {
+    return _presenterOpacity ? 1.0f : _config.opacity;
+}
+
 @end
@@ -13,6 +13,8 @@
     MenuController *_menuController;
     HotkeyManager *_hotkeyManager;
     ImageManager *_imageManager;
+    CFAbsoluteTime _startTime;
+    int _overlayReady; /* 1 = window built, -1 = loading failed */
 }
 @end
 
@@ -38,6 +40,7 @@ static OSStatus CarbonHotkeyHandler(EventHandlerCallRef nextHandler, EventRef th
 @implementation AppDelegate
 
 - (void)applicationDidFinishLaunching:(NSNotification *)notification {
+    _startTime = CFAbsoluteTimeGetCurrent();
     _config = get_default_config();
     /* Load persisted config if present (overrides defaults) */
     load_config(&_config, NULL);
@@ -54,11 +57,26 @@ static OSStatus CarbonHotkeyHandler(EventHandlerCallRef nextHandler, EventRef th
         [self toggleOverlay];
     }];
 
-    // Load and setup overlay
-    if ([_imageManager loadOverlay]) {
-        [_windowManager createOverlayWindow];
+    /* The panel composites opacity itself; keep it out of the pixels so the
+       opacity is never applied twice and changing it never reprocesses them */
+    [_imageManager setPresenterOpacity:[_windowManager appliesGlobalAlpha]];
+
+    /* Load and setup overlay: in lazy mode decode and resize in the
+       background while the status item and hotkey come up */
+    BOOL loaded = YES;
+    if (_config.lazy_load) {
+        [_imageManager prepareOverlayInBackground];
+    } else {
+        loaded = [_imageManager loadOverlay];
+        if (loaded) {
+            [_windowManager createOverlayWindow];
+            _overlayReady = 1;
+        }
+    }
+    if (loaded) {
         [_hotkeyManager registerHotkey];
         [_menuController setupStatusItem];
+        logger_log("Time to tray and hotkey: %.1f ms", [self msSinceStart]);
     }
 
     /* Use Regular activation policy to allow global hotkey monitoring.
@@ -66,8 +84,33 @@ static OSStatus CarbonHotkeyHandler(EventHandlerCallRef nextHandler, EventRef th
     [NSApp setActivationPolicy:NSApplicationActivationPolicyRegular];
 }
 
+- (double)msSinceStart {
+    return (CFAbsoluteTimeGetCurrent() - _startTime) * 1000.0;
+}
+
+/* Lazy mode: the first show finishes the background load and builds the
+   window; later calls return at once */
+- (BOOL)ensureOverlayReady {
+    if (_overlayReady) return _overlayReady > 0;
+
+    double waitStart = [self msSinceStart];
+    if (![_imageManager waitForOverlay]) {
+        logger_log("Failed to load overlay image");
+        _overlayReady = -1;
+        return NO;
+    }
+    [_windowManager createOverlayWindow];
+    _overlayReady = 1;
+    double now = [self msSinceStart];
+    logger_log("Time to first show: %.1f ms (%.1f ms waiting on the overlay)",
+               now, now - waitStart);
+    return YES;
+}
+
 - (void)toggleOverlay {
-    [_windowManager toggleOverlay];
+    if ([_windowManager isVisible] || [self ensureOverlayReady]) {
+        [_windowManager toggleOverlay];
+    }
 }
 
 - (BOOL)applicationShouldTerminateAfterLastWindowClosed:(NSApplication *)sender {
@@ -86,7 +129,7 @@ static OSStatus CarbonHotkeyHandler(EventHandlerCallRef nextHandler, EventRef th
 
 // Stub implementations for header-declared methods
 - (void)showOverlay {
-    [_windowManager showOverlay];
+    if ([self ensureOverlayReady]) [_windowManager showOverlay];
 }
 
 - (void)hideOverlay {
@@ -102,6 +145,7 @@ static OSStatus CarbonHotkeyHandler(EventHandlerCallRef nextHandler, EventRef th
 }
 
 - (void)previewKeymap:(id)sender {
+    if (![self ensureOverlayReady]) return;
     [_windowManager showOverlay];
     dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(3.0 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
         [_windowManager hideOverlay];
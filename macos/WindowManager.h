@@ -11,6 +11,9 @@
 - (void)updateOverlayImage;
 - (void)reloadOverlayIfNeeded;
 - (BOOL)isVisible;
+/* YES: opacity is applied with setAlphaValue: (OVERLAY_WINDOW_CAP_GLOBAL_ALPHA),
+   so pixel passes should leave alpha alone */
+- (BOOL)appliesGlobalAlpha;
 - (void)updateConfig:(Config)newConfig;
 - (void)cleanup;
 
@@ -71,7 +71,8 @@
         return NO;
     }
 
-    apply_effects(&_overlay, _config.opacity, _config.invert);
+    /* Opacity is the panel's alpha value; only invert touches pixels */
+    apply_effects(&_overlay, 1.0f, _config.invert);
     _lastScale = _config.scale;
     _lastCustomWidth = _config.custom_width_px;
     _lastCustomHeight = _config.custom_height_px;
@@ -199,31 +200,27 @@
         return;
     }
 
-    /* Copy original pixels into preview buffer and apply effects to the copy */
-    memcpy(_previewBuffer, _overlay.data, pixelCount);
-    Overlay tmp;
-    tmp.data = _previewBuffer;
-    tmp.width = _overlay.width;
-    tmp.height = _overlay.height;
-    tmp.channels = _overlay.channels;
-    tmp.cached_effects = 0;
-    tmp.cached_opacity = 0.0f;
-    tmp.cached_invert = 0;
-
-    apply_effects(&tmp, _config.opacity, _config.invert);
+    /* _overlay already carries invert and opacity is the panel's alpha value,
+       so this pass only premultiplies: NSBitmapImageRep treats alpha as
+       premultiplied unless told otherwise */
+    if (!apply_effects_format(&_overlay, _previewBuffer, 1.0f, 0,
+                              OVERLAY_FORMAT_RGBA_PREMUL)) {
+        logger_log("Failed to apply effects to preview buffer");
+        return;
+    }
 
     /* Create NSImage from preview buffer */
     unsigned char *planes[1] = { _previewBuffer };
     NSBitmapImageRep *bitmap = [[NSBitmapImageRep alloc]
         initWithBitmapDataPlanes:planes
-                      pixelsWide:tmp.width
-                      pixelsHigh:tmp.height
+                      pixelsWide:_overlay.width
+                      pixelsHigh:_overlay.height
                    bitsPerSample:8
                  samplesPerPixel:4
                         hasAlpha:YES
                         isPlanar:NO
                   colorSpaceName:NSDeviceRGBColorSpace
-                     bytesPerRow:tmp.width * 4
+                     bytesPerRow:_overlay.width * 4
                     bitsPerPixel:32];
 
     NSImage *image = [[NSImage alloc] init];
@@ -232,7 +229,7 @@
     // Scale for screen
     NSScreen *screen = [NSScreen mainScreen];
     CGFloat scale = [screen backingScaleFactor];
-    [image setSize:NSMakeSize(tmp.width / scale, tmp.height / scale)];
+    [image setSize:NSMakeSize(_overlay.width / scale, _overlay.height / scale)];
 
     // Update window content
     [_imageView setImage:image];
@@ -263,7 +260,15 @@
     return _visible;
 }
 
+- (BOOL)appliesGlobalAlpha {
+    return YES;
+}
+
 - (void)updateConfig:(Config)newConfig {
+    /* Opacity changes are O(1): the compositor applies the panel alpha */
+    if (_panel && newConfig.opacity != _config.opacity) {
+        [_panel setAlphaValue:newConfig.opacity];
+    }
     _config = newConfig;
 }
 
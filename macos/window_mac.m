@@ -92,6 +92,13 @@ void set_overlay_opacity(OverlayWindow* window, float opacity) {
     [window->window setAlphaValue:opacity];
 }
 
+/* shared/window.h is not imported here: its OverlayWindow typedef collides
+   with the panel class, so the flag value is spelled out */
+int get_overlay_window_caps(OverlayWindow* window) {
+    (void)window;
+    return 0x1; /* OVERLAY_WINDOW_CAP_GLOBAL_ALPHA: setAlphaValue: is composited */
+}
+
 void set_overlay_click_through(OverlayWindow* window, int enabled) {
     if (!window || !window->window) return;
 
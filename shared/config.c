@@ -69,6 +69,26 @@ const char *get_default_config_path(void) {
     return path;
 }
 
+const char *get_default_cache_dir(void) {
+    static char dir[PATH_MAX];
+    strncpy(dir, get_default_config_path(), sizeof(dir) - 1);
+    dir[sizeof(dir) - 1] = '\0';
+    char *p = strrchr(dir, '/');
+#ifdef _WIN32
+    char *q = strrchr(dir, '\\');
+    if (!p || (q && q > p)) p = q;
+    const char *name = "\\cache";
+#else
+    const char *name = "/cache";
+#endif
+    if (!p) {
+        snprintf(dir, sizeof(dir), "%s", name + 1);
+        return dir;
+    }
+    snprintf(p, sizeof(dir) - (size_t)(p - dir), "%s", name);
+    return dir;
+}
+
 /* Internal helpers to parse a simple JSON file (non-robust but sufficient for small config) */
 
 static const char *find_colon_after_key(const char *buf, const char *key) {
@@ -171,6 +191,9 @@ int load_config(Config *out, const char *path) {
     if (parse_int_field(buf, "\"click_through\"", &out->click_through)) any = 1;
     if (parse_int_field(buf, "\"always_on_top\"", &out->always_on_top)) any = 1;
     if (parse_int_field(buf, "\"monitor_index\"", &out->monitor_index)) any = 1;
+    if (parse_int_field(buf, "\"resize_filter\"", &out->resize_filter)) any = 1;
+    if (parse_int_field(buf, "\"lazy_load\"", &out->lazy_load)) any = 1;
+    if (parse_int_field(buf, "\"memory_lean\"", &out->memory_lean)) any = 1;
 
     /* Clamp sensible ranges */
     if (out->auto_hide < 0.0f) out->auto_hide = 0.0f;
@@ -178,6 +201,7 @@ int load_config(Config *out, const char *path) {
     if (out->scale < 0.5f) out->scale = 0.5f;
     if (out->scale > 2.0f) out->scale = 2.0f;
     if (out->monitor_index < 0) out->monitor_index = 0;
+    if (out->resize_filter < 0 || out->resize_filter > 4) out->resize_filter = 0;
 
     free(buf);
     return any ? 1 : 0;
@@ -208,7 +232,10 @@ int save_config(const Config *cfg, const char *path) {
         "  \"start_at_login\": %d,\n"
         "  \"click_through\": %d,\n"
         "  \"always_on_top\": %d,\n"
-        "  \"monitor_index\": %d\n"
+        "  \"monitor_index\": %d,\n"
+        "  \"resize_filter\": %d,\n"
+        "  \"lazy_load\": %d,\n"
+        "  \"memory_lean\": %d\n"
         "}\n",
         cfg->opacity,
         cfg->invert ? 1 : 0,
@@ -224,7 +251,10 @@ int save_config(const Config *cfg, const char *path) {
         cfg->start_at_login ? 1 : 0,
         cfg->click_through ? 1 : 0,
         cfg->always_on_top ? 1 : 0,
-        cfg->monitor_index
+        cfg->monitor_index,
+        cfg->resize_filter,
+        cfg->lazy_load ? 1 : 0,
+        cfg->memory_lean ? 1 : 0
     );
     fflush(f);
     fclose(f);
@@ -28,6 +28,22 @@ typedef struct {
     int click_through;     /* 0 = false, 1 = true (maps to setIgnoresMouseEvents:) */
     int always_on_top;     /* 0 = false, 1 = true (may map to window level) */
     int monitor_index;     /* 0 = primary monitor */
+
+    /* Resampling quality vs. speed (OverlayResizeFilter): 0 = auto
+       (Mitchell/Catmull-Rom), 1 = box, 2 = bilinear, 3 = Catmull-Rom,
+       4 = Lanczos3. Not exposed in the UI; set per deployment. */
+    int resize_filter;
+
+    /* 1 = bring up the tray and hotkey first and prepare the overlay on a
+       background thread (the first show waits for what is left); 0 = load
+       it before anything else, failing startup if it cannot be loaded */
+    int lazy_load;
+
+    /* 1 = once the overlay pixels exist, release the decoded source image
+       too (the mapping always is) and decode it again only when a reload
+       needs it; saves resident memory at the cost of a decode per size
+       change */
+    int memory_lean;
 } Config;
 
 /* Get default configuration */
@@ -51,6 +67,9 @@ static inline Config get_default_config(void) {
     config.click_through = 0;
     config.always_on_top = 0;
     config.monitor_index = 0;
+    config.resize_filter = 0;
+    config.lazy_load = 1;
+    config.memory_lean = 0;
 
 #ifdef _WIN32
     /* default hotkey */
@@ -76,6 +95,10 @@ int save_config(const Config *cfg, const char *path);
 /* Helper to get platform default config path (returns static string) */
 const char *get_default_config_path(void);
 
+/* Directory for the processed-overlay disk cache, next to the config file
+   (returns static string; not created until the first cache write) */
+const char *get_default_cache_dir(void);
+
 #ifdef __cplusplus
 }
 #endif
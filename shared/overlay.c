@@ -1,17 +1,27 @@
 #define STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_RESIZE_IMPLEMENTATION
 #include "stb_image.h"
-#include "stb_image_resize.h"
 #include "overlay.h"
+#include "overlay_simd.h"
+#include "overlay_parallel.h"
+#include "overlay_effects.h"
+#include "overlay_lut3d.h"
+#include "overlay_mip.h"
+#include "overlay_png.h"
+#include "overlay_qoi.h"
+#include "overlay_resample.h"
+#include "overlay_bytes.h"
+#include "overlay_bundle.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <limits.h>
 #ifdef _WIN32
 #include <windows.h>
 #include <process.h>
 #else
 #include <pthread.h>
+#include <time.h>
 #endif
 
 const unsigned char *get_default_keymap(int *size) {
@@ -27,6 +37,20 @@ const unsigned char *get_default_keymap(int *size) {
 #endif
 }
 
+const unsigned char *get_default_keymap_rgba(int *width, int *height) {
+#ifdef EMBED_KEYMAP_RGBA
+    /* Pixels decoded by keymap_predecode at build time */
+    #include "keymap_rgba_embedded.h"
+    if (width) *width = embedded_keymap_rgba_width;
+    if (height) *height = embedded_keymap_rgba_height;
+    return embedded_keymap_rgba;
+#else
+    if (width) *width = 0;
+    if (height) *height = 0;
+    return NULL;
+#endif
+}
+
 /* Consistent memory allocation wrapper */
 static void* overlay_alloc(size_t size) {
     return malloc(size);
@@ -36,13 +60,75 @@ static void overlay_free(void* ptr) {
     if (ptr) free(ptr);
 }
 
-static OverlayError finalize_image(unsigned char *data, int width, int height,
-                                   int max_width, int max_height, Overlay *out) {
-    if (!data || !out) {
-        overlay_free(data);
-        return OVERLAY_ERROR_NULL_PARAM;
+/* Fit width x height inside max_width x max_height keeping the aspect ratio.
+   Returns 1 if that needs a resample, 0 if the size is unchanged. */
+static int fit_size(int width, int height, int max_width, int max_height,
+                    int *out_w, int *out_h) {
+    float scale_w = (float)max_width / (float)width;
+    float scale_h = (float)max_height / (float)height;
+    float scale = (scale_w < scale_h) ? scale_w : scale_h;
+
+    *out_w = width;
+    *out_h = height;
+    if (scale == 1.0f) return 0;
+
+    int new_w = (int)roundf(width * scale);
+    int new_h = (int)roundf(height * scale);
+    if (new_w < 1) new_w = 1;
+    if (new_h < 1) new_h = 1;
+    *out_w = new_w;
+    *out_h = new_h;
+    return 1;
+}
+
+typedef struct {
+    const OverlayResamplePlan *plan;
+    const unsigned char *src;
+    unsigned char *dst;
+    volatile int failed;
+} ResizeBandJob;
+
+/* Output rows [begin, end) of the full resize; bands share the plan's
+   weight tables, so any split gives the single-threaded pixels */
+static void resize_band(void *ctx, int begin, int end) {
+    ResizeBandJob *job = (ResizeBandJob *)ctx;
+    if (!overlay_resample_rows(job->plan, job->src, job->dst, begin, end)) job->failed = 1;
+}
+
+/* Resample RGBA pixels into a newly allocated new_w x new_h buffer with the
+   current resize filter. Large resizes split the output rows across worker
+   threads. */
+static OverlayError resample_pixels(const unsigned char *pixels, int width, int height,
+                                    int new_w, int new_h, unsigned char **out) {
+    OverlayResamplePlan *plan = overlay_resample_plan_create(width, height, new_w, new_h,
+                                                             overlay_get_resize_filter());
+    unsigned char *resized = overlay_alloc((size_t)new_w * new_h * 4);
+    if (!plan || !resized) {
+        overlay_resample_plan_free(plan);
+        overlay_free(resized);
+        return OVERLAY_ERROR_OUT_OF_MEMORY;
+    }
+
+    ResizeBandJob job;
+    job.plan = plan;
+    job.src = pixels;
+    job.dst = resized;
+    job.failed = 0;
+    size_t work = (size_t)width * height > (size_t)new_w * new_h
+                      ? (size_t)width * height : (size_t)new_w * new_h;
+    overlay_parallel_rows(new_h, work, resize_band, &job);
+    overlay_resample_plan_free(plan);
+
+    if (job.failed) {
+        overlay_free(resized);
+        return OVERLAY_ERROR_RESIZE_FAILED;
     }
+    *out = resized;
+    return OVERLAY_OK;
+}
 
+/* Take ownership of data as a fresh overlay with no effects applied */
+static void init_overlay(Overlay *out, unsigned char *data, int width, int height) {
     out->width = width;
     out->height = height;
     out->channels = 4;
@@ -50,113 +136,1205 @@ static OverlayError finalize_image(unsigned char *data, int width, int height,
     out->cached_opacity = 1.0f;
     out->cached_invert = 0;
 
-    float scale_w = (float)max_width / (float)width;
-    float scale_h = (float)max_height / (float)height;
-    float scale = (scale_w < scale_h) ? scale_w : scale_h;
+    /* No effects yet: data is a view of the pristine base */
+    out->base = data;
+    out->data = data;
+    out->base_owner = NULL;
+    out->base_release = NULL;
+    out->base_generation = 0;
+    out->derived_generation = 0;
+    /* Everything is new to a presenter */
+    out->dirty_count = 0;
+    out->effects_dirty_count = 0;
+    overlay_mark_dirty(out, 0, 0, out->width, out->height);
+}
 
-    if (scale != 1.0f) {
-        int new_w = (int)roundf(width * scale);
-        int new_h = (int)roundf(height * scale);
-        if (new_w < 1) new_w = 1;
-        if (new_h < 1) new_h = 1;
+static OverlayError finalize_image(unsigned char *data, int width, int height,
+                                   int max_width, int max_height, Overlay *out) {
+    if (!data || !out) {
+        overlay_free(data);
+        return OVERLAY_ERROR_NULL_PARAM;
+    }
 
-        unsigned char *resized = overlay_alloc((size_t)new_w * new_h * 4);
-        if (!resized) {
-            overlay_free(data);
-            return OVERLAY_ERROR_OUT_OF_MEMORY;
+    int new_w, new_h;
+    if (fit_size(width, height, max_width, max_height, &new_w, &new_h)) {
+        unsigned char *resized = NULL;
+        OverlayError err = resample_pixels(data, width, height, new_w, new_h, &resized);
+        overlay_free(data);
+        if (err != OVERLAY_OK) return err;
+        data = resized;
+    }
+
+    init_overlay(out, data, new_w, new_h);
+    return OVERLAY_OK;
+}
+
+/* Streaming decode: PNG and QOI rows go straight from the decoder into the
+   resampler, so the full-size image never exists in memory. Large images
+   decode on a helper thread while the calling thread resamples, with a
+   small ring of rows between the two. */
+#define STREAM_RING_ROWS 16
+
+/* Whichever row-at-a-time decoder recognised the bytes */
+typedef struct {
+    OverlayPngStream *png;
+    OverlayQoiStream *qoi;
+    int width;
+    int height;
+} RowDecoder;
+
+/* Formats are told apart by their magic bytes. Returns 0 when neither
+   streaming decoder takes the data. */
+static int row_decoder_open(const unsigned char *data, size_t len, RowDecoder *dec) {
+    memset(dec, 0, sizeof(*dec));
+    dec->qoi = overlay_qoi_open(data, len);
+    if (dec->qoi) {
+        overlay_qoi_size(dec->qoi, &dec->width, &dec->height);
+        return 1;
+    }
+    dec->png = overlay_png_open(data, len);
+    if (dec->png) {
+        overlay_png_size(dec->png, &dec->width, &dec->height);
+        return 1;
+    }
+    return 0;
+}
+
+static int row_decoder_read(RowDecoder *dec, unsigned char *rgba) {
+    return dec->qoi ? overlay_qoi_read_row(dec->qoi, rgba) : overlay_png_read_row(dec->png, rgba);
+}
+
+static void row_decoder_close(RowDecoder *dec) {
+    if (dec->qoi) overlay_qoi_close(dec->qoi);
+    if (dec->png) overlay_png_close(dec->png);
+    memset(dec, 0, sizeof(*dec));
+}
+
+/* Condition variables for the stream pipe and asynchronous loads */
+#ifdef _WIN32
+typedef CONDITION_VARIABLE overlay_cond_t;
+#else
+typedef pthread_cond_t overlay_cond_t;
+#endif
+
+static void overlay_cond_init(overlay_cond_t *cond) {
+#ifdef _WIN32
+    InitializeConditionVariable(cond);
+#else
+    pthread_cond_init(cond, NULL);
+#endif
+}
+
+static void overlay_cond_wait(overlay_cond_t *cond, overlay_mutex_t *mutex) {
+#ifdef _WIN32
+    SleepConditionVariableCS(cond, mutex, INFINITE);
+#else
+    pthread_cond_wait(cond, mutex);
+#endif
+}
+
+static void overlay_cond_signal(overlay_cond_t *cond) {
+#ifdef _WIN32
+    WakeConditionVariable(cond);
+#else
+    pthread_cond_signal(cond);
+#endif
+}
+
+static void overlay_cond_broadcast(overlay_cond_t *cond) {
+#ifdef _WIN32
+    WakeAllConditionVariable(cond);
+#else
+    pthread_cond_broadcast(cond);
+#endif
+}
+
+static void overlay_cond_destroy(overlay_cond_t *cond) {
+#ifdef _WIN32
+    (void)cond; /* Win32 condition variables need no cleanup */
+#else
+    pthread_cond_destroy(cond);
+#endif
+}
+
+typedef struct {
+    RowDecoder *dec;
+    int height;
+    size_t stride;
+    unsigned char *rows; /* STREAM_RING_ROWS rows of stride bytes */
+    int produced;        /* rows decoded into the ring */
+    int consumed;        /* rows the resampler is done with */
+    int failed;          /* decode error, or the load was cancelled */
+    const volatile int *cancel;
+    overlay_mutex_t lock;
+    overlay_cond_t row_ready;
+    overlay_cond_t slot_free;
+} StreamPipe;
+
+/* Producer: a slot is the decoder's from the moment it is free until
+   produced moves past it, so decoding itself runs unlocked */
+static void stream_decode_rows(StreamPipe *p) {
+    for (int y = 0; y < p->height; y++) {
+        overlay_mutex_lock(&p->lock);
+        while (p->produced - p->consumed == STREAM_RING_ROWS && !p->failed) {
+            overlay_cond_wait(&p->slot_free, &p->lock);
+        }
+        int stop = p->failed;
+        overlay_mutex_unlock(&p->lock);
+        if (stop) return;
+
+        int ok = row_decoder_read(p->dec, p->rows + (size_t)(y % STREAM_RING_ROWS) * p->stride);
+
+        overlay_mutex_lock(&p->lock);
+        if (ok) p->produced++;
+        else p->failed = 1;
+        overlay_cond_signal(&p->row_ready);
+        overlay_mutex_unlock(&p->lock);
+        if (!ok) return;
+    }
+}
+
+#ifdef _WIN32
+static unsigned __stdcall stream_decode_thread(void *param) {
+    stream_decode_rows((StreamPipe *)param);
+    return 0;
+}
+#else
+static void *stream_decode_thread(void *param) {
+    stream_decode_rows((StreamPipe *)param);
+    return NULL;
+}
+#endif
+
+/* Consumer side of the pipe. Returns 1 once every row went through. */
+static int stream_resample_rows(StreamPipe *p, OverlayResampler *r) {
+    for (int y = 0; y < p->height; y++) {
+        overlay_mutex_lock(&p->lock);
+        if (p->cancel && *p->cancel) {
+            /* Stop the decoder too */
+            p->failed = 1;
+            overlay_cond_signal(&p->slot_free);
+        }
+        while (p->produced == y && !p->failed) {
+            overlay_cond_wait(&p->row_ready, &p->lock);
         }
+        int have = p->produced > y;
+        overlay_mutex_unlock(&p->lock);
+        if (!have) return 0;
+
+        overlay_resampler_push_row(r, p->rows + (size_t)(y % STREAM_RING_ROWS) * p->stride);
 
-        if (!stbir_resize_uint8(data, width, height, 0,
-                                resized, new_w, new_h, 0, 4)) {
-            overlay_free(resized);
+        overlay_mutex_lock(&p->lock);
+        p->consumed++;
+        overlay_cond_signal(&p->slot_free);
+        overlay_mutex_unlock(&p->lock);
+    }
+    return 1;
+}
+
+/* Decode and resample on separate threads. Returns 1 on success; falls back
+   to the calling thread if the decoder thread cannot be started. */
+static int stream_pipelined(RowDecoder *dec, int width, int height, OverlayResampler *r,
+                            const volatile int *cancel) {
+    StreamPipe p;
+    memset(&p, 0, sizeof(p));
+    p.dec = dec;
+    p.cancel = cancel;
+    p.height = height;
+    p.stride = (size_t)width * 4;
+    p.rows = overlay_alloc(p.stride * STREAM_RING_ROWS);
+    if (!p.rows) return 0;
+    overlay_mutex_init(&p.lock);
+    overlay_cond_init(&p.row_ready);
+    overlay_cond_init(&p.slot_free);
+
+    int ok;
+#ifdef _WIN32
+    HANDLE thread = (HANDLE)_beginthreadex(NULL, 0, stream_decode_thread, &p, 0, NULL);
+    if (thread) {
+        ok = stream_resample_rows(&p, r);
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+    }
+#else
+    pthread_t thread;
+    int started = pthread_create(&thread, NULL, stream_decode_thread, &p) == 0;
+    if (started) {
+        ok = stream_resample_rows(&p, r);
+        pthread_join(thread, NULL);
+    }
+#endif
+    else {
+        /* No thread: the ring still works as a one-row scratch buffer */
+        ok = 1;
+        for (int y = 0; y < height && ok; y++) {
+            ok = !(cancel && *cancel) && row_decoder_read(dec, p.rows);
+            if (ok) overlay_resampler_push_row(r, p.rows);
+        }
+    }
+
+    overlay_cond_destroy(&p.slot_free);
+    overlay_cond_destroy(&p.row_ready);
+    overlay_mutex_destroy(&p.lock);
+    overlay_free(p.rows);
+    return ok;
+}
+
+/* Decode straight into an overlay of the fitted size */
+/* cancel (may be NULL) is polled between rows */
+static OverlayError stream_rows(RowDecoder *dec, int max_width, int max_height,
+                                const volatile int *cancel, Overlay *out) {
+    int width = dec->width, height = dec->height, new_w, new_h;
+    int resize = fit_size(width, height, max_width, max_height, &new_w, &new_h);
+
+    unsigned char *data = overlay_alloc((size_t)new_w * new_h * 4);
+    if (!data) return OVERLAY_ERROR_OUT_OF_MEMORY;
+
+    int ok = 1;
+    if (!resize) {
+        for (int y = 0; y < height && ok; y++) {
+            ok = !(cancel && *cancel) && row_decoder_read(dec, data + (size_t)y * width * 4);
+        }
+    } else {
+        OverlayResampler *r = overlay_resampler_create(width, height, data, new_w, new_h,
+                                                       overlay_get_resize_filter());
+        if (!r) {
             overlay_free(data);
-            return OVERLAY_ERROR_RESIZE_FAILED;
+            return OVERLAY_ERROR_OUT_OF_MEMORY;
+        }
+        if (overlay_get_thread_count() > 1 &&
+            (size_t)width * height >= overlay_get_parallel_threshold()) {
+            ok = stream_pipelined(dec, width, height, r, cancel);
+        } else {
+            unsigned char *row = overlay_alloc((size_t)width * 4);
+            ok = row != NULL;
+            for (int y = 0; y < height && ok; y++) {
+                ok = !(cancel && *cancel) && row_decoder_read(dec, row);
+                if (ok) overlay_resampler_push_row(r, row);
+            }
+            overlay_free(row);
         }
+        overlay_resampler_destroy(r);
+    }
 
+    if (!ok) {
         overlay_free(data);
-        data = resized;
-        out->width = new_w;
-        out->height = new_h;
+        return cancel && *cancel ? OVERLAY_ERROR_CANCELLED : OVERLAY_ERROR_DECODE_FAILED;
     }
-
-    out->data = data;
+    init_overlay(out, data, new_w, new_h);
     return OVERLAY_OK;
 }
 
-OverlayError load_overlay(const char *path, int max_width, int max_height, Overlay *out) {
-    if (!path || !out) return OVERLAY_ERROR_NULL_PARAM;
+/* One encoded image: PNG and QOI stream, anything else goes through stb */
+static OverlayError load_encoded(const unsigned char *buffer, int len, int max_width,
+                                 int max_height, const volatile int *cancel, Overlay *out) {
+    RowDecoder dec;
+    if (len > 0 && row_decoder_open(buffer, (size_t)len, &dec)) {
+        OverlayError err = stream_rows(&dec, max_width, max_height, cancel, out);
+        row_decoder_close(&dec);
+        return err;
+    }
+    
+    int w, h, channels;
+    unsigned char *data = stbi_load_from_memory(buffer, len, &w, &h, &channels, 4);
+    if (!data) return OVERLAY_ERROR_DECODE_FAILED;
+    if (cancel && *cancel) {
+        overlay_free(data);
+        return OVERLAY_ERROR_CANCELLED;
+    }
     
+    return finalize_image(data, w, h, max_width, max_height, out);
+}
+
+/* Decode only the variant nearest the target; an exact one skips the
+   resize entirely */
+static OverlayError load_bundle(const unsigned char *data, size_t len, int max_width,
+                                int max_height, const volatile int *cancel, Overlay *out) {
+    OverlayBundleVariant v;
+    int index = overlay_bundle_select(data, len, max_width, max_height);
+    if (index < 0 || overlay_bundle_variant(data, len, index, &v) != OVERLAY_OK ||
+        v.size > INT_MAX || overlay_bundle_detect(v.data, v.size)) {
+        return OVERLAY_ERROR_DECODE_FAILED;
+    }
+    return load_encoded(v.data, (int)v.size, max_width, max_height, cancel, out);
+}
+
+static OverlayError load_path(const char *path, int max_width, int max_height,
+                              const volatile int *cancel, Overlay *out) {
+    if (!path || !out) return OVERLAY_ERROR_NULL_PARAM;
+
+    /* Decode straight from the mapped file */
+    OverlayBytes bytes;
+    if (overlay_bytes_map(path, &bytes) == OVERLAY_OK) {
+        if (overlay_bundle_detect(bytes.data, bytes.size)) {
+            OverlayError err = load_bundle(bytes.data, bytes.size, max_width, max_height,
+                                           cancel, out);
+            overlay_bytes_release(&bytes);
+            return err;
+        }
+        RowDecoder dec;
+        if (row_decoder_open(bytes.data, bytes.size, &dec)) {
+            OverlayError err = stream_rows(&dec, max_width, max_height, cancel, out);
+            row_decoder_close(&dec);
+            overlay_bytes_release(&bytes);
+            return err;
+        }
+        overlay_bytes_release(&bytes);
+    }
+    if (cancel && *cancel) return OVERLAY_ERROR_CANCELLED;
+
+    /* Not a PNG or QOI the streaming decoders handle */
     int w, h, channels;
     unsigned char *data = stbi_load(path, &w, &h, &channels, 4);
     if (!data) return OVERLAY_ERROR_FILE_NOT_FOUND;
+    if (cancel && *cancel) {
+        overlay_free(data);
+        return OVERLAY_ERROR_CANCELLED;
+    }
     
     return finalize_image(data, w, h, max_width, max_height, out);
 }
 
-OverlayError load_overlay_mem(const unsigned char *buffer, int len, 
+static OverlayError load_mem(const unsigned char *buffer, int len, int max_width, int max_height,
+                             const volatile int *cancel, Overlay *out) {
+    if (!buffer || !out) return OVERLAY_ERROR_NULL_PARAM;
+    if (len > 0 && overlay_bundle_detect(buffer, (size_t)len)) {
+        return load_bundle(buffer, (size_t)len, max_width, max_height, cancel, out);
+    }
+    return load_encoded(buffer, len, max_width, max_height, cancel, out);
+}
+
+OverlayError load_overlay(const char *path, int max_width, int max_height, Overlay *out) {
+    return load_path(path, max_width, max_height, NULL, out);
+}
+
+OverlayError load_overlay_mem(const unsigned char *buffer, int len,
                               int max_width, int max_height, Overlay *out) {
+    return load_mem(buffer, len, max_width, max_height, NULL, out);
+}
+
+/* Asynchronous loads. The handle is shared by the caller and the loader
+   thread; the loader's reference lives until on_complete has run, wherever
+   the dispatcher sends it, so either side may let go first. */
+struct OverlayLoad {
+    char *path; /* copy; NULL for memory loads */
+    const unsigned char *buffer;
+    int len;
+    int max_width;
+    int max_height;
+    OverlayLoadCallbacks callbacks;
+    volatile int cancel;
+    int done;
+    int taken;
+    int refs;
+    OverlayError result;
+    Overlay overlay;
+    overlay_mutex_t lock;
+    overlay_cond_t finished;
+};
+
+static void load_release(OverlayLoad *load) {
+    overlay_mutex_lock(&load->lock);
+    int refs = --load->refs;
+    overlay_mutex_unlock(&load->lock);
+    if (refs > 0) return;
+
+    if (!load->taken) free_overlay(&load->overlay);
+    overlay_cond_destroy(&load->finished);
+    overlay_mutex_destroy(&load->lock);
+    overlay_free(load->path);
+    overlay_free(load);
+}
+
+static void load_deliver(void *arg) {
+    OverlayLoad *load = (OverlayLoad *)arg;
+    load->callbacks.on_complete(load, load->result, load->callbacks.user);
+    load_release(load);
+}
+
+static void load_run(OverlayLoad *load) {
+    Overlay overlay;
+    memset(&overlay, 0, sizeof(overlay));
+    OverlayError err = load->cancel ? OVERLAY_ERROR_CANCELLED
+                     : load->path
+                         ? load_path(load->path, load->max_width, load->max_height,
+                                     &load->cancel, &overlay)
+                         : load_mem(load->buffer, load->len, load->max_width,
+                                    load->max_height, &load->cancel, &overlay);
+
+    overlay_mutex_lock(&load->lock);
+    load->overlay = overlay;
+    load->result = err;
+    load->done = 1;
+    overlay_cond_broadcast(&load->finished);
+    overlay_mutex_unlock(&load->lock);
+
+    if (!load->callbacks.on_complete) {
+        load_release(load);
+    } else if (load->callbacks.dispatch) {
+        load->callbacks.dispatch(load_deliver, load, load->callbacks.dispatch_ctx);
+    } else {
+        load_deliver(load);
+    }
+}
+
+#ifdef _WIN32
+static unsigned __stdcall load_thread(void *param) {
+    load_run((OverlayLoad *)param);
+    return 0;
+}
+#else
+static void *load_thread(void *param) {
+    load_run((OverlayLoad *)param);
+    return NULL;
+}
+#endif
+
+static OverlayLoad *load_start(OverlayLoad *load, int max_width, int max_height,
+                               const OverlayLoadCallbacks *callbacks) {
+    load->max_width = max_width;
+    load->max_height = max_height;
+    if (callbacks) load->callbacks = *callbacks;
+    load->refs = 2; /* caller and loader */
+    overlay_mutex_init(&load->lock);
+    overlay_cond_init(&load->finished);
+
+#ifdef _WIN32
+    HANDLE h = (HANDLE)_beginthreadex(NULL, 0, load_thread, load, 0, NULL);
+    if (h) {
+        CloseHandle(h);
+        return load;
+    }
+#else
+    pthread_t thr;
+    if (pthread_create(&thr, NULL, load_thread, load) == 0) {
+        pthread_detach(thr);
+        return load;
+    }
+#endif
+
+    /* fallback to loading on the calling thread */
+    load_run(load);
+    return load;
+}
+
+OverlayLoad *load_overlay_async(const char *path, int max_width, int max_height,
+                                const OverlayLoadCallbacks *callbacks) {
+    if (!path) return NULL;
+    OverlayLoad *load = (OverlayLoad *)overlay_alloc(sizeof(OverlayLoad));
+    if (!load) return NULL;
+    memset(load, 0, sizeof(OverlayLoad));
+
+    size_t n = strlen(path) + 1;
+    load->path = (char *)overlay_alloc(n);
+    if (!load->path) {
+        overlay_free(load);
+        return NULL;
+    }
+    memcpy(load->path, path, n);
+    return load_start(load, max_width, max_height, callbacks);
+}
+
+OverlayLoad *load_overlay_mem_async(const unsigned char *buffer, int len,
+                                    int max_width, int max_height,
+                                    const OverlayLoadCallbacks *callbacks) {
+    if (!buffer) return NULL;
+    OverlayLoad *load = (OverlayLoad *)overlay_alloc(sizeof(OverlayLoad));
+    if (!load) return NULL;
+    memset(load, 0, sizeof(OverlayLoad));
+
+    load->buffer = buffer;
+    load->len = len;
+    return load_start(load, max_width, max_height, callbacks);
+}
+
+int overlay_load_poll(OverlayLoad *load) {
+    if (!load) return 0;
+    overlay_mutex_lock(&load->lock);
+    int done = load->done;
+    overlay_mutex_unlock(&load->lock);
+    return done;
+}
+
+int overlay_load_wait(OverlayLoad *load, int timeout_ms) {
+    if (!load) return 0;
+    overlay_mutex_lock(&load->lock);
+    if (timeout_ms < 0) {
+        while (!load->done) overlay_cond_wait(&load->finished, &load->lock);
+    } else {
+#ifdef _WIN32
+        ULONGLONG deadline = GetTickCount64() + (ULONGLONG)timeout_ms;
+        while (!load->done) {
+            ULONGLONG now = GetTickCount64();
+            if (now >= deadline) break;
+            SleepConditionVariableCS(&load->finished, &load->lock, (DWORD)(deadline - now));
+        }
+#else
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (!load->done) {
+            if (pthread_cond_timedwait(&load->finished, &load->lock, &deadline) != 0) break;
+        }
+#endif
+    }
+    int done = load->done;
+    overlay_mutex_unlock(&load->lock);
+    return done;
+}
+
+void overlay_load_cancel(OverlayLoad *load) {
+    if (load) load->cancel = 1;
+}
+
+OverlayError overlay_load_result(OverlayLoad *load, Overlay *out) {
+    if (!load || !out) return OVERLAY_ERROR_NULL_PARAM;
+    overlay_load_wait(load, -1);
+
+    overlay_mutex_lock(&load->lock);
+    OverlayError err = load->result;
+    if (err == OVERLAY_OK) {
+        if (load->taken) {
+            err = OVERLAY_ERROR_NULL_PARAM;
+        } else {
+            *out = load->overlay;
+            load->taken = 1;
+        }
+    }
+    overlay_mutex_unlock(&load->lock);
+    return err;
+}
+
+void overlay_load_free(OverlayLoad *load) {
+    if (!load) return;
+    load->cancel = 1;
+    load_release(load);
+}
+
+/* Whole-image decode for sources. QOI goes through its row decoder, which
+   is much faster than stb_image's PNG inflate; 1 when the data was QOI. */
+static int source_load_qoi(const unsigned char *data, size_t len, OverlaySource *out,
+                           OverlayError *err) {
+    OverlayQoiStream *qoi = overlay_qoi_open(data, len);
+    if (!qoi) return 0;
+    int width, height;
+    overlay_qoi_size(qoi, &width, &height);
+    unsigned char *pixels = overlay_alloc((size_t)width * height * 4);
+    int ok = pixels != NULL;
+    for (int y = 0; y < height && ok; y++) {
+        ok = overlay_qoi_read_row(qoi, pixels + (size_t)y * width * 4);
+    }
+    overlay_qoi_close(qoi);
+    if (!ok) {
+        *err = pixels ? OVERLAY_ERROR_DECODE_FAILED : OVERLAY_ERROR_OUT_OF_MEMORY;
+        overlay_free(pixels);
+        return 1;
+    }
+    out->pixels = pixels;
+    out->width = width;
+    out->height = height;
+    *err = OVERLAY_OK;
+    return 1;
+}
+
+OverlayError overlay_source_load(const char *path, OverlaySource *out) {
+    if (!path || !out) return OVERLAY_ERROR_NULL_PARAM;
+    memset(out, 0, sizeof(OverlaySource));
+
+    OverlayBytes bytes;
+    if (overlay_bytes_map(path, &bytes) == OVERLAY_OK) {
+        OverlayError err;
+        int handled = source_load_qoi(bytes.data, bytes.size, out, &err);
+        overlay_bytes_release(&bytes);
+        if (handled) return err;
+    }
+
+    int channels;
+    out->pixels = stbi_load(path, &out->width, &out->height, &channels, 4);
+    if (!out->pixels) return OVERLAY_ERROR_FILE_NOT_FOUND;
+    return OVERLAY_OK;
+}
+
+OverlayError overlay_source_load_mem(const unsigned char *buffer, int len, OverlaySource *out) {
     if (!buffer || !out) return OVERLAY_ERROR_NULL_PARAM;
-    
-    int w, h, channels;
-    unsigned char *data = stbi_load_from_memory(buffer, len, &w, &h, &channels, 4);
-    if (!data) return OVERLAY_ERROR_DECODE_FAILED;
-    
-    return finalize_image(data, w, h, max_width, max_height, out);
+    memset(out, 0, sizeof(OverlaySource));
+
+    OverlayError err;
+    if (len > 0 && source_load_qoi(buffer, (size_t)len, out, &err)) return err;
+
+    int channels;
+    out->pixels = stbi_load_from_memory(buffer, len, &out->width, &out->height, &channels, 4);
+    if (!out->pixels) return OVERLAY_ERROR_DECODE_FAILED;
+    return OVERLAY_OK;
+}
+
+OverlayError overlay_source_wrap(const unsigned char *rgba, int width, int height,
+                                 OverlaySource *out) {
+    if (!rgba || !out || width < 1 || height < 1) return OVERLAY_ERROR_NULL_PARAM;
+    memset(out, 0, sizeof(OverlaySource));
+
+    /* Sources are never written, so the const pixels can be shared */
+    out->pixels = (unsigned char *)rgba;
+    out->width = width;
+    out->height = height;
+    out->borrowed = 1;
+    return OVERLAY_OK;
+}
+
+OverlayError overlay_source_load_default(OverlaySource *out) {
+    if (!out) return OVERLAY_ERROR_NULL_PARAM;
+
+    int w, h;
+    const unsigned char *rgba = get_default_keymap_rgba(&w, &h);
+    if (rgba) return overlay_source_wrap(rgba, w, h, out);
+
+    int size = 0;
+    const unsigned char *png = get_default_keymap(&size);
+    if (!png || size <= 0) {
+        memset(out, 0, sizeof(OverlaySource));
+        return OVERLAY_ERROR_FILE_NOT_FOUND;
+    }
+    return overlay_source_load_mem(png, size, out);
+}
+
+typedef struct {
+    const unsigned char *src;
+    unsigned char *dst;
+    int src_width;
+    int src_height;
+    int dst_width;
+    OverlayDownsampleRowFn row_fn;
+} DownsampleJob;
+
+static void downsample_band(void *ctx, int begin, int end) {
+    const DownsampleJob *job = (const DownsampleJob *)ctx;
+    size_t src_stride = (size_t)job->src_width * 4;
+    for (int y = begin; y < end; y++) {
+        int y0 = 2 * y;
+        int y1 = y0 + 1 < job->src_height ? y0 + 1 : job->src_height - 1;
+        job->row_fn(job->src + y0 * src_stride, job->src + y1 * src_stride,
+                    job->dst + (size_t)y * job->dst_width * 4,
+                    job->dst_width, job->src_width);
+    }
+}
+
+OverlayError overlay_source_build_mips(OverlaySource *src) {
+    if (!src || !src->pixels) return OVERLAY_ERROR_NULL_PARAM;
+    if (src->mip_count > 0) return OVERLAY_OK;
+
+    const unsigned char *prev = src->pixels;
+    int w = src->width, h = src->height;
+    while ((w > 1 || h > 1) && src->mip_count < OVERLAY_MAX_MIP_LEVELS) {
+        int nw = (w + 1) / 2;
+        int nh = (h + 1) / 2;
+        unsigned char *level = overlay_alloc((size_t)nw * nh * 4);
+        if (!level) return OVERLAY_ERROR_OUT_OF_MEMORY; /* levels so far stay usable */
+
+        DownsampleJob job;
+        job.src = prev;
+        job.dst = level;
+        job.src_width = w;
+        job.src_height = h;
+        job.dst_width = nw;
+        job.row_fn = overlay_get_downsample_row();
+        overlay_parallel_rows(nh, (size_t)w * h, downsample_band, &job);
+
+        OverlayMipLevel *m = &src->mips[src->mip_count++];
+        m->pixels = level;
+        m->width = nw;
+        m->height = nh;
+        prev = level;
+        w = nw;
+        h = nh;
+    }
+    return OVERLAY_OK;
+}
+
+OverlayError overlay_from_source(const OverlaySource *src, int max_width, int max_height,
+                                 Overlay *out) {
+    if (!src || !src->pixels || !out) return OVERLAY_ERROR_NULL_PARAM;
+
+    int new_w, new_h;
+    fit_size(src->width, src->height, max_width, max_height, &new_w, &new_h);
+
+    /* Start from the smallest level that still covers the target */
+    const unsigned char *pixels = src->pixels;
+    int w = src->width, h = src->height;
+    for (int i = 0; i < src->mip_count; i++) {
+        if (src->mips[i].width < new_w || src->mips[i].height < new_h) break;
+        pixels = src->mips[i].pixels;
+        w = src->mips[i].width;
+        h = src->mips[i].height;
+    }
+
+    unsigned char *data = NULL;
+    if (w != new_w || h != new_h) {
+        OverlayError err = resample_pixels(pixels, w, h, new_w, new_h, &data);
+        if (err != OVERLAY_OK) return err;
+    } else {
+        /* The source stays shared; the overlay owns its own pixels */
+        size_t size = (size_t)new_w * new_h * 4;
+        data = overlay_alloc(size);
+        if (!data) return OVERLAY_ERROR_OUT_OF_MEMORY;
+        memcpy(data, pixels, size);
+    }
+
+    init_overlay(out, data, new_w, new_h);
+    return OVERLAY_OK;
+}
+
+void overlay_source_free(OverlaySource *src) {
+    if (!src) return;
+    for (int i = 0; i < src->mip_count; i++) {
+        overlay_free(src->mips[i].pixels);
+        src->mips[i].pixels = NULL;
+    }
+    src->mip_count = 0;
+    if (src->pixels) {
+        if (!src->borrowed) overlay_free(src->pixels);
+        src->pixels = NULL;
+        src->borrowed = 0;
+        src->width = 0;
+        src->height = 0;
+    }
+}
+
+size_t overlay_source_heap_bytes(const OverlaySource *src) {
+    if (!src) return 0;
+    size_t bytes = 0;
+    if (src->pixels && !src->borrowed) bytes = (size_t)src->width * src->height * 4;
+    for (int i = 0; i < src->mip_count; i++) {
+        bytes += (size_t)src->mips[i].width * src->mips[i].height * 4;
+    }
+    return bytes;
+}
+
+/* Run the active effect kernel over whole rows, split into bands across
+   worker threads for large images. src == dst runs in place. */
+typedef struct {
+    const unsigned char *src;
+    unsigned char *dst;
+    size_t stride;
+    int width;
+    OverlayEffectKernel kernel;
+    const OverlayEffectParams *params;
+} EffectBandJob;
+
+static void effect_band(void *ctx, int begin, int end) {
+    const EffectBandJob *job = (const EffectBandJob *)ctx;
+    size_t offset = (size_t)begin * job->stride;
+    if ((size_t)job->width * 4 == job->stride) {
+        /* Whole rows are contiguous: one kernel call for the band */
+        job->kernel(job->src + offset, job->dst + offset,
+                    (size_t)(end - begin) * job->width, job->params);
+        return;
+    }
+    for (int y = begin; y < end; y++, offset += job->stride) {
+        job->kernel(job->src + offset, job->dst + offset, (size_t)job->width, job->params);
+    }
+}
+
+/* Process rect of an image_width-wide image; src and dst share the layout */
+static void run_effect_kernel_rect(const unsigned char *src, unsigned char *dst,
+                                   int image_width, const OverlayRect *rect,
+                                   const OverlayEffectParams *params) {
+    size_t offset = ((size_t)rect->y * image_width + rect->x) * 4;
+    EffectBandJob job;
+    job.src = src + offset;
+    job.dst = dst + offset;
+    job.stride = (size_t)image_width * 4;
+    job.width = rect->width;
+    job.kernel = overlay_get_effect_kernel();
+    job.params = params;
+    overlay_parallel_rows(rect->height, (size_t)rect->width * rect->height, effect_band, &job);
+}
+
+static void run_effect_kernel(const unsigned char *src, unsigned char *dst,
+                              int width, int height, const OverlayEffectParams *params) {
+    OverlayRect all = {0, 0, width, height};
+    run_effect_kernel_rect(src, dst, width, &all, params);
+}
+
+/* Clip rect to the image; returns 0 if nothing is left */
+static int clip_rect(const Overlay *img, OverlayRect *rect) {
+    int x0 = rect->x < 0 ? 0 : rect->x;
+    int y0 = rect->y < 0 ? 0 : rect->y;
+    int x1 = rect->x + rect->width;
+    int y1 = rect->y + rect->height;
+    if (x1 > img->width) x1 = img->width;
+    if (y1 > img->height) y1 = img->height;
+    if (x1 <= x0 || y1 <= y0) return 0;
+    rect->x = x0;
+    rect->y = y0;
+    rect->width = x1 - x0;
+    rect->height = y1 - y0;
+    return 1;
+}
+
+static void union_rect(OverlayRect *acc, const OverlayRect *r) {
+    int x0 = acc->x < r->x ? acc->x : r->x;
+    int y0 = acc->y < r->y ? acc->y : r->y;
+    int x1 = acc->x + acc->width > r->x + r->width ? acc->x + acc->width : r->x + r->width;
+    int y1 = acc->y + acc->height > r->y + r->height ? acc->y + acc->height : r->y + r->height;
+    acc->x = x0;
+    acc->y = y0;
+    acc->width = x1 - x0;
+    acc->height = y1 - y0;
+}
+
+static int rect_contains(const OverlayRect *outer, const OverlayRect *r) {
+    return r->x >= outer->x && r->y >= outer->y &&
+           r->x + r->width <= outer->x + outer->width &&
+           r->y + r->height <= outer->y + outer->height;
+}
+
+static void add_dirty_rect(OverlayRect *list, int *count, const OverlayRect *rect) {
+    for (int i = 0; i < *count; i++) {
+        if (rect_contains(&list[i], rect)) return;
+    }
+    if (*count == OVERLAY_MAX_DIRTY_RECTS) {
+        /* Out of slots: one bounding box covers everything */
+        for (int i = 1; i < *count; i++) {
+            union_rect(&list[0], &list[i]);
+        }
+        union_rect(&list[0], rect);
+        *count = 1;
+        return;
+    }
+    list[(*count)++] = *rect;
+}
+
+void overlay_mark_dirty(Overlay *img, int x, int y, int width, int height) {
+    if (!img) return;
+    OverlayRect rect = {x, y, width, height};
+    if (!clip_rect(img, &rect)) return;
+    add_dirty_rect(img->dirty, &img->dirty_count, &rect);
+    add_dirty_rect(img->effects_dirty, &img->effects_dirty_count, &rect);
+}
+
+void overlay_clear_dirty(Overlay *img) {
+    if (!img) return;
+    img->dirty_count = 0;
+}
+
+/* Whole image changed, e.g. after a full effect pass */
+static void mark_all_dirty(Overlay *img) {
+    img->dirty_count = 0;
+    overlay_mark_dirty(img, 0, 0, img->width, img->height);
+    img->effects_dirty_count = 0;
+}
+
+static int effects_already_applied(const Overlay *img, float opacity, int invert) {
+    int effects_mask = (opacity != 1.0f ? 1 : 0) | (invert ? 2 : 0);
+    return img->cached_effects == effects_mask &&
+           img->cached_opacity == opacity &&
+           img->cached_invert == invert;
+}
+
+/* Drop the derived buffer so data aliases the pristine base again */
+static void alias_base(Overlay *img) {
+    if (img->data != img->base) overlay_free(img->data);
+    img->data = img->base;
+}
+
+/* Destination for a pass from base: the derived buffer, allocated the first
+   time data stops aliasing base. NULL if it can't be allocated. */
+static unsigned char *derived_buffer(Overlay *img) {
+    if (img->data && img->data != img->base) return img->data;
+    unsigned char *derived =
+        (unsigned char *)overlay_alloc((size_t)img->width * img->height * 4);
+    if (derived) img->data = derived;
+    return derived;
+}
+
+/* Re-derive data from the pristine base in one fused pass, or alias base for
+   identity effects. Returns 0 (data left as it was) on allocation failure. */
+static int derive_from_base(Overlay *img, const OverlayEffectParams *params) {
+    if (params->alpha_identity && !params->invert) {
+        alias_base(img);
+        return 1;
+    }
+    unsigned char *dst = derived_buffer(img);
+    if (!dst) return 0;
+    run_effect_kernel(img->base, dst, img->width, img->height, params);
+    return 1;
 }
 
 void apply_effects(Overlay *img, float opacity, int invert) {
-    if (!img || !img->data) return;
+    if (!img || (!img->data && !img->base)) return;
     
     /* Check if effects are already applied */
-    int effects_mask = (opacity != 1.0f ? 1 : 0) | (invert ? 2 : 0);
-    if (img->cached_effects == effects_mask && 
-        img->cached_opacity == opacity && 
-        img->cached_invert == invert) {
+    if (effects_already_applied(img, opacity, invert) &&
+        (!img->base || img->derived_generation == img->base_generation)) {
+        /* Same effects over a partly edited base: redo only the dirty
+           regions. Identity effects alias base, so there is nothing to do. */
+        if (img->base && img->effects_dirty_count > 0 && img->data != img->base) {
+            OverlayEffectParams params;
+            overlay_effect_params_init(&params, opacity, invert);
+            for (int i = 0; i < img->effects_dirty_count; i++) {
+                run_effect_kernel_rect(img->base, img->data, img->width,
+                                       &img->effects_dirty[i], &params);
+                /* The presenter may have consumed this rect before it was
+                   re-derived */
+                add_dirty_rect(img->dirty, &img->dirty_count, &img->effects_dirty[i]);
+            }
+        }
+        img->effects_dirty_count = 0;
         return; /* Effects already applied */
     }
     
-    size_t total = (size_t)img->width * img->height * 4;
-    for (size_t i = 0; i < total; i += 4) {
-        unsigned char *px = &img->data[i];
-        if (invert) {
-            px[0] = 255 - px[0]; /* R */
-            px[1] = 255 - px[1]; /* G */
-            px[2] = 255 - px[2]; /* B */
-        }
-        px[3] = (unsigned char)(px[3] * opacity); /* A */
+    /* Opacity is compiled into an alpha table once per call */
+    OverlayEffectParams params;
+    overlay_effect_params_init(&params, opacity, invert);
+    if (img->base) {
+        if (!derive_from_base(img, &params)) return;
+        img->derived_generation = img->base_generation;
+    } else {
+        run_effect_kernel(img->data, img->data, img->width, img->height, &params);
     }
-    
+    mark_all_dirty(img);
+
     /* Update cache */
-    img->cached_effects = effects_mask;
+    img->cached_effects = (opacity != 1.0f ? 1 : 0) | (invert ? 2 : 0);
     img->cached_opacity = opacity;
     img->cached_invert = invert;
 }
 
 /* Non-destructive apply: copy src pixels into dst buffer and apply effects there.
    dst must be preallocated to src->width * src->height * src->channels (4).
-   Returns 1 on success, 0 on failure (e.g., null params). */
+   Returns 1 on success, 0 on failure (e.g., null params).
+   Single fused pass: src is read once and dst written once (streaming stores
+   for large buffers), instead of a memcpy followed by an in-place pass. */
 int apply_effects_copy(const Overlay *src, unsigned char *dst, float opacity, int invert) {
+    return apply_effects_format(src, dst, opacity, invert, OVERLAY_FORMAT_RGBA);
+}
+
+int apply_effects_format(const Overlay *src, unsigned char *dst, float opacity, int invert,
+                         OverlayPixelFormat format) {
+    if (!src || !src->data || !dst) return 0;
+    OverlayEffectParams params;
+    overlay_effect_params_init(&params, opacity, invert);
+    overlay_effect_params_set_format(&params, format);
+    run_effect_kernel(src->data, dst, src->width, src->height, &params);
+    return 1;
+}
+
+int apply_effects_format_rect(const Overlay *src, unsigned char *dst, float opacity, int invert,
+                              OverlayPixelFormat format, const OverlayRect *rect) {
+    if (!src || !src->data || !dst || !rect) return 0;
+    OverlayRect clipped = *rect;
+    if (!clip_rect(src, &clipped)) return 1;
+    OverlayEffectParams params;
+    overlay_effect_params_init(&params, opacity, invert);
+    overlay_effect_params_set_format(&params, format);
+    run_effect_kernel_rect(src->data, dst, src->width, &clipped, &params);
+    return 1;
+}
+
+void overlay_base_changed(Overlay *img) {
+    if (img && img->base) img->base_generation++;
+}
+
+/* Effect chains: simple chains reuse the SIMD kernels, the rest run the
+   compiled stages over the same row bands */
+typedef struct {
+    const unsigned char *src;
+    unsigned char *dst;
+    size_t stride;
+    int width;
+    const OverlayEffectProgram *program;
+} ChainBandJob;
+
+static void chain_band(void *ctx, int begin, int end) {
+    const ChainBandJob *job = (const ChainBandJob *)ctx;
+    size_t offset = (size_t)begin * job->stride;
+    overlay_effect_program_run(job->program, job->src + offset, job->dst + offset,
+                               (size_t)(end - begin) * job->width);
+}
+
+static void run_effect_program(const unsigned char *src, unsigned char *dst,
+                               int width, int height, const OverlayEffectProgram *program) {
+    if (program->simple) {
+        run_effect_kernel(src, dst, width, height, &program->params);
+        return;
+    }
+    ChainBandJob job;
+    job.src = src;
+    job.dst = dst;
+    job.stride = (size_t)width * 4;
+    job.width = width;
+    job.program = program;
+    overlay_parallel_rows(height, (size_t)width * height, chain_band, &job);
+}
+
+/* Programs carry ~17 KB of tables, so they live on the heap */
+static OverlayEffectProgram *compile_chain(const OverlayEffect *effects, int count) {
+    OverlayEffectProgram *program =
+        (OverlayEffectProgram *)overlay_alloc(sizeof(OverlayEffectProgram));
+    if (!program) return NULL;
+    if (!overlay_effect_program_compile(program, effects, count)) {
+        overlay_free(program);
+        return NULL;
+    }
+    return program;
+}
+
+int apply_effect_chain(Overlay *img, const OverlayEffect *effects, int count) {
+    if (!img || (!img->data && !img->base)) return 0;
+    OverlayEffectProgram *program = compile_chain(effects, count);
+    if (!program) return 0;
+
+    if (img->base) {
+        if (program->identity) {
+            alias_base(img);
+        } else {
+            unsigned char *dst = derived_buffer(img);
+            if (!dst) {
+                overlay_free(program);
+                return 0;
+            }
+            run_effect_program(img->base, dst, img->width, img->height, program);
+        }
+        img->derived_generation = img->base_generation;
+    } else if (!program->identity) {
+        run_effect_program(img->data, img->data, img->width, img->height, program);
+    }
+    overlay_free(program);
+    mark_all_dirty(img);
+
+    /* Not expressible as opacity/invert: the next apply_effects re-derives */
+    img->cached_effects = 4;
+    img->cached_opacity = 1.0f;
+    img->cached_invert = 0;
+    return 1;
+}
+
+int apply_effect_chain_copy(const Overlay *src, unsigned char *dst,
+                            const OverlayEffect *effects, int count) {
+    if (!src || !src->data || !dst) return 0;
+    OverlayEffectProgram *program = compile_chain(effects, count);
+    if (!program) return 0;
+    run_effect_program(src->data, dst, src->width, src->height, program);
+    overlay_free(program);
+    return 1;
+}
+
+OverlayError overlay_color_lut_init(OverlayColorLut *lut, int size, unsigned int id) {
+    if (!lut) return OVERLAY_ERROR_NULL_PARAM;
+    lut->table = NULL;
+    lut->size = 0;
+    lut->id = id;
+    if (size < OVERLAY_COLOR_LUT_MIN_SIZE || size > OVERLAY_COLOR_LUT_MAX_SIZE) {
+        return OVERLAY_ERROR_INVALID_ARG;
+    }
+
+    lut->table = (unsigned char *)overlay_alloc((size_t)size * size * size * 3);
+    if (!lut->table) return OVERLAY_ERROR_OUT_OF_MEMORY;
+    lut->size = size;
+
+    unsigned char *e = lut->table;
+    for (int b = 0; b < size; b++) {
+        for (int g = 0; g < size; g++) {
+            for (int r = 0; r < size; r++) {
+                *e++ = (unsigned char)((r * 255 + (size - 1) / 2) / (size - 1));
+                *e++ = (unsigned char)((g * 255 + (size - 1) / 2) / (size - 1));
+                *e++ = (unsigned char)((b * 255 + (size - 1) / 2) / (size - 1));
+            }
+        }
+    }
+    return OVERLAY_OK;
+}
+
+void overlay_color_lut_free(OverlayColorLut *lut) {
+    if (lut && lut->table) {
+        overlay_free(lut->table);
+        lut->table = NULL;
+        lut->size = 0;
+    }
+}
+
+typedef struct {
+    const unsigned char *src;
+    unsigned char *dst;
+    size_t stride;
+    int width;
+    OverlayLut3dKernel kernel;
+    const OverlayLut3dPlan *plan;
+} Lut3dBandJob;
+
+static void lut3d_band(void *ctx, int begin, int end) {
+    const Lut3dBandJob *job = (const Lut3dBandJob *)ctx;
+    size_t offset = (size_t)begin * job->stride;
+    job->kernel(job->plan, job->src + offset, job->dst + offset,
+                (size_t)(end - begin) * job->width);
+}
+
+static void run_lut3d(const unsigned char *src, unsigned char *dst,
+                      int width, int height, const OverlayLut3dPlan *plan) {
+    Lut3dBandJob job;
+    job.src = src;
+    job.dst = dst;
+    job.stride = (size_t)width * 4;
+    job.width = width;
+    job.kernel = overlay_get_lut3d_kernel();
+    job.plan = plan;
+    overlay_parallel_rows(height, (size_t)width * height, lut3d_band, &job);
+}
+
+int apply_color_lut(Overlay *img, const OverlayColorLut *lut) {
+    if (!img || !img->data) return 0;
+    OverlayLut3dPlan plan;
+    if (!overlay_lut3d_plan_init(&plan, lut)) return 0;
+
+    /* Never write through to the pristine base */
+    const unsigned char *src = img->data;
+    unsigned char *dst = img->data;
+    if (img->base && img->data == img->base) {
+        dst = derived_buffer(img);
+        if (!dst) {
+            overlay_lut3d_plan_free(&plan);
+            return 0;
+        }
+    }
+    run_lut3d(src, dst, img->width, img->height, &plan);
+    overlay_lut3d_plan_free(&plan);
+    mark_all_dirty(img);
+
+    img->cached_effects |= 4;
+    return 1;
+}
+
+int apply_color_lut_copy(const Overlay *src, unsigned char *dst, const OverlayColorLut *lut) {
     if (!src || !src->data || !dst) return 0;
-    size_t total = (size_t)src->width * src->height * 4;
-    memcpy(dst, src->data, total);
-    Overlay tmp;
-    tmp.data = dst;
-    tmp.width = src->width;
-    tmp.height = src->height;
-    tmp.channels = src->channels;
-    tmp.cached_effects = 0;
-    tmp.cached_opacity = 0.0f;
-    tmp.cached_invert = 0;
-    apply_effects(&tmp, opacity, invert);
+    OverlayLut3dPlan plan;
+    if (!overlay_lut3d_plan_init(&plan, lut)) return 0;
+    run_lut3d(src->data, dst, src->width, src->height, &plan);
+    overlay_lut3d_plan_free(&plan);
     return 1;
 }
 
 void free_overlay(Overlay *img) {
-    if (img && img->data) {
+    if (!img) return;
+    if (img->data && img->data != img->base) {
         overlay_free(img->data);
-        img->data = NULL;
-        img->cached_effects = 0;
     }
+    if (img->base_owner && img->base_release) {
+        img->base_release(img->base_owner);
+    } else if (img->base) {
+        overlay_free(img->base);
+    }
+    img->data = NULL;
+    img->base = NULL;
+    img->base_owner = NULL;
+    img->base_release = NULL;
+    img->cached_effects = 0;
+    img->dirty_count = 0;
+    img->effects_dirty_count = 0;
 }
 
 /* Thread safety implementation */
@@ -198,6 +1376,23 @@ void overlay_mutex_destroy(overlay_mutex_t *mutex) {
 
 /* Simple helpers and cache implementation */
 
+/* Borrowed view of the pixels variations should start from: the pristine
+   base if the overlay has one, so cached effects never stack on top of the
+   effects already applied to data. */
+static Overlay source_view(const Overlay *img) {
+    Overlay view = *img;
+    if (img->base) {
+        view.data = img->base;
+        view.cached_effects = 0;
+        view.cached_opacity = 1.0f;
+        view.cached_invert = 0;
+    }
+    view.base = NULL;
+    view.base_owner = NULL;
+    view.base_release = NULL;
+    return view;
+}
+
 /* Duplicate an overlay (deep copy of pixel data). Returns 1 on success. */
 static int duplicate_overlay_into(Overlay *dst, const Overlay *src) {
     if (!dst || !src || !src->data) return 0;
@@ -213,6 +1408,45 @@ static int duplicate_overlay_into(Overlay *dst, const Overlay *src) {
     dst->cached_effects = src->cached_effects;
     dst->cached_opacity = src->cached_opacity;
     dst->cached_invert = src->cached_invert;
+    dst->base = NULL;
+    dst->base_owner = NULL;
+    dst->base_release = NULL;
+    dst->base_generation = 0;
+    dst->derived_generation = 0;
+    dst->dirty_count = 0;
+    dst->effects_dirty_count = 0;
+    return 1;
+}
+
+/* Build an effect variation of src into dst with one fused copy+effect pass.
+   If src already carries exactly these effects it is copied unchanged,
+   matching what apply_effects would do on a duplicate. Returns 1 on success. */
+static int derive_overlay_into(Overlay *dst, const Overlay *src,
+                               const OverlayEffectParams *params,
+                               float opacity, int invert) {
+    if (!dst || !src || !src->data) return 0;
+    if (effects_already_applied(src, opacity, invert)) {
+        return duplicate_overlay_into(dst, src);
+    }
+
+    size_t pixels = (size_t)src->width * src->height;
+    dst->data = (unsigned char *)overlay_alloc(pixels * 4);
+    if (!dst->data) return 0;
+
+    run_effect_kernel(src->data, dst->data, src->width, src->height, params);
+    dst->width = src->width;
+    dst->height = src->height;
+    dst->channels = src->channels;
+    dst->cached_effects = (opacity != 1.0f ? 1 : 0) | (invert ? 2 : 0);
+    dst->cached_opacity = opacity;
+    dst->cached_invert = invert;
+    dst->base = NULL;
+    dst->base_owner = NULL;
+    dst->base_release = NULL;
+    dst->base_generation = 0;
+    dst->derived_generation = 0;
+    dst->dirty_count = 0;
+    dst->effects_dirty_count = 0;
     return 1;
 }
 
@@ -226,18 +1460,23 @@ typedef struct {
 static int generate_variations(OverlayCache *cache, const Overlay *base_image) {
     if (!cache || !base_image || !base_image->data) return 0;
 
+    Overlay source = source_view(base_image);
     cache->count = 0;
 
     float opacity_levels[] = {0.25f, 0.5f, 0.75f, 1.0f};
     int invert_states[] = {0, 1};
 
     for (int o = 0; o < 4 && cache->count < MAX_CACHED_VARIATIONS; o++) {
+        /* One alpha table per opacity level, shared by both invert states */
+        OverlayEffectParams params;
+        overlay_effect_params_init(&params, opacity_levels[o], 0);
         for (int i = 0; i < 2 && cache->count < MAX_CACHED_VARIATIONS; i++) {
             Overlay *slot = &cache->variations[cache->count];
-            if (!duplicate_overlay_into(slot, base_image)) {
+            params.invert = invert_states[i];
+            if (!derive_overlay_into(slot, &source, &params,
+                                     opacity_levels[o], invert_states[i])) {
                 continue;
             }
-            apply_effects(slot, opacity_levels[o], invert_states[i]);
             cache->opacity_levels[cache->count] = opacity_levels[o];
             cache->invert_flags[cache->count] = invert_states[i];
             cache->count++;
@@ -338,7 +1577,8 @@ int init_overlay_cache_async(OverlayCache *cache, const Overlay *base_image) {
     }
     d->cache = cache;
     memset(&d->base_image, 0, sizeof(Overlay));
-    if (!duplicate_overlay_into(&d->base_image, base_image)) {
+    Overlay source = source_view(base_image);
+    if (!duplicate_overlay_into(&d->base_image, &source)) {
         overlay_free(d);
         overlay_mutex_destroy(&cache->lock);
         return OVERLAY_ERROR_OUT_OF_MEMORY;
@@ -402,6 +1642,58 @@ const Overlay *get_cached_variation(OverlayCache *cache, float opacity, int inve
     return result;
 }
 
+/* Recolours are built from the unmodified (opacity 1, no invert) variation
+   on first request and kept until evicted */
+const Overlay *get_cached_recolor(OverlayCache *cache, const OverlayColorLut *lut) {
+    if (!cache || !lut) return NULL;
+    overlay_mutex_lock(&cache->lock);
+
+    const Overlay *result = NULL;
+    for (int i = 0; i < cache->recolor_count; i++) {
+        if (cache->recolor_ids[i] == lut->id) {
+            result = &cache->recolors[i];
+            break;
+        }
+    }
+
+    const Overlay *plain = NULL;
+    for (int i = 0; !result && i < cache->count; i++) {
+        if (!cache->invert_flags[i] && cache->opacity_levels[i] == 1.0f) {
+            plain = &cache->variations[i];
+            break;
+        }
+    }
+
+    if (plain) {
+        Overlay recolor;
+        memset(&recolor, 0, sizeof(Overlay));
+        recolor.width = plain->width;
+        recolor.height = plain->height;
+        recolor.channels = plain->channels;
+        recolor.cached_opacity = 1.0f;
+        recolor.cached_effects = 4;
+        recolor.data = (unsigned char *)overlay_alloc((size_t)plain->width * plain->height * 4);
+        if (recolor.data && apply_color_lut_copy(plain, recolor.data, lut)) {
+            int slot = cache->recolor_count;
+            if (slot == MAX_CACHED_RECOLORS) {
+                slot = cache->recolor_next;
+                cache->recolor_next = (cache->recolor_next + 1) % MAX_CACHED_RECOLORS;
+                free_overlay(&cache->recolors[slot]);
+            } else {
+                cache->recolor_count++;
+            }
+            cache->recolors[slot] = recolor;
+            cache->recolor_ids[slot] = lut->id;
+            result = &cache->recolors[slot];
+        } else {
+            free_overlay(&recolor);
+        }
+    }
+
+    overlay_mutex_unlock(&cache->lock);
+    return result;
+}
+
 /* Free cache and contained overlays */
 void free_overlay_cache(OverlayCache *cache) {
     if (!cache) return;
@@ -410,6 +1702,11 @@ void free_overlay_cache(OverlayCache *cache) {
         free_overlay(&cache->variations[i]);
     }
     cache->count = 0;
+    for (int i = 0; i < cache->recolor_count; i++) {
+        free_overlay(&cache->recolors[i]);
+    }
+    cache->recolor_count = 0;
+    cache->recolor_next = 0;
     overlay_mutex_unlock(&cache->lock);
     overlay_mutex_destroy(&cache->lock);
 }
@@ -1,6 +1,7 @@
 #ifndef OVERLAY_H
 #define OVERLAY_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef _WIN32
@@ -22,39 +23,306 @@ typedef enum {
     OVERLAY_ERROR_FILE_NOT_FOUND = -2,
     OVERLAY_ERROR_DECODE_FAILED = -3,
     OVERLAY_ERROR_OUT_OF_MEMORY = -4,
-    OVERLAY_ERROR_RESIZE_FAILED = -5
+    OVERLAY_ERROR_RESIZE_FAILED = -5,
+    OVERLAY_ERROR_IO = -6,
+    OVERLAY_ERROR_CANCELLED = -7,
+    OVERLAY_ERROR_INVALID_ARG = -8
 } OverlayError;
 
+/* Pixel rectangle; x/y are the top-left corner */
+typedef struct {
+    int x;
+    int y;
+    int width;
+    int height;
+} OverlayRect;
+
+/* Beyond this many dirty rectangles they collapse into their bounding box */
+#define OVERLAY_MAX_DIRTY_RECTS 8
+
 typedef struct {
     unsigned char *data;
     int width;
     int height;
     int channels; /* 4 for RGBA */
-    int cached_effects; /* Bitmask: 1=opacity cached, 2=invert cached */
+    int cached_effects; /* Bitmask: 1=opacity cached, 2=invert cached, 4=effect chain */
     float cached_opacity;
     int cached_invert;
+    /* Pristine pixels as loaded; effects never touch them. data aliases base
+       until effects are applied, then points at a separate derived buffer.
+       NULL for overlays whose data was filled in by the caller, which keep
+       the old in-place behaviour. */
+    unsigned char *base;
+    unsigned int base_generation;    /* bumped by overlay_base_changed */
+    unsigned int derived_generation; /* base_generation data was derived from */
+    /* Regions of data that changed since the presenter last consumed them
+       (overlay_clear_dirty) */
+    OverlayRect dirty[OVERLAY_MAX_DIRTY_RECTS];
+    int dirty_count;
+    /* Base edits (overlay_mark_dirty) not yet re-derived: the next
+       apply_effects with unchanged parameters redoes just these. Kept apart
+       from dirty so a presenter clearing its list cannot drop them. */
+    OverlayRect effects_dirty[OVERLAY_MAX_DIRTY_RECTS];
+    int effects_dirty_count;
+    /* Set when base is borrowed rather than allocated (overlay_disk_cache_load
+       maps it): free_overlay hands base_owner to base_release instead of
+       freeing base */
+    void *base_owner;
+    void (*base_release)(void *owner);
 } Overlay;
 
-/* Load overlay image - returns OverlayError */
+/* Load overlay image - returns OverlayError. Non-interlaced PNGs and QOI
+   files (told apart by their magic bytes) are decoded row by row straight
+   into the resampler (on a second thread for images above the parallel
+   threshold), so the full-size image is never held in memory; other formats
+   go through stb_image. keymap_predecode --qoi transcodes a PNG to QOI,
+   which decodes several times faster. A multi-resolution bundle
+   (overlay_bundle.h) decodes only the variant nearest the requested size. */
 OverlayError load_overlay(const char *path, int max_width, int max_height, Overlay *out);
 
 /* Load from memory buffer */
 OverlayError load_overlay_mem(const unsigned char *buffer, int len, int max_width, int max_height, Overlay *out);
 
-/* Apply opacity and inversion effects */
+/* Asynchronous load: load_overlay / load_overlay_mem on a background
+   thread, so UI threads never block on decode or resize. */
+typedef struct OverlayLoad OverlayLoad;
+
+/* Runs exactly once per load, also for failed and cancelled loads. The
+   handle stays valid for the duration of the call even if it was freed. */
+typedef void (*OverlayLoadCallback)(OverlayLoad *load, OverlayError result, void *user);
+
+/* Must arrange for fn(arg) to run once on the thread of the caller's choice
+   (PostMessage to a window, dispatch_async to the main queue, ...). */
+typedef void (*OverlayDispatchFn)(void (*fn)(void *arg), void *arg, void *dispatch_ctx);
+
+typedef struct {
+    OverlayLoadCallback on_complete; /* optional */
+    void *user;
+    OverlayDispatchFn dispatch;      /* NULL: on_complete runs on the loader thread */
+    void *dispatch_ctx;
+} OverlayLoadCallbacks;
+
+/* NULL on bad parameters or allocation failure. callbacks may be NULL. The
+   buffer of a memory load must stay valid until the load has finished. */
+OverlayLoad *load_overlay_async(const char *path, int max_width, int max_height,
+                                const OverlayLoadCallbacks *callbacks);
+OverlayLoad *load_overlay_mem_async(const unsigned char *buffer, int len,
+                                    int max_width, int max_height,
+                                    const OverlayLoadCallbacks *callbacks);
+int overlay_load_poll(OverlayLoad *load);                  /* 1 once finished */
+int overlay_load_wait(OverlayLoad *load, int timeout_ms);  /* 1 if finished; < 0 waits forever */
+/* Ask the loader to stop; it finishes soon after with OVERLAY_ERROR_CANCELLED
+   unless it was already done */
+void overlay_load_cancel(OverlayLoad *load);
+/* Wait for the load and return its result. On success the overlay moves
+   into out; only the first call gets it, later ones return
+   OVERLAY_ERROR_NULL_PARAM. */
+OverlayError overlay_load_result(OverlayLoad *load, Overlay *out);
+/* Release the handle without waiting; a running load is cancelled and an
+   untaken overlay freed */
+void overlay_load_free(OverlayLoad *load);
+
+/* Decoded full-resolution image, kept so size changes only resample: decode
+   once with overlay_source_load*, then build overlays of any size from it
+   with overlay_from_source (same sizing as load_overlay). The source is
+   read-only and can outlive or be shared by any number of overlays. */
+#define OVERLAY_MAX_MIP_LEVELS 16
+typedef struct {
+    unsigned char *pixels;
+    int width;
+    int height;
+} OverlayMipLevel;
+
+typedef struct {
+    unsigned char *pixels; /* straight RGBA */
+    int width;
+    int height;
+    int borrowed; /* pixels belong to the caller (overlay_source_wrap) */
+    /* Optional pyramid from overlay_source_build_mips: mips[i] is the source
+       halved i + 1 times (2x2 box, odd sizes round up) */
+    OverlayMipLevel mips[OVERLAY_MAX_MIP_LEVELS];
+    int mip_count;
+} OverlaySource;
+
+/* QOI is decoded natively, everything else by stb_image. Bundles are not
+   sources: load them with load_overlay* for each size. */
+OverlayError overlay_source_load(const char *path, OverlaySource *out);
+OverlayError overlay_source_load_mem(const unsigned char *buffer, int len, OverlaySource *out);
+
+/* Use already-decoded RGBA as a source without copying it; rgba must outlive
+   the source, and overlay_source_free leaves it alone */
+OverlayError overlay_source_wrap(const unsigned char *rgba, int width, int height,
+                                 OverlaySource *out);
+
+/* The keymap compiled into the binary: a pointer handoff when it was decoded
+   at build time (EMBED_KEYMAP_RGBA), a PNG decode otherwise.
+   OVERLAY_ERROR_FILE_NOT_FOUND if nothing is embedded. */
+OverlayError overlay_source_load_default(OverlaySource *out);
+
+/* Build the mip pyramid down to 1x1 (about a third more memory). With it,
+   overlay_from_source resamples from the smallest level still at least as
+   large as the target, so resize cost follows the output size, not the
+   source size. A level that matches the target exactly is copied as is. */
+OverlayError overlay_source_build_mips(OverlaySource *src);
+
+OverlayError overlay_from_source(const OverlaySource *src, int max_width, int max_height,
+                                 Overlay *out);
+void overlay_source_free(OverlaySource *src);
+/* Heap memory src owns: its pixels unless borrowed, plus the pyramid */
+size_t overlay_source_heap_bytes(const OverlaySource *src);
+
+/* Apply opacity and inversion effects. Overlays from load_overlay* derive
+   data from the pristine base in one pass, so any parameter change costs one
+   effect pass and effects never compound; apply_effects(img, 1.0f, 0) gets
+   the original pixels back. */
 void apply_effects(Overlay *img, float opacity, int invert);
 
+/* Call after editing img->base in place; the next apply_effects re-derives
+   data even if the effect parameters are unchanged. */
+void overlay_base_changed(Overlay *img);
+
+/* Record that pixels in rect changed (clipped to the image). After editing
+   part of base, this lets apply_effects and presenters touch only that part;
+   a full effect pass marks the whole image. */
+void overlay_mark_dirty(Overlay *img, int x, int y, int width, int height);
+/* Presenters call this once they have consumed img->dirty; pending
+   re-derives are kept */
+void overlay_clear_dirty(Overlay *img);
+
 /* Non-destructive apply: copy src pixels into dst buffer and apply effects there.
    dst must be preallocated to src->width * src->height * src->channels (4).
    Returns 1 on success, 0 on failure (e.g., null params). */
 int apply_effects_copy(const Overlay *src, unsigned char *dst, float opacity, int invert);
 
+/* SIMD kernel selection for apply_effects. The best level the CPU supports is
+   detected once on first use; the scalar kernel is the reference and every
+   SIMD variant produces bit-identical output. */
+typedef enum {
+    OVERLAY_SIMD_SCALAR = 0,
+    OVERLAY_SIMD_SSE2 = 1,
+    OVERLAY_SIMD_AVX2 = 2,
+    OVERLAY_SIMD_NEON = 3
+} OverlaySimdLevel;
+
+OverlaySimdLevel overlay_simd_detect(void);      /* best level supported by this CPU */
+OverlaySimdLevel overlay_get_simd_level(void);   /* level currently in use */
+int overlay_set_simd_level(OverlaySimdLevel level); /* force a level (tests); 1 if supported */
+
+/* Effect passes and resizes over large images are split into row bands
+   across worker threads; the calls stay synchronous. threads = 0 (the
+   default) means one thread per logical CPU. Images with fewer pixels than
+   the threshold always run on the calling thread. */
+#define OVERLAY_PARALLEL_DEFAULT_MIN_PIXELS ((size_t)1 << 20)
+void overlay_set_thread_count(int threads);
+int overlay_get_thread_count(void);            /* effective count, >= 1 */
+void overlay_set_parallel_threshold(size_t min_pixels);
+size_t overlay_get_parallel_threshold(void);
+
+/* Filter for every resize (load_overlay*, overlay_from_source). AUTO uses
+   Mitchell to reduce and Catmull-Rom to enlarge, per axis. BOX at exact
+   2x/4x reductions and whole-number enlargements takes integer fast paths
+   with identical results. Process-wide, like the SIMD level. */
+typedef enum {
+    OVERLAY_FILTER_AUTO = 0,
+    OVERLAY_FILTER_BOX = 1,
+    OVERLAY_FILTER_BILINEAR = 2,
+    OVERLAY_FILTER_CATMULL_ROM = 3,
+    OVERLAY_FILTER_LANCZOS3 = 4
+} OverlayResizeFilter;
+
+void overlay_set_resize_filter(OverlayResizeFilter filter); /* out-of-range values mean AUTO */
+OverlayResizeFilter overlay_get_resize_filter(void);
+
+/* Output pixel layouts for apply_effects_format. Overlay.data is always
+   straight-alpha RGBA; presenters want premultiplied pixels in their own
+   channel order (BGRA for Win32 AC_SRC_ALPHA DIBs, RGBA for NSBitmapImageRep). */
+typedef enum {
+    OVERLAY_FORMAT_RGBA = 0,          /* straight alpha, R G B A */
+    OVERLAY_FORMAT_RGBA_PREMUL = 1,   /* premultiplied, R G B A */
+    OVERLAY_FORMAT_BGRA_PREMUL = 2    /* premultiplied, B G R A */
+} OverlayPixelFormat;
+
+/* Like apply_effects_copy, but writes dst in the requested format. Effects
+   and the format conversion run in the same single pass over the pixels.
+   Returns 1 on success, 0 on failure. */
+int apply_effects_format(const Overlay *src, unsigned char *dst, float opacity, int invert,
+                         OverlayPixelFormat format);
+
+/* apply_effects_format restricted to rect; dst has the full image layout
+   (width * 4 bytes per row) and pixels outside rect are left alone. */
+int apply_effects_format_rect(const Overlay *src, unsigned char *dst, float opacity, int invert,
+                              OverlayPixelFormat format, const OverlayRect *rect);
+
+/* Effect chains. Effects run in list order; consecutive per-channel effects
+   are folded into one lookup table per channel and grayscale mixes between
+   them, so a whole chain is a single pass over the pixels. A chain made of
+   just invert and at most one opacity uses the same SIMD kernels as
+   apply_effects and gives identical output. */
+#define OVERLAY_MAX_EFFECT_CHAIN 16
+
+typedef enum {
+    OVERLAY_EFFECT_OPACITY = 0,             /* alpha *= value (0..1) */
+    OVERLAY_EFFECT_INVERT = 1,              /* RGB = 255 - RGB */
+    OVERLAY_EFFECT_TINT = 2,                /* RGB mixed toward color by value (0..1) */
+    OVERLAY_EFFECT_BRIGHTNESS_CONTRAST = 3, /* RGB scaled by value2 around mid grey,
+                                               then value (-1..1) * 255 added */
+    OVERLAY_EFFECT_GAMMA = 4,               /* RGB = 255 * (RGB / 255)^(1 / value), value > 0 */
+    OVERLAY_EFFECT_GRAYSCALE = 5,           /* RGB mixed toward Rec.601 luma by value (0..1) */
+    OVERLAY_EFFECT_ALPHA_THRESHOLD = 6      /* alpha below value * 255 becomes 0 */
+} OverlayEffectType;
+
+typedef struct {
+    OverlayEffectType type;
+    float value;
+    float value2;             /* BRIGHTNESS_CONTRAST: contrast, 1 = unchanged */
+    unsigned char color[3];   /* TINT: R G B */
+} OverlayEffect;
+
+/* Apply a chain to img. Like apply_effects, overlays with a base derive data
+   from it; caller-filled overlays are modified in place. Returns 1 on
+   success, 0 on bad parameters or allocation failure. */
+int apply_effect_chain(Overlay *img, const OverlayEffect *effects, int count);
+
+/* Run a chain from src->data into dst (width * height * 4 bytes) */
+int apply_effect_chain_copy(const Overlay *src, unsigned char *dst,
+                            const OverlayEffect *effects, int count);
+
+/* 3D colour LUT for themed recolours (e.g. a dark-desktop variant of the
+   same keymap). size grid points per axis, RGB entries with red varying
+   fastest: entry (r, g, b) is at ((b * size + g) * size + r) * 3. Applied
+   with trilinear interpolation in fixed point; alpha is left alone. id is
+   chosen by the caller and keys recolours in OverlayCache. */
+#define OVERLAY_COLOR_LUT_MIN_SIZE 2
+#define OVERLAY_COLOR_LUT_MAX_SIZE 65
+typedef struct {
+    int size;
+    unsigned char *table;
+    unsigned int id;
+} OverlayColorLut;
+
+/* Allocates an identity LUT of the given size; fill table to taste.
+   OVERLAY_ERROR_INVALID_ARG for a size outside the MIN/MAX range. */
+OverlayError overlay_color_lut_init(OverlayColorLut *lut, int size, unsigned int id);
+void overlay_color_lut_free(OverlayColorLut *lut);
+
+/* Recolour the current pixels (after apply_effects, if any). Overlays with a
+   base keep it pristine: the result goes to the derived buffer, and the next
+   apply_effects re-derives without the recolour. Returns 1 on success. */
+int apply_color_lut(Overlay *img, const OverlayColorLut *lut);
+
+/* Recolour src->data into dst (width * height * 4 bytes). Returns 1 on success. */
+int apply_color_lut_copy(const Overlay *src, unsigned char *dst, const OverlayColorLut *lut);
+
 /* Free overlay resources */
 void free_overlay(Overlay *img);
 
-/* Get embedded default keymap */
+/* Get embedded default keymap (PNG bytes; NULL with EMBED_KEYMAP_RGBA) */
 const unsigned char *get_default_keymap(int *size);
 
+/* Embedded keymap decoded at build time (EMBED_KEYMAP_RGBA): straight RGBA,
+   width * height * 4 bytes. NULL when the build embeds the PNG instead. */
+const unsigned char *get_default_keymap_rgba(int *width, int *height);
+
 /* Thread safety functions */
 void overlay_mutex_init(overlay_mutex_t *mutex);
 void overlay_mutex_lock(overlay_mutex_t *mutex);
@@ -63,11 +331,18 @@ void overlay_mutex_destroy(overlay_mutex_t *mutex);
 
 /* Simple cache for precomputed variations (opacity / invert) */
 #define MAX_CACHED_VARIATIONS 16
+#define MAX_CACHED_RECOLORS 4
 typedef struct {
     Overlay variations[MAX_CACHED_VARIATIONS];
     float opacity_levels[MAX_CACHED_VARIATIONS];
     int invert_flags[MAX_CACHED_VARIATIONS];
     int count;
+    /* Recolours of the unmodified variation, keyed by OverlayColorLut.id;
+       the oldest is replaced when full */
+    Overlay recolors[MAX_CACHED_RECOLORS];
+    unsigned int recolor_ids[MAX_CACHED_RECOLORS];
+    int recolor_count;
+    int recolor_next;
     overlay_mutex_t lock;
 } OverlayCache;
 
@@ -75,6 +350,10 @@ typedef struct {
 int init_overlay_cache(OverlayCache *cache, const Overlay *base_image); /* synchronous */
 int init_overlay_cache_async(OverlayCache *cache, const Overlay *base_image); /* background populate */
 const Overlay *get_cached_variation(OverlayCache *cache, float opacity, int invert);
+/* Recoloured full-opacity variation for lut, built on first request. NULL
+   until the variations exist. The pointer stays valid until MAX_CACHED_RECOLORS
+   other LUTs have been requested or the cache is freed. */
+const Overlay *get_cached_recolor(OverlayCache *cache, const OverlayColorLut *lut);
 void free_overlay_cache(OverlayCache *cache);
 
 #ifdef __cplusplus
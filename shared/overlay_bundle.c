@@ -0,0 +1,128 @@
+#include "overlay_bundle.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BUNDLE_VERSION 1
+#define BUNDLE_HEADER_SIZE 16
+#define BUNDLE_ENTRY_SIZE 24
+
+/* Upscaling invents detail that downscaling keeps, so a step up counts this
+   many times a step down of the same ratio */
+#define BUNDLE_UPSCALE_COST 2.0f
+
+static uint32_t read_le32(const unsigned char *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t read_le64(const unsigned char *p) {
+    return (uint64_t)read_le32(p) | ((uint64_t)read_le32(p + 4) << 32);
+}
+
+static void write_le32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static void write_le64(unsigned char *p, uint64_t v) {
+    write_le32(p, (uint32_t)v);
+    write_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+int overlay_bundle_detect(const unsigned char *data, size_t len) {
+    return data && len >= 4 && memcmp(data, "KOVB", 4) == 0;
+}
+
+/* Entry index without validating the table as a whole */
+static int read_entry(const unsigned char *data, size_t len, int index, OverlayBundleVariant *out) {
+    const unsigned char *e = data + BUNDLE_HEADER_SIZE + (size_t)index * BUNDLE_ENTRY_SIZE;
+    uint32_t width = read_le32(e), height = read_le32(e + 4);
+    uint64_t offset = read_le64(e + 8), size = read_le64(e + 16);
+    if (width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX) return 0;
+    if (size == 0 || offset > len || size > len - offset) return 0;
+    out->width = (int)width;
+    out->height = (int)height;
+    out->data = data + offset;
+    out->size = (size_t)size;
+    return 1;
+}
+
+int overlay_bundle_count(const unsigned char *data, size_t len) {
+    if (!overlay_bundle_detect(data, len) || len < BUNDLE_HEADER_SIZE) return -1;
+    if (read_le32(data + 4) != BUNDLE_VERSION) return -1;
+    uint32_t count = read_le32(data + 8);
+    if (count == 0 || count > OVERLAY_BUNDLE_MAX_VARIANTS) return -1;
+    if (len - BUNDLE_HEADER_SIZE < (size_t)count * BUNDLE_ENTRY_SIZE) return -1;
+    OverlayBundleVariant v;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!read_entry(data, len, (int)i, &v)) return -1;
+    }
+    return (int)count;
+}
+
+OverlayError overlay_bundle_variant(const unsigned char *data, size_t len, int index,
+                                    OverlayBundleVariant *out) {
+    if (!data || !out) return OVERLAY_ERROR_NULL_PARAM;
+    int count = overlay_bundle_count(data, len);
+    if (index < 0 || index >= count) return OVERLAY_ERROR_DECODE_FAILED;
+    read_entry(data, len, index, out);
+    return OVERLAY_OK;
+}
+
+int overlay_bundle_select(const unsigned char *data, size_t len, int max_width, int max_height) {
+    int count = overlay_bundle_count(data, len);
+    int best = -1;
+    float best_cost = 0.0f;
+    for (int i = 0; i < count; i++) {
+        OverlayBundleVariant v;
+        read_entry(data, len, i, &v);
+        /* Same fit as load_overlay: scale 1 is an exact match */
+        float scale_w = (float)max_width / (float)v.width;
+        float scale_h = (float)max_height / (float)v.height;
+        float scale = scale_w < scale_h ? scale_w : scale_h;
+        if (scale == 1.0f) return i;
+        /* Distance in octaves, so 2x down and 2x up are equally far */
+        float cost = logf(scale);
+        cost = cost < 0.0f ? -cost : cost * BUNDLE_UPSCALE_COST;
+        if (best < 0 || cost < best_cost) {
+            best = i;
+            best_cost = cost;
+        }
+    }
+    return best;
+}
+
+unsigned char *overlay_bundle_write(const OverlayBundleVariant *variants, int count,
+                                    size_t *out_len) {
+    if (!variants || !out_len || count < 1 || count > OVERLAY_BUNDLE_MAX_VARIANTS) return NULL;
+    size_t total = BUNDLE_HEADER_SIZE + (size_t)count * BUNDLE_ENTRY_SIZE;
+    for (int i = 0; i < count; i++) {
+        if (!variants[i].data || variants[i].size == 0 ||
+            variants[i].width < 1 || variants[i].height < 1) {
+            return NULL;
+        }
+        total += variants[i].size;
+    }
+
+    unsigned char *out = (unsigned char *)malloc(total);
+    if (!out) return NULL;
+    memcpy(out, "KOVB", 4);
+    write_le32(out + 4, BUNDLE_VERSION);
+    write_le32(out + 8, (uint32_t)count);
+    write_le32(out + 12, 0);
+    size_t offset = BUNDLE_HEADER_SIZE + (size_t)count * BUNDLE_ENTRY_SIZE;
+    for (int i = 0; i < count; i++) {
+        unsigned char *e = out + BUNDLE_HEADER_SIZE + (size_t)i * BUNDLE_ENTRY_SIZE;
+        write_le32(e, (uint32_t)variants[i].width);
+        write_le32(e + 4, (uint32_t)variants[i].height);
+        write_le64(e + 8, offset);
+        write_le64(e + 16, variants[i].size);
+        memcpy(out + offset, variants[i].data, variants[i].size);
+        offset += variants[i].size;
+    }
+    *out_len = total;
+    return out;
+}
@@ -0,0 +1,57 @@
+#ifndef OVERLAY_BUNDLE_H
+#define OVERLAY_BUNDLE_H
+
+/* A keymap pre-rendered at several resolutions in one file. Each variant is
+   a complete encoded image (PNG or QOI); load_overlay and load_overlay_mem
+   recognise a bundle by its magic bytes and decode only the variant closest
+   to the requested size, so an exact match needs no resize at all and a
+   near one only a small one. keymap_predecode --bundle writes bundles.
+
+   Layout, little-endian: "KOVB", u32 version (1), u32 count, u32 reserved,
+   then count entries of {u32 width, u32 height, u64 offset, u64 size} and
+   the variants' bytes at their offsets. */
+
+#include <stddef.h>
+#include "overlay.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OVERLAY_BUNDLE_MAX_VARIANTS 64
+
+typedef struct {
+    int width;
+    int height;
+    const unsigned char *data; /* encoded image inside the bundle */
+    size_t size;
+} OverlayBundleVariant;
+
+/* 1 when data starts with the bundle magic */
+int overlay_bundle_detect(const unsigned char *data, size_t len);
+
+/* Number of variants, or -1 when the header or table is damaged (a variant
+   outside the data, a bad size, an unknown version) */
+int overlay_bundle_count(const unsigned char *data, size_t len);
+
+/* Table entry index. OVERLAY_ERROR_DECODE_FAILED for a damaged bundle or an
+   index out of range. */
+OverlayError overlay_bundle_variant(const unsigned char *data, size_t len, int index,
+                                    OverlayBundleVariant *out);
+
+/* The variant to build a max_width x max_height overlay from: an exact fit
+   if there is one, else the one needing the smallest resize by ratio, with
+   upscales counted double. -1 for a damaged bundle. */
+int overlay_bundle_select(const unsigned char *data, size_t len, int max_width, int max_height);
+
+/* Serialize variants (their data copied in order) into a new bundle.
+   Returns a malloc'd buffer of *out_len bytes, NULL on bad arguments or
+   allocation failure. */
+unsigned char *overlay_bundle_write(const OverlayBundleVariant *variants, int count,
+                                    size_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLAY_BUNDLE_H */
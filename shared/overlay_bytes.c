@@ -0,0 +1,117 @@
+#include "overlay_bytes.h"
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static OverlayError map_file(const char *path, int copy_on_write, OverlayBytes *out) {
+    if (!path || !out) return OVERLAY_ERROR_NULL_PARAM;
+    memset(out, 0, sizeof(*out));
+#ifdef _WIN32
+    /* Share everything so editors can still save over the file. Windows
+       refuses to truncate a file while a view of it is mapped, so in-place
+       writes can change the bytes but never pull pages out from under us. */
+    DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+    HANDLE file = CreateFileA(path, GENERIC_READ, share, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return OVERLAY_ERROR_FILE_NOT_FOUND;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+        CloseHandle(file);
+        return OVERLAY_ERROR_IO;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY,
+                                        0, 0, NULL);
+    if (!mapping) {
+        CloseHandle(file);
+        return OVERLAY_ERROR_IO;
+    }
+    DWORD access = copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ;
+    const unsigned char *data = (const unsigned char *)MapViewOfFile(mapping, access, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return OVERLAY_ERROR_IO;
+    }
+    out->file = file;
+    out->mapping = mapping;
+    out->data = data;
+    out->size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return OVERLAY_ERROR_FILE_NOT_FOUND;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        close(fd);
+        return OVERLAY_ERROR_IO;
+    }
+    /* The mapping keeps the file referenced; the descriptor is not needed */
+    int prot = copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *p = mmap(NULL, (size_t)st.st_size, prot, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return OVERLAY_ERROR_IO;
+    out->data = (const unsigned char *)p;
+    out->size = (size_t)st.st_size;
+#endif
+    out->kind = OVERLAY_BYTES_MAPPED;
+    return OVERLAY_OK;
+}
+
+OverlayError overlay_bytes_map(const char *path, OverlayBytes *out) {
+    return map_file(path, 0, out);
+}
+
+OverlayError overlay_bytes_map_private(const char *path, OverlayBytes *out) {
+    return map_file(path, 1, out);
+}
+
+OverlayError overlay_bytes_embedded(OverlayBytes *out) {
+    if (!out) return OVERLAY_ERROR_NULL_PARAM;
+    memset(out, 0, sizeof(*out));
+
+    int size = 0;
+    const unsigned char *png = get_default_keymap(&size);
+    if (png && size > 0) {
+        out->data = png;
+        out->size = (size_t)size;
+        out->kind = OVERLAY_BYTES_EMBEDDED;
+        return OVERLAY_OK;
+    }
+
+    int w, h;
+    const unsigned char *rgba = get_default_keymap_rgba(&w, &h);
+    if (rgba) {
+        out->data = rgba;
+        out->size = (size_t)w * h * 4;
+        out->width = w;
+        out->height = h;
+        out->kind = OVERLAY_BYTES_EMBEDDED_RGBA;
+        return OVERLAY_OK;
+    }
+    return OVERLAY_ERROR_FILE_NOT_FOUND;
+}
+
+OverlayError overlay_bytes_open(const char *const *paths, OverlayBytes *out) {
+    if (!out) return OVERLAY_ERROR_NULL_PARAM;
+    for (int i = 0; paths && paths[i]; i++) {
+        if (overlay_bytes_map(paths[i], out) == OVERLAY_OK) return OVERLAY_OK;
+    }
+    return overlay_bytes_embedded(out);
+}
+
+void overlay_bytes_release(OverlayBytes *b) {
+    if (!b) return;
+    if (b->kind == OVERLAY_BYTES_MAPPED && b->data) {
+#ifdef _WIN32
+        UnmapViewOfFile(b->data);
+        CloseHandle(b->mapping);
+        CloseHandle(b->file);
+#else
+        munmap((void *)b->data, b->size);
+#endif
+    }
+    memset(b, 0, sizeof(*b));
+}
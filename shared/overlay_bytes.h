@@ -0,0 +1,62 @@
+#ifndef OVERLAY_BYTES_H
+#define OVERLAY_BYTES_H
+
+/* Read-only view of the bytes an overlay is decoded from, without copying
+   them: a file is memory-mapped, the embedded keymap is borrowed from the
+   static array. Decoders read straight from data. */
+
+#include <stddef.h>
+#include "overlay.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    OVERLAY_BYTES_NONE = 0,
+    OVERLAY_BYTES_MAPPED,        /* encoded image file, mapped */
+    OVERLAY_BYTES_EMBEDDED,      /* EMBED_KEYMAP: PNG bytes in the binary */
+    OVERLAY_BYTES_EMBEDDED_RGBA  /* EMBED_KEYMAP_RGBA: width * height * 4 pixels */
+} OverlayBytesKind;
+
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    int width;  /* OVERLAY_BYTES_EMBEDDED_RGBA only */
+    int height;
+    OverlayBytesKind kind;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+} OverlayBytes;
+
+/* Map path read-only. OVERLAY_ERROR_FILE_NOT_FOUND when it cannot be opened,
+   OVERLAY_ERROR_IO for empty files and failed mappings. The bytes are the
+   file's: another process rewriting it changes them, and on POSIX
+   truncating it makes reads past the new end fault (SIGBUS). Keep mappings
+   only as long as the decode needs them. */
+OverlayError overlay_bytes_map(const char *path, OverlayBytes *out);
+
+/* Like overlay_bytes_map, but the pages may be written through a cast of
+   data: writes are copy-on-write, private to the process and never reach
+   the file */
+OverlayError overlay_bytes_map_private(const char *path, OverlayBytes *out);
+
+/* Borrow the keymap embedded at build time (get_default_keymap, else
+   get_default_keymap_rgba). OVERLAY_ERROR_FILE_NOT_FOUND when the build
+   embeds none. */
+OverlayError overlay_bytes_embedded(OverlayBytes *out);
+
+/* The first of the NULL-terminated paths that maps, falling back to the
+   embedded keymap */
+OverlayError overlay_bytes_open(const char *const *paths, OverlayBytes *out);
+
+/* Unmap (borrowed bytes need nothing) and reset b to OVERLAY_BYTES_NONE */
+void overlay_bytes_release(OverlayBytes *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLAY_BYTES_H */
@@ -0,0 +1,270 @@
+#include "overlay_disk_cache.h"
+#include "overlay_bytes.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#ifdef _WIN32
+#define CACHE_SEP "\\"
+#else
+#define CACHE_SEP "/"
+#endif
+
+#define CACHE_MAGIC "KLOC"
+#define CACHE_VERSION 3u
+#define CACHE_EXT ".ovc"
+#define CACHE_MAX_DIM 65535
+
+/* Fixed-size header in native byte order; the cache never leaves the
+   machine. 32 bytes, so the pixels after it stay aligned in the mapping. */
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    int32_t width;
+    int32_t height;
+    uint32_t reserved[2];
+} CacheHeader;
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint64_t overlay_disk_cache_source_id(const unsigned char *source, size_t len) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    if (source) hash = fnv1a(hash, source, len);
+    uint64_t source_len = (uint64_t)len;
+    return fnv1a(hash, &source_len, sizeof(source_len));
+}
+
+uint64_t overlay_disk_cache_key(uint64_t source_id, int max_width, int max_height,
+                                OverlayResizeFilter filter) {
+    int32_t params[4];
+    params[0] = (int32_t)CACHE_VERSION;
+    params[1] = max_width;
+    params[2] = max_height;
+    params[3] = (int32_t)filter;
+    return fnv1a(source_id, params, sizeof(params));
+}
+
+static void entry_path(char *buf, size_t size, const char *dir, uint64_t key, const char *ext) {
+    snprintf(buf, size, "%s" CACHE_SEP "%016llx%s", dir, (unsigned long long)key, ext);
+}
+
+static void release_mapping(void *owner) {
+    overlay_bytes_release((OverlayBytes *)owner);
+    free(owner);
+}
+
+/* Point out at the pixels of a validated entry. The overlay keeps the
+   mapping (copy-on-write, so base edits stay private) and free_overlay
+   unmaps it. */
+static OverlayError read_entry(OverlayBytes *m, uint64_t key, Overlay *out) {
+    CacheHeader h;
+    if (m->size < sizeof(h)) return OVERLAY_ERROR_DECODE_FAILED;
+    memcpy(&h, m->data, sizeof(h));
+    if (memcmp(h.magic, CACHE_MAGIC, 4) != 0 || h.version != CACHE_VERSION || h.key != key ||
+        h.width < 1 || h.height < 1 || h.width > CACHE_MAX_DIM || h.height > CACHE_MAX_DIM) {
+        return OVERLAY_ERROR_DECODE_FAILED;
+    }
+    if (m->size != sizeof(h) + (size_t)h.width * h.height * 4) {
+        return OVERLAY_ERROR_DECODE_FAILED;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->base = (unsigned char *)m->data + sizeof(h);
+    out->data = out->base;
+    out->width = h.width;
+    out->height = h.height;
+    out->channels = 4;
+    out->cached_opacity = 1.0f;
+    out->base_owner = m;
+    out->base_release = release_mapping;
+    overlay_mark_dirty(out, 0, 0, out->width, out->height);
+    return OVERLAY_OK;
+}
+
+OverlayError overlay_disk_cache_load(const char *dir, uint64_t key, Overlay *out) {
+    if (!dir || !out) return OVERLAY_ERROR_NULL_PARAM;
+
+    char path[PATH_MAX];
+    entry_path(path, sizeof(path), dir, key, CACHE_EXT);
+    OverlayBytes *m = (OverlayBytes *)malloc(sizeof(OverlayBytes));
+    if (!m) return OVERLAY_ERROR_OUT_OF_MEMORY;
+    if (overlay_bytes_map_private(path, m) != OVERLAY_OK) {
+        free(m);
+        return OVERLAY_ERROR_FILE_NOT_FOUND;
+    }
+    OverlayError err = read_entry(m, key, out);
+    if (err != OVERLAY_OK) release_mapping(m);
+
+    if (err == OVERLAY_ERROR_DECODE_FAILED) {
+        remove(path);
+    } else if (err == OVERLAY_OK) {
+        /* Recently used entries survive eviction */
+#ifdef _WIN32
+        _utime(path, NULL);
+#else
+        utime(path, NULL);
+#endif
+    }
+    return err;
+}
+
+static int make_dir(const char *path) {
+#ifdef _WIN32
+    return CreateDirectoryA(path, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+/* mkdir -p */
+static int ensure_dir(const char *dir) {
+    char buf[PATH_MAX];
+    size_t len = strlen(dir);
+    if (len == 0 || len >= sizeof(buf)) return 0;
+    memcpy(buf, dir, len + 1);
+    for (size_t i = 1; i < len; i++) {
+        if (buf[i] != '/' && buf[i] != '\\') continue;
+        if (buf[i - 1] == ':') continue; /* drive root */
+        char c = buf[i];
+        buf[i] = '\0';
+        make_dir(buf);
+        buf[i] = c;
+    }
+    return make_dir(buf);
+}
+
+OverlayError overlay_disk_cache_store(const char *dir, uint64_t key, const Overlay *img) {
+    if (!dir || !img || !img->base) return OVERLAY_ERROR_NULL_PARAM;
+    if (!ensure_dir(dir)) return OVERLAY_ERROR_IO;
+
+    CacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CACHE_MAGIC, 4);
+    h.version = CACHE_VERSION;
+    h.key = key;
+    h.width = img->width;
+    h.height = img->height;
+
+    char tmp[PATH_MAX], path[PATH_MAX];
+    entry_path(tmp, sizeof(tmp), dir, key, ".tmp");
+    entry_path(path, sizeof(path), dir, key, CACHE_EXT);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return OVERLAY_ERROR_IO;
+    size_t bytes = (size_t)img->width * img->height * 4;
+    int ok = fwrite(&h, sizeof(h), 1, f) == 1 && fwrite(img->base, 1, bytes, f) == bytes;
+    if (fclose(f) != 0) ok = 0;
+#ifdef _WIN32
+    if (ok) ok = MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    if (ok) ok = rename(tmp, path) == 0;
+#endif
+    if (!ok) {
+        remove(tmp);
+        return OVERLAY_ERROR_IO;
+    }
+    return OVERLAY_OK;
+}
+
+typedef struct {
+    char name[32];
+    uint64_t size;
+    int64_t mtime;
+} CacheEntry;
+
+static int older_first(const void *a, const void *b) {
+    const CacheEntry *x = (const CacheEntry *)a;
+    const CacheEntry *y = (const CacheEntry *)b;
+    if (x->mtime != y->mtime) return x->mtime < y->mtime ? -1 : 1;
+    return strcmp(x->name, y->name);
+}
+
+static int add_entry(CacheEntry **list, int *count, int *cap, const char *name,
+                     uint64_t size, int64_t mtime) {
+    size_t len = strlen(name);
+    size_t ext = strlen(CACHE_EXT);
+    if (len <= ext || len >= sizeof((*list)->name) || strcmp(name + len - ext, CACHE_EXT) != 0) {
+        return 1;
+    }
+    if (*count == *cap) {
+        int ncap = *cap ? *cap * 2 : 16;
+        CacheEntry *grown = (CacheEntry *)realloc(*list, (size_t)ncap * sizeof(CacheEntry));
+        if (!grown) return 0;
+        *list = grown;
+        *cap = ncap;
+    }
+    CacheEntry *e = &(*list)[(*count)++];
+    memcpy(e->name, name, len + 1);
+    e->size = size;
+    e->mtime = mtime;
+    return 1;
+}
+
+void overlay_disk_cache_evict(const char *dir, size_t max_bytes, const uint64_t *keep) {
+    if (!dir) return;
+    char kept[32] = "";
+    if (keep) snprintf(kept, sizeof(kept), "%016llx" CACHE_EXT, (unsigned long long)*keep);
+
+    CacheEntry *list = NULL;
+    int count = 0, cap = 0;
+    char path[PATH_MAX];
+#ifdef _WIN32
+    WIN32_FIND_DATAA fd;
+    snprintf(path, sizeof(path), "%s\\*" CACHE_EXT, dir);
+    HANDLE find = FindFirstFileA(path, &fd);
+    if (find == INVALID_HANDLE_VALUE) return;
+    do {
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+        uint64_t size = ((uint64_t)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
+        int64_t mtime = (int64_t)(((uint64_t)fd.ftLastWriteTime.dwHighDateTime << 32) |
+                                  fd.ftLastWriteTime.dwLowDateTime);
+        if (!add_entry(&list, &count, &cap, fd.cFileName, size, mtime)) break;
+    } while (FindNextFileA(find, &fd));
+    FindClose(find);
+#else
+    DIR *d = opendir(dir);
+    if (!d) return;
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        if (!add_entry(&list, &count, &cap, de->d_name, (uint64_t)st.st_size,
+                       (int64_t)st.st_mtime)) break;
+    }
+    closedir(d);
+#endif
+
+    uint64_t total = 0;
+    for (int i = 0; i < count; i++) total += list[i].size;
+    if (total > max_bytes) {
+        qsort(list, (size_t)count, sizeof(CacheEntry), older_first);
+        for (int i = 0; i < count && total > max_bytes; i++) {
+            if (strcmp(list[i].name, kept) == 0) continue;
+            snprintf(path, sizeof(path), "%s" CACHE_SEP "%s", dir, list[i].name);
+            if (remove(path) == 0) total -= list[i].size;
+        }
+    }
+    free(list);
+}
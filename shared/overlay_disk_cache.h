@@ -0,0 +1,53 @@
+#ifndef OVERLAY_DISK_CACHE_H
+#define OVERLAY_DISK_CACHE_H
+
+/* Resized overlay pixels persisted across launches. Each entry is one file
+   holding the resized base, so a warm start maps the file instead of
+   decoding and resizing the PNG; effects are re-derived from it, which is
+   one pass and keeps entries at a single image's size. Entries are keyed by
+   overlay_disk_cache_key; a changed source or size gives a new key, and
+   stale entries age out through overlay_disk_cache_evict. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "overlay.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default size bound for overlay_disk_cache_evict. A single entry may
+   exceed it (a 5K overlay is about 59 MB); the kept key survives anyway. */
+#define OVERLAY_DISK_CACHE_MAX_BYTES ((size_t)64 * 1024 * 1024)
+
+/* FNV-1a over the encoded source bytes. Kept with the decoded source, it
+   lets later keys be made after the file is unmapped. */
+uint64_t overlay_disk_cache_source_id(const unsigned char *source, size_t len);
+
+/* Entry key for a source (overlay_disk_cache_source_id), the requested
+   bounds and the resize filter */
+uint64_t overlay_disk_cache_key(uint64_t source_id, int max_width, int max_height,
+                                OverlayResizeFilter filter);
+
+/* Fill out from the entry for key. Returns OVERLAY_ERROR_FILE_NOT_FOUND on a
+   miss; an entry that fails validation is deleted and reported as
+   OVERLAY_ERROR_DECODE_FAILED. Hits refresh the entry's modification time,
+   which is what eviction orders by. The overlay comes back without effects
+   and borrows its base from a copy-on-write mapping of the entry, which
+   free_overlay releases. */
+OverlayError overlay_disk_cache_load(const char *dir, uint64_t key, Overlay *out);
+
+/* Write img's base under key, creating dir if needed. The file is written to a
+   temporary name and renamed, so readers never see a partial entry. */
+OverlayError overlay_disk_cache_store(const char *dir, uint64_t key, const Overlay *img);
+
+/* Delete the least recently used entries until the cache holds at most
+   max_bytes. The entry for *keep, when keep is not NULL, is never deleted:
+   pass the key just stored so an entry larger than the bound survives. */
+void overlay_disk_cache_evict(const char *dir, size_t max_bytes, const uint64_t *keep);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLAY_DISK_CACHE_H */
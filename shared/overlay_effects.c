@@ -0,0 +1,164 @@
+#include "overlay_effects.h"
+#include <math.h>
+#include <string.h>
+
+static float clamp_unit(float v) {
+    if (v < 0.0f) return 0.0f;
+    if (v > 1.0f) return 1.0f;
+    return v;
+}
+
+static float clamp_byte(float v) {
+    if (v < 0.0f) return 0.0f;
+    if (v > 255.0f) return 255.0f;
+    return v;
+}
+
+static int is_per_channel(OverlayEffectType type) {
+    return type != OVERLAY_EFFECT_GRAYSCALE;
+}
+
+/* One colour channel through effects [begin, end). Values are clamped after
+   every effect, as separate 8-bit passes would, but not rounded until the
+   end so folding the chain does not add error. */
+static float eval_color(const OverlayEffect *effects, int begin, int end, int channel, float x) {
+    for (int i = begin; i < end; i++) {
+        const OverlayEffect *e = &effects[i];
+        switch (e->type) {
+            case OVERLAY_EFFECT_INVERT:
+                x = 255.0f - x;
+                break;
+            case OVERLAY_EFFECT_TINT:
+                x += ((float)e->color[channel] - x) * clamp_unit(e->value);
+                break;
+            case OVERLAY_EFFECT_BRIGHTNESS_CONTRAST:
+                x = (x - 127.5f) * e->value2 + 127.5f + e->value * 255.0f;
+                break;
+            case OVERLAY_EFFECT_GAMMA:
+                x = 255.0f * powf(x / 255.0f, 1.0f / e->value);
+                break;
+            default:
+                break;
+        }
+        x = clamp_byte(x);
+    }
+    return x;
+}
+
+static float eval_alpha(const OverlayEffect *effects, int begin, int end, float x) {
+    for (int i = begin; i < end; i++) {
+        const OverlayEffect *e = &effects[i];
+        if (e->type == OVERLAY_EFFECT_OPACITY) {
+            x *= clamp_unit(e->value);
+        } else if (e->type == OVERLAY_EFFECT_ALPHA_THRESHOLD) {
+            if (x < clamp_unit(e->value) * 255.0f) x = 0.0f;
+        }
+    }
+    return x;
+}
+
+static void build_stage(OverlayEffectStage *stage, const OverlayEffect *effects,
+                        int begin, int end) {
+    stage->lut_identity = 1;
+    stage->gray_weight = 0;
+    for (int v = 0; v < 256; v++) {
+        for (int c = 0; c < 3; c++) {
+            float x = eval_color(effects, begin, end, c, (float)v);
+            stage->lut[c][v] = (unsigned char)(x + 0.5f);
+        }
+        /* Alpha truncates like apply_effects' (unsigned char)(a * opacity) */
+        stage->lut[3][v] = (unsigned char)clamp_byte(eval_alpha(effects, begin, end, (float)v));
+        for (int c = 0; c < 4; c++) {
+            if (stage->lut[c][v] != v) stage->lut_identity = 0;
+        }
+    }
+}
+
+int overlay_effect_program_compile(OverlayEffectProgram *program,
+                                   const OverlayEffect *effects, int count) {
+    if (!program || count < 0 || count > OVERLAY_MAX_EFFECT_CHAIN) return 0;
+    if (count > 0 && !effects) return 0;
+
+    int opacity_count = 0;
+    int invert = 0;
+    float opacity = 1.0f;
+    int simple = 1;
+    for (int i = 0; i < count; i++) {
+        switch (effects[i].type) {
+            case OVERLAY_EFFECT_OPACITY:
+                opacity = effects[i].value;
+                opacity_count++;
+                break;
+            case OVERLAY_EFFECT_INVERT:
+                invert ^= 1;
+                break;
+            case OVERLAY_EFFECT_GAMMA:
+                if (!(effects[i].value > 0.0f)) return 0;
+                simple = 0;
+                break;
+            case OVERLAY_EFFECT_TINT:
+            case OVERLAY_EFFECT_BRIGHTNESS_CONTRAST:
+            case OVERLAY_EFFECT_GRAYSCALE:
+            case OVERLAY_EFFECT_ALPHA_THRESHOLD:
+                simple = 0;
+                break;
+            default:
+                return 0;
+        }
+    }
+
+    program->simple = simple && opacity_count <= 1;
+    program->stage_count = 0;
+    if (program->simple) {
+        overlay_effect_params_init(&program->params, opacity, invert);
+        program->identity = program->params.alpha_identity && !program->params.invert;
+        return 1;
+    }
+
+    /* Split at grayscale effects; each stage is tables then an optional mix */
+    int begin = 0;
+    for (int i = 0; i <= count; i++) {
+        if (i < count && is_per_channel(effects[i].type)) continue;
+        OverlayEffectStage *stage = &program->stages[program->stage_count];
+        build_stage(stage, effects, begin, i);
+        if (i < count) {
+            stage->gray_weight = (int)(clamp_unit(effects[i].value) * 256.0f + 0.5f);
+        }
+        if (!stage->lut_identity || stage->gray_weight) program->stage_count++;
+        begin = i + 1;
+    }
+    program->identity = program->stage_count == 0;
+    return 1;
+}
+
+void overlay_effect_program_run(const OverlayEffectProgram *program,
+                                const unsigned char *src, unsigned char *dst, size_t count) {
+    if (program->stage_count == 0) {
+        if (src != dst) memcpy(dst, src, count * 4);
+        return;
+    }
+    for (size_t i = 0; i < count; i++, src += 4, dst += 4) {
+        unsigned int r = src[0], g = src[1], b = src[2], a = src[3];
+        for (int s = 0; s < program->stage_count; s++) {
+            const OverlayEffectStage *stage = &program->stages[s];
+            if (!stage->lut_identity) {
+                r = stage->lut[0][r];
+                g = stage->lut[1][g];
+                b = stage->lut[2][b];
+                a = stage->lut[3][a];
+            }
+            if (stage->gray_weight) {
+                /* Rec.601 luma in 8.8 fixed point, then a rounded mix */
+                unsigned int y = (77 * r + 150 * g + 29 * b + 128) >> 8;
+                unsigned int w = (unsigned int)stage->gray_weight;
+                r = (r * (256 - w) + y * w + 128) >> 8;
+                g = (g * (256 - w) + y * w + 128) >> 8;
+                b = (b * (256 - w) + y * w + 128) >> 8;
+            }
+        }
+        dst[0] = (unsigned char)r;
+        dst[1] = (unsigned char)g;
+        dst[2] = (unsigned char)b;
+        dst[3] = (unsigned char)a;
+    }
+}
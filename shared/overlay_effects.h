@@ -0,0 +1,44 @@
+#ifndef OVERLAY_EFFECTS_H
+#define OVERLAY_EFFECTS_H
+
+/* Internal effect-chain compiler used by overlay.c. The public API is
+   apply_effect_chain / apply_effect_chain_copy in overlay.h. */
+
+#include <stddef.h>
+#include "overlay.h"
+#include "overlay_simd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per-channel tables (R, G, B, A) followed by an optional grayscale mix.
+   Every run of per-channel effects between two grayscale effects becomes one
+   stage, evaluated in float and rounded once when the table is built. */
+typedef struct {
+    unsigned char lut[4][256];
+    int lut_identity;   /* tables are the identity, skip the lookups */
+    int gray_weight;    /* 0 = none, otherwise mix toward luma by weight / 256 */
+} OverlayEffectStage;
+
+typedef struct {
+    int identity;       /* chain leaves every pixel unchanged */
+    int simple;         /* only invert and <= 1 opacity: run params on the SIMD kernels */
+    OverlayEffectParams params;
+    int stage_count;
+    OverlayEffectStage stages[OVERLAY_MAX_EFFECT_CHAIN + 1];
+} OverlayEffectProgram;
+
+/* Returns 0 for an invalid chain (unknown type, gamma <= 0, too long) */
+int overlay_effect_program_compile(OverlayEffectProgram *program,
+                                   const OverlayEffect *effects, int count);
+
+/* Scalar stage evaluator for non-simple programs; src == dst runs in place */
+void overlay_effect_program_run(const OverlayEffectProgram *program,
+                                const unsigned char *src, unsigned char *dst, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLAY_EFFECTS_H */
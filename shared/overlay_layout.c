@@ -0,0 +1,888 @@
+#include "overlay_layout.h"
+#include "overlay_simd.h"
+#include "overlay_parallel.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LABEL_MAX 48
+
+typedef struct {
+    float x, y, w, h;
+    float font_size;          /* < 0: layout default */
+    unsigned char color[4];   /* straight RGBA */
+    unsigned char legend[4];
+    int has_color;
+    int has_legend;
+    char label[LABEL_MAX];
+} LayoutKey;
+
+struct OverlayLayout {
+    float width;
+    float height;
+    unsigned char background[4];
+    unsigned char key_color[4];
+    unsigned char legend_color[4];
+    float radius;
+    float gap;
+    float font_size;
+    float stroke;
+    LayoutKey *keys;
+    int key_count;
+};
+
+/* ---- JSON ------------------------------------------------------------- */
+
+/* Just enough JSON for layout descriptions: objects, arrays, strings,
+   numbers and literals. Unknown fields are skipped. */
+typedef struct {
+    const char *p;
+    const char *end;
+} Json;
+
+#define JSON_MAX_DEPTH 16
+
+static void skip_ws(Json *j) {
+    while (j->p < j->end && (*j->p == ' ' || *j->p == '\t' || *j->p == '\n' || *j->p == '\r')) {
+        j->p++;
+    }
+}
+
+static int accept(Json *j, char c) {
+    skip_ws(j);
+    if (j->p < j->end && *j->p == c) {
+        j->p++;
+        return 1;
+    }
+    return 0;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* Read a string into out (truncated to cap - 1; out may be NULL to skip).
+   Escapes outside ASCII come back as '?': the legend font has nothing else. */
+static int parse_string(Json *j, char *out, size_t cap) {
+    if (!accept(j, '"')) return 0;
+    size_t n = 0;
+    while (j->p < j->end && *j->p != '"') {
+        char c = *j->p++;
+        if ((unsigned char)c < 0x20) return 0;
+        if (c == '\\') {
+            if (j->p >= j->end) return 0;
+            char e = *j->p++;
+            switch (e) {
+                case '"': case '\\': case '/': c = e; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u': {
+                    if (j->end - j->p < 4) return 0;
+                    int v = 0;
+                    for (int i = 0; i < 4; i++) {
+                        int d = hex_digit(j->p[i]);
+                        if (d < 0) return 0;
+                        v = v * 16 + d;
+                    }
+                    j->p += 4;
+                    c = v < 0x80 ? (char)v : '?';
+                    break;
+                }
+                default:
+                    return 0;
+            }
+        } else if ((unsigned char)c >= 0x80) {
+            /* One '?' per UTF-8 sequence: skip the continuation bytes */
+            while (j->p < j->end && ((unsigned char)*j->p & 0xC0) == 0x80) j->p++;
+            c = '?';
+        }
+        if (out && n + 1 < cap) out[n++] = c;
+    }
+    if (j->p >= j->end) return 0;
+    j->p++;
+    if (out && cap) out[n] = '\0';
+    return 1;
+}
+
+static int parse_number(Json *j, float *out) {
+    skip_ws(j);
+    char buf[64];
+    size_t n = 0;
+    while (j->p < j->end && n + 1 < sizeof(buf) &&
+           ((*j->p >= '0' && *j->p <= '9') || *j->p == '-' || *j->p == '+' ||
+            *j->p == '.' || *j->p == 'e' || *j->p == 'E')) {
+        buf[n++] = *j->p++;
+    }
+    buf[n] = '\0';
+    char *end;
+    double v = strtod(buf, &end);
+    if (n == 0 || *end != '\0' || !isfinite(v)) return 0;
+    *out = (float)v;
+    return 1;
+}
+
+static int skip_literal(Json *j, const char *word) {
+    size_t n = strlen(word);
+    if ((size_t)(j->end - j->p) < n || memcmp(j->p, word, n) != 0) return 0;
+    j->p += n;
+    return 1;
+}
+
+static int skip_value(Json *j, int depth);
+
+/* Object members: returns 1 with key filled and j at the value, 0 at the
+   closing brace, -1 on malformed input. *first starts at 1. */
+static int next_member(Json *j, int *first, char *key, size_t cap) {
+    if (accept(j, '}')) return 0;
+    if (!*first && !accept(j, ',')) return -1;
+    *first = 0;
+    if (!parse_string(j, key, cap) || !accept(j, ':')) return -1;
+    return 1;
+}
+
+/* Array elements: returns 1 with j at the element, 0 at the closing
+   bracket, -1 on malformed input */
+static int next_element(Json *j, int *first) {
+    if (accept(j, ']')) return 0;
+    if (!*first && !accept(j, ',')) return -1;
+    *first = 0;
+    return 1;
+}
+
+static int skip_value(Json *j, int depth) {
+    if (depth > JSON_MAX_DEPTH) return 0;
+    skip_ws(j);
+    if (j->p >= j->end) return 0;
+    int first = 1, r;
+    float f;
+    switch (*j->p) {
+        case '{': {
+            char key[8];
+            j->p++;
+            while ((r = next_member(j, &first, key, sizeof(key))) == 1) {
+                if (!skip_value(j, depth + 1)) return 0;
+            }
+            return r == 0;
+        }
+        case '[':
+            j->p++;
+            while ((r = next_element(j, &first)) == 1) {
+                if (!skip_value(j, depth + 1)) return 0;
+            }
+            return r == 0;
+        case '"':
+            return parse_string(j, NULL, 0);
+        case 't':
+            return skip_literal(j, "true");
+        case 'f':
+            return skip_literal(j, "false");
+        case 'n':
+            return skip_literal(j, "null");
+        default:
+            return parse_number(j, &f);
+    }
+}
+
+/* "#RRGGBB" or "#RRGGBBAA" */
+static int parse_color(Json *j, unsigned char out[4]) {
+    char s[16];
+    if (!parse_string(j, s, sizeof(s)) || s[0] != '#') return 0;
+    size_t len = strlen(s);
+    if (len != 7 && len != 9) return 0;
+    out[3] = 255;
+    for (size_t i = 0; i < (len - 1) / 2; i++) {
+        int hi = hex_digit(s[1 + 2 * i]), lo = hex_digit(s[2 + 2 * i]);
+        if (hi < 0 || lo < 0) return 0;
+        out[i] = (unsigned char)(hi * 16 + lo);
+    }
+    return 1;
+}
+
+static int parse_key(Json *j, LayoutKey *key, int *has_x, int *has_y) {
+    if (!accept(j, '{')) return 0;
+    char name[32];
+    int first = 1, r;
+    while ((r = next_member(j, &first, name, sizeof(name))) == 1) {
+        int ok;
+        if (strcmp(name, "x") == 0) ok = *has_x = parse_number(j, &key->x);
+        else if (strcmp(name, "y") == 0) ok = *has_y = parse_number(j, &key->y);
+        else if (strcmp(name, "w") == 0) ok = parse_number(j, &key->w);
+        else if (strcmp(name, "h") == 0) ok = parse_number(j, &key->h);
+        else if (strcmp(name, "font_size") == 0) ok = parse_number(j, &key->font_size);
+        else if (strcmp(name, "label") == 0) ok = parse_string(j, key->label, sizeof(key->label));
+        else if (strcmp(name, "color") == 0) ok = key->has_color = parse_color(j, key->color);
+        else if (strcmp(name, "legend_color") == 0) ok = key->has_legend = parse_color(j, key->legend);
+        else ok = skip_value(j, 1);
+        if (!ok) return 0;
+    }
+    return r == 0 && key->w > 0.0f && key->h > 0.0f;
+}
+
+static int parse_keys(Json *j, OverlayLayout *layout) {
+    if (!accept(j, '[')) return 0;
+    int cap = 0, first = 1, r;
+    while ((r = next_element(j, &first)) == 1) {
+        if (layout->key_count == cap) {
+            cap = cap ? cap * 2 : 64;
+            LayoutKey *grown = (LayoutKey *)realloc(layout->keys, (size_t)cap * sizeof(LayoutKey));
+            if (!grown) return 0;
+            layout->keys = grown;
+        }
+        LayoutKey *key = &layout->keys[layout->key_count];
+        memset(key, 0, sizeof(*key));
+        key->w = key->h = 1.0f;
+        key->font_size = -1.0f;
+        int has_x = 0, has_y = 0;
+        if (!parse_key(j, key, &has_x, &has_y)) return 0;
+        /* Omitted positions continue the row */
+        if (layout->key_count > 0) {
+            const LayoutKey *prev = key - 1;
+            if (!has_x) key->x = prev->x + prev->w;
+            if (!has_y) key->y = prev->y;
+        }
+        layout->key_count++;
+    }
+    return r == 0;
+}
+
+int overlay_layout_detect(const unsigned char *bytes, size_t len) {
+    if (!bytes) return 0;
+    Json j = {(const char *)bytes, (const char *)bytes + len};
+    /* UTF-8 byte order mark */
+    if (len >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF) j.p += 3;
+    return accept(&j, '{');
+}
+
+OverlayError overlay_layout_parse(const char *json, size_t len, OverlayLayout **out) {
+    if (!json || !out) return OVERLAY_ERROR_NULL_PARAM;
+    *out = NULL;
+    OverlayLayout *layout = (OverlayLayout *)calloc(1, sizeof(OverlayLayout));
+    if (!layout) return OVERLAY_ERROR_OUT_OF_MEMORY;
+    static const unsigned char key_color[4] = {0x2B, 0x2B, 0x2B, 0xE6};
+    memcpy(layout->key_color, key_color, 4);
+    memset(layout->legend_color, 255, 4);
+    layout->radius = 0.12f;
+    layout->gap = 0.08f;
+    layout->font_size = 0.28f;
+    layout->stroke = 0.12f;
+
+    Json j = {json, json + len};
+    if (len >= 3 && memcmp(json, "\xEF\xBB\xBF", 3) == 0) j.p += 3;
+    int ok = accept(&j, '{');
+    char name[32];
+    int first = 1, r = -1;
+    while (ok && (r = next_member(&j, &first, name, sizeof(name))) == 1) {
+        if (strcmp(name, "width") == 0) ok = parse_number(&j, &layout->width);
+        else if (strcmp(name, "height") == 0) ok = parse_number(&j, &layout->height);
+        else if (strcmp(name, "radius") == 0) ok = parse_number(&j, &layout->radius);
+        else if (strcmp(name, "gap") == 0) ok = parse_number(&j, &layout->gap);
+        else if (strcmp(name, "font_size") == 0) ok = parse_number(&j, &layout->font_size);
+        else if (strcmp(name, "stroke") == 0) ok = parse_number(&j, &layout->stroke);
+        else if (strcmp(name, "background") == 0) ok = parse_color(&j, layout->background);
+        else if (strcmp(name, "key_color") == 0) ok = parse_color(&j, layout->key_color);
+        else if (strcmp(name, "legend_color") == 0) ok = parse_color(&j, layout->legend_color);
+        else if (strcmp(name, "keys") == 0) ok = parse_keys(&j, layout);
+        else ok = skip_value(&j, 1);
+    }
+    if (!ok || r != 0 || layout->key_count == 0 || layout->width < 0.0f || layout->height < 0.0f) {
+        overlay_layout_free(layout);
+        return OVERLAY_ERROR_DECODE_FAILED;
+    }
+
+    /* Layout-wide defaults may follow "keys" in the object */
+    float extent_w = 0.0f, extent_h = 0.0f;
+    for (int i = 0; i < layout->key_count; i++) {
+        LayoutKey *key = &layout->keys[i];
+        if (!key->has_color) memcpy(key->color, layout->key_color, 4);
+        if (!key->has_legend) memcpy(key->legend, layout->legend_color, 4);
+        if (key->font_size < 0.0f) key->font_size = layout->font_size;
+        if (key->x + key->w > extent_w) extent_w = key->x + key->w;
+        if (key->y + key->h > extent_h) extent_h = key->y + key->h;
+    }
+    if (layout->width == 0.0f) layout->width = extent_w;
+    if (layout->height == 0.0f) layout->height = extent_h;
+    if (!(layout->width > 0.0f && layout->height > 0.0f)) {
+        overlay_layout_free(layout);
+        return OVERLAY_ERROR_DECODE_FAILED;
+    }
+    *out = layout;
+    return OVERLAY_OK;
+}
+
+void overlay_layout_size(const OverlayLayout *layout, float *width, float *height) {
+    if (width) *width = layout ? layout->width : 0.0f;
+    if (height) *height = layout ? layout->height : 0.0f;
+}
+
+void overlay_layout_free(OverlayLayout *layout) {
+    if (!layout) return;
+    free(layout->keys);
+    free(layout);
+}
+
+/* ---- Stroke font ------------------------------------------------------ */
+
+/* Printable ASCII as polylines on a grid: x 0..6, y 0 at cap height, 3 at
+   x-height, 8 on the baseline and 11 ('B') at the descender. Points are two
+   base-12 digits; a space lifts the pen. A stroke of a single point (or one
+   point repeated) draws a dot. */
+static const char *const g_glyphs[95] = {
+    /* ' ' */ "",
+    /* '!' */ "3035 3838",
+    /* '"' */ "2022 4042",
+    /* '#' */ "2127 4147 0363 0565",
+    /* '$' */ "615010010314546567581807 3039",
+    /* '%' */ "0860 0010110100 5767685857",
+    /* '&' */ "681311203041420607183865",
+    /* ''' */ "3032",
+    /* '(' */ "40222648",
+    /* ')' */ "20424628",
+    /* '*' */ "3135 1254 1452",
+    /* '+' */ "3236 1454",
+    /* ',' */ "373829",
+    /* '-' */ "1454",
+    /* '.' */ "3838",
+    /* '/' */ "0860",
+    /* '0' */ "105061675818070110 5117",
+    /* '1' */ "123038 1858",
+    /* '2' */ "01105061630868",
+    /* '3' */ "01105061635424 546567581807",
+    /* '4' */ "500666 5058",
+    /* '5' */ "600004546567581807",
+    /* '6' */ "615010010718586765541405",
+    /* '7' */ "006028",
+    /* '8' */ "105061635414030110 1405071858676554",
+    /* '9' */ "645414030110506167581807",
+    /* ':' */ "3434 3838",
+    /* ';' */ "3434 373829",
+    /* '<' */ "511457",
+    /* '=' */ "1353 1555",
+    /* '>' */ "115417",
+    /* '?' */ "01105061623435 3838",
+    /* '@' */ "5818070110506166564643232646",
+    /* 'A' */ "083068 1555",
+    /* 'B' */ "08005061635404 5465675808",
+    /* 'C' */ "6150100107185867",
+    /* 'D' */ "00406266480800",
+    /* 'E' */ "60000868 0444",
+    /* 'F' */ "600008 0444",
+    /* 'G' */ "61501001071858676434",
+    /* 'H' */ "0008 6068 0464",
+    /* 'I' */ "1050 3038 1858",
+    /* 'J' */ "2060 505748180706",
+    /* 'K' */ "0008 6004 2368",
+    /* 'L' */ "000868",
+    /* 'M' */ "0800346068",
+    /* 'N' */ "08006860",
+    /* 'O' */ "105061675818070110",
+    /* 'P' */ "08005061635404",
+    /* 'Q' */ "105061675818070110 4668",
+    /* 'R' */ "08005061635404 3468",
+    /* 'S' */ "615010010314546567581807",
+    /* 'T' */ "0060 3038",
+    /* 'U' */ "000718586760",
+    /* 'V' */ "003860",
+    /* 'W' */ "0018345860",
+    /* 'X' */ "0068 6008",
+    /* 'Y' */ "003460 3438",
+    /* 'Z' */ "00600868",
+    /* '[' */ "40202848",
+    /* '\' */ "0068",
+    /* ']' */ "20404828",
+    /* '^' */ "133053",
+    /* '_' */ "0969",
+    /* '`' */ "2031",
+    /* 'a' */ "6453130407185867 6368",
+    /* 'b' */ "0008 0413536467581807",
+    /* 'c' */ "6453130407185867",
+    /* 'd' */ "6068 6453130407185867",
+    /* 'e' */ "05656453130407185867",
+    /* 'f' */ "50302128 0343",
+    /* 'g' */ "636A5B1B0A 6453130407185867",
+    /* 'h' */ "0008 0413536468",
+    /* 'i' */ "233338 3131",
+    /* 'j' */ "434A3B1B0A 4141",
+    /* 'k' */ "0008 5306 2568",
+    /* 'l' */ "20303748",
+    /* 'm' */ "0308 0413233438 3443536468",
+    /* 'n' */ "0308 0413536468",
+    /* 'o' */ "135364675818070413",
+    /* 'p' */ "030B 0413536467581807",
+    /* 'q' */ "636B 6453130407185867",
+    /* 'r' */ "0308 05235364",
+    /* 's' */ "6453130415556667581807",
+    /* 't' */ "21273848 0343",
+    /* 'u' */ "0307185867 6368",
+    /* 'v' */ "033863",
+    /* 'w' */ "0318355863",
+    /* 'x' */ "0368 6308",
+    /* 'y' */ "0338 631B",
+    /* 'z' */ "03630868",
+    /* '{' */ "40313324353748",
+    /* '|' */ "3039",
+    /* '}' */ "20313344353728",
+    /* '~' */ "051424455564",
+};
+
+#define GLYPH_CAP 8.0f     /* grid units from cap height to baseline */
+#define GLYPH_LINE 13.0f   /* baseline to baseline */
+#define GLYPH_DESCENT 11.0f /* cap height to the descender */
+#define GLYPH_SPACE 2.0f   /* between glyphs */
+#define GLYPH_MAX_POINTS 32
+
+static const char *glyph_for(char c) {
+    return (c >= 0x20 && c < 0x7F) ? g_glyphs[c - 0x20] : g_glyphs['?' - 0x20];
+}
+
+static int grid_digit(char c) {
+    return c >= '0' && c <= '9' ? c - '0' : c - 'A' + 10;
+}
+
+/* Inked width in grid units; *left is where the ink starts */
+static int glyph_extent(char c, int *left) {
+    const char *s = glyph_for(c);
+    int min_x = 6, max_x = 0;
+    for (; *s; s++) {
+        if (*s == ' ') continue;
+        int x = grid_digit(*s++);
+        if (x < min_x) min_x = x;
+        if (x > max_x) max_x = x;
+    }
+    if (min_x > max_x) {
+        /* Space */
+        *left = 0;
+        return 2;
+    }
+    *left = min_x;
+    return max_x - min_x;
+}
+
+static float line_width(const char *line, size_t len) {
+    float width = 0.0f;
+    int left;
+    for (size_t i = 0; i < len; i++) width += (float)glyph_extent(line[i], &left) + GLYPH_SPACE;
+    return len ? width - GLYPH_SPACE : 0.0f;
+}
+
+/* ---- Blend kernels ---------------------------------------------------- */
+
+/* Composite a premultiplied color over `count` premultiplied pixels, scaled
+   by per-pixel coverage (0-255). All kernels round the same way, so every
+   SIMD level renders the same bytes. */
+typedef void (*BlendSpanFn)(unsigned char *dst, const unsigned char *cov, int count,
+                            const unsigned char *color);
+
+static inline unsigned int div255(unsigned int x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static void blend_span_scalar(unsigned char *dst, const unsigned char *cov, int count,
+                              const unsigned char *color) {
+    for (int i = 0; i < count; i++, dst += 4) {
+        unsigned int c = cov[i];
+        if (c == 0) continue;
+        unsigned int sa = div255(color[3] * c);
+        for (int k = 0; k < 4; k++) {
+            dst[k] = (unsigned char)(div255(color[k] * c) + div255(dst[k] * (255 - sa)));
+        }
+    }
+}
+
+#ifdef OVERLAY_ARCH_X86
+OVERLAY_TARGET("sse2")
+static inline __m128i div255_sse2(__m128i x) {
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+/* Two pixels per 16-bit register half */
+OVERLAY_TARGET("sse2")
+static inline __m128i blend2_sse2(__m128i dst, __m128i cov, __m128i color) {
+    __m128i s = div255_sse2(_mm_mullo_epi16(color, cov));
+    __m128i sa = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+    __m128i inv = _mm_sub_epi16(_mm_set1_epi16(255), sa);
+    return _mm_add_epi16(s, div255_sse2(_mm_mullo_epi16(dst, inv)));
+}
+
+OVERLAY_TARGET("sse2")
+static void blend_span_sse2(unsigned char *dst, const unsigned char *cov, int count,
+                            const unsigned char *color) {
+    const __m128i zero = _mm_setzero_si128();
+    uint32_t packed;
+    memcpy(&packed, color, 4);
+    const __m128i solid = _mm_set1_epi32((int)packed);
+    const __m128i color16 = _mm_unpacklo_epi8(solid, zero);
+    const int opaque = color[3] == 255;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32_t c4;
+        memcpy(&c4, cov + i, 4);
+        if (c4 == 0) continue;
+        unsigned char *p = dst + (size_t)i * 4;
+        if (c4 == 0xFFFFFFFFu && opaque) {
+            _mm_storeu_si128((__m128i *)p, solid);
+            continue;
+        }
+        /* c0 c1 c2 c3 -> each repeated across its pixel's four channels */
+        __m128i c = _mm_cvtsi32_si128((int)c4);
+        c = _mm_unpacklo_epi8(c, c);
+        c = _mm_unpacklo_epi16(c, c);
+        __m128i px = _mm_loadu_si128((const __m128i *)p);
+        __m128i lo = blend2_sse2(_mm_unpacklo_epi8(px, zero), _mm_unpacklo_epi8(c, zero), color16);
+        __m128i hi = blend2_sse2(_mm_unpackhi_epi8(px, zero), _mm_unpackhi_epi8(c, zero), color16);
+        _mm_storeu_si128((__m128i *)p, _mm_packus_epi16(lo, hi));
+    }
+    blend_span_scalar(dst + (size_t)i * 4, cov + i, count - i, color);
+}
+#endif
+
+#ifdef OVERLAY_ARCH_NEON
+static inline uint8x8_t div255_neon(uint16x8_t x) {
+    x = vaddq_u16(x, vdupq_n_u16(128));
+    return vshrn_n_u16(vsraq_n_u16(x, x, 8), 8);
+}
+
+static void blend_span_neon(unsigned char *dst, const unsigned char *cov, int count,
+                            const unsigned char *color) {
+    const uint8x8_t cr = vdup_n_u8(color[0]), cg = vdup_n_u8(color[1]);
+    const uint8x8_t cb = vdup_n_u8(color[2]), ca = vdup_n_u8(color[3]);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint8x8_t c = vld1_u8(cov + i);
+        if (vget_lane_u64(vreinterpret_u64_u8(c), 0) == 0) continue;
+        unsigned char *p = dst + (size_t)i * 4;
+        uint8x8x4_t px = vld4_u8(p);
+        uint8x8_t sa = div255_neon(vmull_u8(ca, c));
+        uint8x8_t inv = vmvn_u8(sa);
+        px.val[0] = vadd_u8(div255_neon(vmull_u8(cr, c)), div255_neon(vmull_u8(px.val[0], inv)));
+        px.val[1] = vadd_u8(div255_neon(vmull_u8(cg, c)), div255_neon(vmull_u8(px.val[1], inv)));
+        px.val[2] = vadd_u8(div255_neon(vmull_u8(cb, c)), div255_neon(vmull_u8(px.val[2], inv)));
+        px.val[3] = vadd_u8(sa, div255_neon(vmull_u8(px.val[3], inv)));
+        vst4_u8(p, px);
+    }
+    blend_span_scalar(dst + (size_t)i * 4, cov + i, count - i, color);
+}
+#endif
+
+static BlendSpanFn get_blend_span(void) {
+    switch (overlay_get_simd_level()) {
+#ifdef OVERLAY_ARCH_X86
+        case OVERLAY_SIMD_SSE2:
+        case OVERLAY_SIMD_AVX2:
+            return blend_span_sse2;
+#endif
+#ifdef OVERLAY_ARCH_NEON
+        case OVERLAY_SIMD_NEON:
+            return blend_span_neon;
+#endif
+        default:
+            return blend_span_scalar;
+    }
+}
+
+/* ---- Rasterizer ------------------------------------------------------- */
+
+typedef struct {
+    const OverlayLayout *layout;
+    unsigned char *pixels;
+    int width;
+    int height;
+    float sx; /* pixels per key unit */
+    float sy;
+    BlendSpanFn blend;
+    volatile int failed;
+} RenderCtx;
+
+static void premultiply(const unsigned char straight[4], unsigned char out[4]) {
+    for (int k = 0; k < 3; k++) out[k] = (unsigned char)div255(straight[k] * straight[3]);
+    out[3] = straight[3];
+}
+
+static unsigned char coverage(float c) {
+    if (c <= 0.0f) return 0;
+    if (c >= 1.0f) return 255;
+    return (unsigned char)(c * 255.0f + 0.5f);
+}
+
+/* Pixel-space rounded rectangle: center, half extents, corner radius */
+typedef struct {
+    float cx, cy;
+    float hx, hy;
+    float r;
+} RoundRect;
+
+/* Coverage of pixels [x0, x0 + n) of the row whose center is py, from the
+   signed distance to the edge: one pixel of anti-aliasing across it */
+static void round_rect_row(const RoundRect *rr, float py, int x0, int n, unsigned char *cov) {
+    float qy = fabsf(py - rr->cy) - (rr->hy - rr->r);
+    for (int i = 0; i < n; i++) {
+        float qx = fabsf((float)(x0 + i) + 0.5f - rr->cx) - (rr->hx - rr->r);
+        float ox = qx > 0.0f ? qx : 0.0f, oy = qy > 0.0f ? qy : 0.0f;
+        float inside = qx > qy ? qx : qy;
+        float d = sqrtf(ox * ox + oy * oy) + (inside < 0.0f ? inside : 0.0f) - rr->r;
+        cov[i] = coverage(0.5f - d);
+    }
+}
+
+static void draw_key(RenderCtx *ctx, const LayoutKey *key, int begin, int end,
+                     unsigned char *cov) {
+    const OverlayLayout *layout = ctx->layout;
+    float half_gap = layout->gap * 0.5f;
+    float x0 = (key->x + half_gap) * ctx->sx, x1 = (key->x + key->w - half_gap) * ctx->sx;
+    float y0 = (key->y + half_gap) * ctx->sy, y1 = (key->y + key->h - half_gap) * ctx->sy;
+    if (x1 <= x0 || y1 <= y0) return;
+
+    RoundRect rr;
+    rr.cx = (x0 + x1) * 0.5f;
+    rr.cy = (y0 + y1) * 0.5f;
+    rr.hx = (x1 - x0) * 0.5f;
+    rr.hy = (y1 - y0) * 0.5f;
+    rr.r = layout->radius * (ctx->sx < ctx->sy ? ctx->sx : ctx->sy);
+    if (rr.r > rr.hx) rr.r = rr.hx;
+    if (rr.r > rr.hy) rr.r = rr.hy;
+    if (rr.r < 0.0f) rr.r = 0.0f;
+
+    int ix0 = (int)floorf(x0), ix1 = (int)ceilf(x1);
+    int iy0 = (int)floorf(y0), iy1 = (int)ceilf(y1);
+    if (ix0 < 0) ix0 = 0;
+    if (ix1 > ctx->width) ix1 = ctx->width;
+    if (iy0 < begin) iy0 = begin;
+    if (iy1 > end) iy1 = end;
+    int n = ix1 - ix0;
+    if (n <= 0) return;
+
+    unsigned char color[4];
+    premultiply(key->color, color);
+    /* Rows clear of the corners and the top and bottom edges all have the
+       same coverage: compute it once */
+    float flat0 = y0 + rr.r + 0.5f, flat1 = y1 - rr.r - 0.5f;
+    int flat_ready = 0;
+    for (int y = iy0; y < iy1; y++) {
+        float py = (float)y + 0.5f;
+        unsigned char *row = cov;
+        if (py >= flat0 && py <= flat1) {
+            row = cov + n;
+            if (!flat_ready) {
+                round_rect_row(&rr, rr.cy, ix0, n, row);
+                flat_ready = 1;
+            }
+        } else {
+            round_rect_row(&rr, py, ix0, n, row);
+        }
+        ctx->blend(ctx->pixels + ((size_t)y * ctx->width + ix0) * 4, row, n, color);
+    }
+}
+
+typedef struct {
+    float ax, ay;
+    float bx, by;
+} Segment;
+
+static float segment_distance(const Segment *s, float px, float py) {
+    float pax = px - s->ax, pay = py - s->ay;
+    float bax = s->bx - s->ax, bay = s->by - s->ay;
+    float len2 = bax * bax + bay * bay;
+    float t = len2 > 0.0f ? (pax * bax + pay * bay) / len2 : 0.0f;
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    float dx = pax - bax * t, dy = pay - bay * t;
+    return sqrtf(dx * dx + dy * dy);
+}
+
+/* One glyph with its origin (cap height, left edge) at ox, oy */
+static void draw_glyph(RenderCtx *ctx, char c, float ox, float oy, float unit, float half_width,
+                       const unsigned char *color, int begin, int end, unsigned char *cov) {
+    Segment segs[GLYPH_MAX_POINTS];
+    int count = 0;
+    const char *s = glyph_for(c);
+    while (*s && count < GLYPH_MAX_POINTS) {
+        if (*s == ' ') {
+            s++;
+            continue;
+        }
+        /* One stroke: consecutive points until a space */
+        Segment seg;
+        seg.bx = ox + grid_digit(s[0]) * unit;
+        seg.by = oy + grid_digit(s[1]) * unit;
+        s += 2;
+        do {
+            seg.ax = seg.bx;
+            seg.ay = seg.by;
+            if (*s && *s != ' ') {
+                seg.bx = ox + grid_digit(s[0]) * unit;
+                seg.by = oy + grid_digit(s[1]) * unit;
+                s += 2;
+            }
+            segs[count++] = seg;
+        } while (*s && *s != ' ' && count < GLYPH_MAX_POINTS);
+    }
+    if (count == 0) return;
+
+    float min_x = segs[0].ax, max_x = min_x, min_y = segs[0].ay, max_y = min_y;
+    for (int k = 0; k < count; k++) {
+        min_x = fminf(min_x, fminf(segs[k].ax, segs[k].bx));
+        max_x = fmaxf(max_x, fmaxf(segs[k].ax, segs[k].bx));
+        min_y = fminf(min_y, fminf(segs[k].ay, segs[k].by));
+        max_y = fmaxf(max_y, fmaxf(segs[k].ay, segs[k].by));
+    }
+    float pad = half_width + 1.0f;
+    int ix0 = (int)floorf(min_x - pad), ix1 = (int)ceilf(max_x + pad);
+    int iy0 = (int)floorf(min_y - pad), iy1 = (int)ceilf(max_y + pad);
+    if (ix0 < 0) ix0 = 0;
+    if (ix1 > ctx->width) ix1 = ctx->width;
+    if (iy0 < begin) iy0 = begin;
+    if (iy1 > end) iy1 = end;
+    int n = ix1 - ix0;
+    if (n <= 0) return;
+
+    for (int y = iy0; y < iy1; y++) {
+        float py = (float)y + 0.5f;
+        for (int i = 0; i < n; i++) {
+            float px = (float)(ix0 + i) + 0.5f;
+            float d = segment_distance(&segs[0], px, py);
+            for (int k = 1; k < count; k++) {
+                float dk = segment_distance(&segs[k], px, py);
+                if (dk < d) d = dk;
+            }
+            cov[i] = coverage(half_width + 0.5f - d);
+        }
+        ctx->blend(ctx->pixels + ((size_t)y * ctx->width + ix0) * 4, cov, n, color);
+    }
+}
+
+/* Legend lines centered on the key, scaled down where they would not fit */
+static void draw_label(RenderCtx *ctx, const LayoutKey *key, int begin, int end,
+                       unsigned char *cov) {
+    if (!key->label[0]) return;
+    int lines = 1;
+    float widest = 0.0f;
+    for (const char *line = key->label;; lines++) {
+        size_t len = strcspn(line, "\n");
+        float w = line_width(line, len);
+        if (w > widest) widest = w;
+        if (!line[len]) break;
+        line += len + 1;
+    }
+    float block = GLYPH_CAP + (lines - 1) * GLYPH_LINE;
+
+    float unit = key->font_size * (ctx->sx + ctx->sy) * 0.5f / GLYPH_CAP;
+    float room_w = (key->w - ctx->layout->gap) * ctx->sx * 0.9f;
+    float room_h = (key->h - ctx->layout->gap) * ctx->sy * 0.9f;
+    if (widest > 0.0f && unit * widest > room_w) unit = room_w / widest;
+    if (unit * block > room_h) unit = room_h / block;
+    if (unit <= 0.0f) return;
+    float half_width = ctx->layout->stroke * unit * GLYPH_CAP * 0.5f;
+    /* Thinner strokes fade out rather than thin down */
+    if (half_width < 0.35f) half_width = 0.35f;
+
+    unsigned char color[4];
+    premultiply(key->legend, color);
+    float cx = (key->x + key->w * 0.5f) * ctx->sx;
+    float cy = (key->y + key->h * 0.5f) * ctx->sy;
+    float top = cy - block * unit * 0.5f;
+
+    const char *line = key->label;
+    for (int l = 0; l < lines; l++) {
+        size_t len = strcspn(line, "\n");
+        float x = cx - line_width(line, len) * unit * 0.5f;
+        float y = top + l * GLYPH_LINE * unit;
+        /* Only lines that reach this band */
+        if (y + GLYPH_DESCENT * unit + half_width + 1.0f >= (float)begin &&
+            y - half_width - 1.0f < (float)end) {
+            for (size_t i = 0; i < len; i++) {
+                int left;
+                int width = glyph_extent(line[i], &left);
+                draw_glyph(ctx, line[i], x - left * unit, y, unit, half_width, color, begin, end,
+                           cov);
+                x += (width + GLYPH_SPACE) * unit;
+            }
+        }
+        line += len + (line[len] == '\n');
+    }
+}
+
+static void render_band(void *arg, int begin, int end) {
+    RenderCtx *ctx = (RenderCtx *)arg;
+    const OverlayLayout *layout = ctx->layout;
+    /* Two rows of coverage: per-row scratch and a key's flat interior */
+    unsigned char *cov = (unsigned char *)malloc((size_t)ctx->width * 2);
+    if (!cov) {
+        ctx->failed = 1;
+        return;
+    }
+
+    unsigned char bg[4];
+    premultiply(layout->background, bg);
+    for (int y = begin; y < end; y++) {
+        unsigned char *row = ctx->pixels + (size_t)y * ctx->width * 4;
+        for (int x = 0; x < ctx->width; x++) memcpy(row + (size_t)x * 4, bg, 4);
+    }
+    for (int i = 0; i < layout->key_count; i++) draw_key(ctx, &layout->keys[i], begin, end, cov);
+    for (int i = 0; i < layout->key_count; i++) draw_label(ctx, &layout->keys[i], begin, end, cov);
+
+    /* Back to straight alpha */
+    for (int y = begin; y < end; y++) {
+        unsigned char *p = ctx->pixels + (size_t)y * ctx->width * 4;
+        for (int x = 0; x < ctx->width; x++, p += 4) {
+            unsigned int a = p[3];
+            if (a == 255) continue;
+            for (int k = 0; k < 3; k++) {
+                unsigned int v = a ? (p[k] * 255u + a / 2) / a : 0;
+                p[k] = (unsigned char)(v > 255 ? 255 : v);
+            }
+        }
+    }
+    free(cov);
+}
+
+OverlayError overlay_layout_render(const OverlayLayout *layout, int max_width, int max_height,
+                                   Overlay *out) {
+    if (!layout || !out) return OVERLAY_ERROR_NULL_PARAM;
+    if (max_width <= 0 || max_height <= 0) return OVERLAY_ERROR_RESIZE_FAILED;
+
+    float scale_w = (float)max_width / layout->width;
+    float scale_h = (float)max_height / layout->height;
+    float scale = scale_w < scale_h ? scale_w : scale_h;
+    int width = (int)roundf(layout->width * scale);
+    int height = (int)roundf(layout->height * scale);
+    if (width < 1) width = 1;
+    if (height < 1) height = 1;
+    if (width > max_width) width = max_width;
+    if (height > max_height) height = max_height;
+
+    unsigned char *pixels = (unsigned char *)malloc((size_t)width * height * 4);
+    if (!pixels) return OVERLAY_ERROR_OUT_OF_MEMORY;
+
+    RenderCtx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.layout = layout;
+    ctx.pixels = pixels;
+    ctx.width = width;
+    ctx.height = height;
+    /* Exact fill of the output, so the layout edges land on pixel edges */
+    ctx.sx = (float)width / layout->width;
+    ctx.sy = (float)height / layout->height;
+    ctx.blend = get_blend_span();
+    overlay_parallel_rows(height, (size_t)width * height, render_band, &ctx);
+    if (ctx.failed) {
+        free(pixels);
+        return OVERLAY_ERROR_OUT_OF_MEMORY;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->data = pixels;
+    out->base = pixels;
+    out->width = width;
+    out->height = height;
+    out->channels = 4;
+    out->cached_opacity = 1.0f;
+    overlay_mark_dirty(out, 0, 0, width, height);
+    return OVERLAY_OK;
+}
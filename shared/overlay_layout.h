@@ -0,0 +1,60 @@
+#ifndef OVERLAY_LAYOUT_H
+#define OVERLAY_LAYOUT_H
+
+/* Keymaps described as key rectangles, legends and colors instead of a
+   bitmap. The description is a small JSON object in key units:
+
+     {
+       "width": 15, "height": 5,            optional, else the keys' extent
+       "background": "#00000000",
+       "key_color": "#303030E0", "legend_color": "#FFFFFFFF",
+       "radius": 0.12, "gap": 0.08,         key units
+       "font_size": 0.28,                   cap height, key units
+       "stroke": 0.12,                      legend stroke, fraction of font_size
+       "keys": [
+         {"x": 0, "y": 0, "label": "Esc"},
+         {"label": "1"},                    x follows the previous key, same row
+         {"x": 0, "y": 1, "w": 1.5, "label": "Tab", "color": "#505050FF"}
+       ]
+     }
+
+   Keys accept x, y, w, h (default 1), label ("\n" breaks lines), color,
+   legend_color and font_size. Colors are "#RRGGBB" or "#RRGGBBAA". Legends
+   use a built-in stroke font covering printable ASCII.
+
+   overlay_layout_render rasterizes straight at the requested pixel size with
+   anti-aliased edges, so there is no source bitmap to decode or resize and
+   text stays sharp at any scale. */
+
+#include <stddef.h>
+#include "overlay.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct OverlayLayout OverlayLayout;
+
+/* 1 when bytes look like a layout description (a JSON object) rather than an
+   encoded image */
+int overlay_layout_detect(const unsigned char *bytes, size_t len);
+
+/* Parse a description. OVERLAY_ERROR_DECODE_FAILED for malformed JSON, bad
+   colors, or a layout without keys or with a non-positive size. */
+OverlayError overlay_layout_parse(const char *json, size_t len, OverlayLayout **out);
+
+/* Overall size in key units */
+void overlay_layout_size(const OverlayLayout *layout, float *width, float *height);
+
+/* Render fitted within max_width x max_height, keeping the aspect ratio. The
+   overlay owns its pixels (straight RGBA) and has no effects applied. */
+OverlayError overlay_layout_render(const OverlayLayout *layout, int max_width, int max_height,
+                                   Overlay *out);
+
+void overlay_layout_free(OverlayLayout *layout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLAY_LAYOUT_H */
@@ -0,0 +1,195 @@
+#include "overlay_lut3d.h"
+#include "overlay_simd.h"
+#include <stdlib.h>
+
+int overlay_lut3d_plan_init(OverlayLut3dPlan *plan, const OverlayColorLut *lut) {
+    if (!plan || !lut || !lut->table) return 0;
+    if (lut->size < OVERLAY_COLOR_LUT_MIN_SIZE || lut->size > OVERLAY_COLOR_LUT_MAX_SIZE) return 0;
+
+    int size = lut->size;
+    size_t n = (size_t)size * size * size;
+    plan->entries = (uint32_t *)malloc(n * sizeof(uint32_t));
+    if (!plan->entries) return 0;
+    for (size_t i = 0; i < n; i++) {
+        const unsigned char *e = lut->table + i * 3;
+        plan->entries[i] = (uint32_t)e[0] | ((uint32_t)e[1] << 8) | ((uint32_t)e[2] << 16);
+    }
+
+    plan->size = size;
+    plan->step_g = (uint32_t)size;
+    plan->step_b = (uint32_t)size * size;
+    const uint32_t stride[3] = {1, plan->step_g, plan->step_b};
+    for (int v = 0; v < 256; v++) {
+        /* Grid position in 8.8 fixed point; 255 lands exactly on the last
+           point, which is expressed as the last cell with weight 256 so the
+           upper neighbour always exists. */
+        int pos = (v * (size - 1) * 256 + 127) / 255;
+        int idx = pos >> 8;
+        int frac = pos & 255;
+        if (idx >= size - 1) {
+            idx = size - 2;
+            frac = 256;
+        }
+        plan->frac[v] = (uint16_t)frac;
+        for (int axis = 0; axis < 3; axis++) {
+            plan->offset[axis][v] = (uint32_t)idx * stride[axis];
+        }
+    }
+    return 1;
+}
+
+void overlay_lut3d_plan_free(OverlayLut3dPlan *plan) {
+    if (plan && plan->entries) {
+        free(plan->entries);
+        plan->entries = NULL;
+    }
+}
+
+static unsigned int lerp8(unsigned int a, unsigned int b, unsigned int w) {
+    return (a * (256 - w) + b * w + 128) >> 8;
+}
+
+/* Scalar reference */
+void overlay_lut3d_scalar(const OverlayLut3dPlan *plan, const unsigned char *src,
+                          unsigned char *dst, size_t count) {
+    const uint32_t *e = plan->entries;
+    const uint32_t sg = plan->step_g, sb = plan->step_b;
+    for (size_t i = 0; i < count; i++, src += 4, dst += 4) {
+        unsigned int fr = plan->frac[src[0]];
+        unsigned int fg = plan->frac[src[1]];
+        unsigned int fb = plan->frac[src[2]];
+        const uint32_t *p = e + plan->offset[0][src[0]] + plan->offset[1][src[1]] +
+                            plan->offset[2][src[2]];
+        unsigned char a = src[3];
+        for (int c = 0; c < 3; c++) {
+            int shift = c * 8;
+            unsigned int x00 = lerp8((p[0] >> shift) & 255, (p[1] >> shift) & 255, fr);
+            unsigned int x10 = lerp8((p[sg] >> shift) & 255, (p[sg + 1] >> shift) & 255, fr);
+            unsigned int x01 = lerp8((p[sb] >> shift) & 255, (p[sb + 1] >> shift) & 255, fr);
+            unsigned int x11 = lerp8((p[sb + sg] >> shift) & 255, (p[sb + sg + 1] >> shift) & 255, fr);
+            unsigned int y0 = lerp8(x00, x10, fg);
+            unsigned int y1 = lerp8(x01, x11, fg);
+            dst[c] = (unsigned char)lerp8(y0, y1, fb);
+        }
+        dst[3] = a;
+    }
+}
+
+#ifdef OVERLAY_ARCH_X86
+/* One pixel per iteration: the eight corner fetches are scalar, the lerps run
+   as _mm_madd_epi16 over interleaved (lower, upper) pairs against
+   (256 - w, w) weights, all three channels at once. */
+OVERLAY_TARGET("sse2")
+static __m128i lerp_pairs_sse2(__m128i pairs, __m128i weights) {
+    const __m128i round = _mm_set1_epi32(128);
+    return _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(pairs, weights), round), 8);
+}
+
+OVERLAY_TARGET("sse2")
+static void overlay_lut3d_sse2(const OverlayLut3dPlan *plan, const unsigned char *src,
+                               unsigned char *dst, size_t count) {
+    const uint32_t *e = plan->entries;
+    const uint32_t sg = plan->step_g, sb = plan->step_b;
+    const __m128i zero = _mm_setzero_si128();
+    for (size_t i = 0; i < count; i++, src += 4, dst += 4) {
+        int fr = plan->frac[src[0]];
+        int fg = plan->frac[src[1]];
+        int fb = plan->frac[src[2]];
+        const uint32_t *p = e + plan->offset[0][src[0]] + plan->offset[1][src[1]] +
+                            plan->offset[2][src[2]];
+        unsigned char a = src[3];
+
+        const __m128i wr = _mm_set1_epi32((fr << 16) | (256 - fr));
+        const __m128i wg = _mm_set1_epi32((fg << 16) | (256 - fg));
+        const __m128i wb = _mm_set1_epi32((fb << 16) | (256 - fb));
+
+        /* Red: lower/upper red neighbours interleaved byte by byte, then
+           widened; low half is the g0 row, high half the g1 row */
+        __m128i b0 = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, (int)p[sg], (int)p[0]),
+                                       _mm_set_epi32(0, 0, (int)p[sg + 1], (int)p[1]));
+        __m128i b1 = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, (int)p[sb + sg], (int)p[sb]),
+                                       _mm_set_epi32(0, 0, (int)p[sb + sg + 1], (int)p[sb + 1]));
+        __m128i x00 = lerp_pairs_sse2(_mm_unpacklo_epi8(b0, zero), wr);
+        __m128i x10 = lerp_pairs_sse2(_mm_unpackhi_epi8(b0, zero), wr);
+        __m128i x01 = lerp_pairs_sse2(_mm_unpacklo_epi8(b1, zero), wr);
+        __m128i x11 = lerp_pairs_sse2(_mm_unpackhi_epi8(b1, zero), wr);
+
+        /* Green: pair x00 with x10 and x01 with x11 */
+        __m128i lo = _mm_packs_epi32(x00, x01);
+        __m128i hi = _mm_packs_epi32(x10, x11);
+        __m128i y0 = lerp_pairs_sse2(_mm_unpacklo_epi16(lo, hi), wg);
+        __m128i y1 = lerp_pairs_sse2(_mm_unpackhi_epi16(lo, hi), wg);
+
+        /* Blue */
+        __m128i out = lerp_pairs_sse2(_mm_unpacklo_epi16(_mm_packs_epi32(y0, y0),
+                                                         _mm_packs_epi32(y1, y1)), wb);
+        out = _mm_packus_epi16(_mm_packs_epi32(out, out), zero);
+        uint32_t rgb = (uint32_t)_mm_cvtsi128_si32(out);
+        dst[0] = (unsigned char)rgb;
+        dst[1] = (unsigned char)(rgb >> 8);
+        dst[2] = (unsigned char)(rgb >> 16);
+        dst[3] = a;
+    }
+}
+#endif /* OVERLAY_ARCH_X86 */
+
+#ifdef OVERLAY_ARCH_NEON
+static uint32x4_t lerp_rows_neon(uint16x4_t lower, uint16x4_t upper, uint16_t w) {
+    return vrshrq_n_u32(vmlal_n_u16(vmull_n_u16(lower, (uint16_t)(256 - w)), upper, w), 8);
+}
+
+static uint32x4_t lerp_u32_neon(uint32x4_t lower, uint32x4_t upper, uint32_t w) {
+    return vrshrq_n_u32(vmlaq_n_u32(vmulq_n_u32(lower, 256 - w), upper, w), 8);
+}
+
+static void overlay_lut3d_neon(const OverlayLut3dPlan *plan, const unsigned char *src,
+                               unsigned char *dst, size_t count) {
+    const uint32_t *e = plan->entries;
+    const uint32_t sg = plan->step_g, sb = plan->step_b;
+    for (size_t i = 0; i < count; i++, src += 4, dst += 4) {
+        uint16_t fr = plan->frac[src[0]];
+        uint16_t fg = plan->frac[src[1]];
+        uint16_t fb = plan->frac[src[2]];
+        const uint32_t *p = e + plan->offset[0][src[0]] + plan->offset[1][src[1]] +
+                            plan->offset[2][src[2]];
+        unsigned char a = src[3];
+
+        /* Low half holds the g0 row, high half the g1 row */
+        uint16x8_t l0 = vmovl_u8(vcreate_u8((uint64_t)p[0] | ((uint64_t)p[sg] << 32)));
+        uint16x8_t u0 = vmovl_u8(vcreate_u8((uint64_t)p[1] | ((uint64_t)p[sg + 1] << 32)));
+        uint16x8_t l1 = vmovl_u8(vcreate_u8((uint64_t)p[sb] | ((uint64_t)p[sb + sg] << 32)));
+        uint16x8_t u1 = vmovl_u8(vcreate_u8((uint64_t)p[sb + 1] | ((uint64_t)p[sb + sg + 1] << 32)));
+        uint32x4_t x00 = lerp_rows_neon(vget_low_u16(l0), vget_low_u16(u0), fr);
+        uint32x4_t x10 = lerp_rows_neon(vget_high_u16(l0), vget_high_u16(u0), fr);
+        uint32x4_t x01 = lerp_rows_neon(vget_low_u16(l1), vget_low_u16(u1), fr);
+        uint32x4_t x11 = lerp_rows_neon(vget_high_u16(l1), vget_high_u16(u1), fr);
+
+        uint32x4_t y0 = lerp_u32_neon(x00, x10, fg);
+        uint32x4_t y1 = lerp_u32_neon(x01, x11, fg);
+        uint32x4_t out = lerp_u32_neon(y0, y1, fb);
+
+        uint16x4_t n16 = vmovn_u32(out);
+        uint8x8_t n8 = vmovn_u16(vcombine_u16(n16, n16));
+        dst[0] = vget_lane_u8(n8, 0);
+        dst[1] = vget_lane_u8(n8, 1);
+        dst[2] = vget_lane_u8(n8, 2);
+        dst[3] = a;
+    }
+}
+#endif /* OVERLAY_ARCH_NEON */
+
+OverlayLut3dKernel overlay_get_lut3d_kernel(void) {
+    switch (overlay_get_simd_level()) {
+#ifdef OVERLAY_ARCH_X86
+        case OVERLAY_SIMD_SSE2:
+        case OVERLAY_SIMD_AVX2:
+            return overlay_lut3d_sse2;
+#endif
+#ifdef OVERLAY_ARCH_NEON
+        case OVERLAY_SIMD_NEON:
+            return overlay_lut3d_neon;
+#endif
+        default:
+            return overlay_lut3d_scalar;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef OVERLAY_LUT3D_H
+#define OVERLAY_LUT3D_H
+
+/* Internal 3D colour LUT kernels used by overlay.c. The public API is
+   OverlayColorLut / apply_color_lut in overlay.h. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "overlay.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A LUT prepared for one pass: entries widened to one 32-bit load per grid
+   point (R | G << 8 | B << 16), and each 8-bit input mapped once to the
+   offset of its lower grid point and the weight of the upper one. */
+typedef struct {
+    uint32_t *entries;
+    int size;
+    uint32_t offset[3][256];  /* per axis, already multiplied by the axis stride */
+    uint16_t frac[256];       /* upper grid point weight, 0..256 */
+    uint32_t step_g;          /* entry stride along green (size) */
+    uint32_t step_b;          /* entry stride along blue (size * size) */
+} OverlayLut3dPlan;
+
+int overlay_lut3d_plan_init(OverlayLut3dPlan *plan, const OverlayColorLut *lut);
+void overlay_lut3d_plan_free(OverlayLut3dPlan *plan);
+
+/* Recolour `count` RGBA pixels, alpha copied; src == dst runs in place.
+   Each axis is a rounded 8.8 fixed-point lerp, (a * (256 - w) + b * w + 128) >> 8,
+   red then green then blue, so every kernel gives identical output. */
+typedef void (*OverlayLut3dKernel)(const OverlayLut3dPlan *plan, const unsigned char *src,
+                                   unsigned char *dst, size_t count);
+
+void overlay_lut3d_scalar(const OverlayLut3dPlan *plan, const unsigned char *src,
+                          unsigned char *dst, size_t count);
+
+/* Kernel for the active SIMD level (see overlay_get_simd_level) */
+OverlayLut3dKernel overlay_get_lut3d_kernel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLAY_LUT3D_H */
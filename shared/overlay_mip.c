@@ -0,0 +1,85 @@
+#include "overlay_mip.h"
+#include "overlay_simd.h"
+
+/* Output pixels [begin, dst_width) */
+static void downsample_tail(const unsigned char *row0, const unsigned char *row1,
+                            unsigned char *dst, int begin, int dst_width, int src_width) {
+    for (int x = begin; x < dst_width; x++) {
+        int x0 = 2 * x;
+        int x1 = x0 + 1 < src_width ? x0 + 1 : src_width - 1;
+        const unsigned char *a = row0 + (size_t)x0 * 4;
+        const unsigned char *b = row0 + (size_t)x1 * 4;
+        const unsigned char *c = row1 + (size_t)x0 * 4;
+        const unsigned char *d = row1 + (size_t)x1 * 4;
+        unsigned char *o = dst + (size_t)x * 4;
+        for (int k = 0; k < 4; k++) {
+            o[k] = (unsigned char)((a[k] + b[k] + c[k] + d[k] + 2) >> 2);
+        }
+    }
+}
+
+void overlay_downsample_row_scalar(const unsigned char *row0, const unsigned char *row1,
+                                   unsigned char *dst, int dst_width, int src_width) {
+    downsample_tail(row0, row1, dst, 0, dst_width, src_width);
+}
+
+#ifdef OVERLAY_ARCH_X86
+/* Four input pixels (16 bytes) per row -> two output pixels. Rows are summed
+   in 16-bit lanes, then each pixel is added to its right neighbour (8 bytes
+   up); SSE2 has no exact 4-way byte average, _mm_avg_epu8 twice rounds twice. */
+OVERLAY_TARGET("sse2")
+static void downsample_row_sse2(const unsigned char *row0, const unsigned char *row1,
+                                unsigned char *dst, int dst_width, int src_width) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    int x = 0;
+    for (; x + 1 < dst_width && 2 * x + 4 <= src_width; x += 2) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(row0 + (size_t)x * 8));
+        __m128i b = _mm_loadu_si128((const __m128i *)(row1 + (size_t)x * 8));
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+        lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+        hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+        __m128i sum = _mm_unpacklo_epi64(lo, hi);
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+        _mm_storel_epi64((__m128i *)(dst + (size_t)x * 4), _mm_packus_epi16(sum, zero));
+    }
+    downsample_tail(row0, row1, dst, x, dst_width, src_width);
+}
+#endif /* OVERLAY_ARCH_X86 */
+
+#ifdef OVERLAY_ARCH_NEON
+/* Sixteen input pixels per row, deinterleaved by vld4q: pairwise widening
+   adds give the horizontal sums, vrshrn rounds (sum + 2) >> 2 */
+static void downsample_row_neon(const unsigned char *row0, const unsigned char *row1,
+                                unsigned char *dst, int dst_width, int src_width) {
+    int x = 0;
+    for (; x + 8 <= dst_width && 2 * x + 16 <= src_width; x += 8) {
+        uint8x16x4_t a = vld4q_u8(row0 + (size_t)x * 8);
+        uint8x16x4_t b = vld4q_u8(row1 + (size_t)x * 8);
+        uint8x8x4_t out;
+        for (int k = 0; k < 4; k++) {
+            uint16x8_t sum = vaddq_u16(vpaddlq_u8(a.val[k]), vpaddlq_u8(b.val[k]));
+            out.val[k] = vrshrn_n_u16(sum, 2);
+        }
+        vst4_u8(dst + (size_t)x * 4, out);
+    }
+    downsample_tail(row0, row1, dst, x, dst_width, src_width);
+}
+#endif /* OVERLAY_ARCH_NEON */
+
+OverlayDownsampleRowFn overlay_get_downsample_row(void) {
+    switch (overlay_get_simd_level()) {
+#ifdef OVERLAY_ARCH_X86
+        case OVERLAY_SIMD_SSE2:
+        case OVERLAY_SIMD_AVX2:
+            return downsample_row_sse2;
+#endif
+#ifdef OVERLAY_ARCH_NEON
+        case OVERLAY_SIMD_NEON:
+            return downsample_row_neon;
+#endif
+        default:
+            return overlay_downsample_row_scalar;
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef OVERLAY_MIP_H
+#define OVERLAY_MIP_H
+
+/* Internal 2x box downsample kernels used by overlay.c to build the mip
+   pyramid; the public API is overlay_source_build_mips in overlay.h. */
+
+#include <stddef.h>
+#include "overlay.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Write dst_width RGBA pixels, each the rounded mean (sum + 2) >> 2 of a 2x2
+   block from row0/row1. Output x reads input 2x and 2x + 1, clamped to
+   src_width - 1, so odd widths repeat the last column. Pass row1 == row0
+   for the last row of an odd height. */
+typedef void (*OverlayDownsampleRowFn)(const unsigned char *row0, const unsigned char *row1,
+                                       unsigned char *dst, int dst_width, int src_width);
+
+/* Scalar reference; the SIMD variants match it bit for bit */
+void overlay_downsample_row_scalar(const unsigned char *row0, const unsigned char *row1,
+                                   unsigned char *dst, int dst_width, int src_width);
+
+/* Kernel for the active SIMD level (see overlay_get_simd_level) */
+OverlayDownsampleRowFn overlay_get_downsample_row(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLAY_MIP_H */
@@ -0,0 +1,30 @@
+#ifndef OVERLAY_PARALLEL_H
+#define OVERLAY_PARALLEL_H
+
+/* Internal row-band executor used by overlay.c. Thread count and threshold
+   are configured through overlay.h (overlay_set_thread_count etc.). */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Process rows [begin, end) */
+typedef void (*OverlayBandFn)(void *ctx, int begin, int end);
+
+/* Split `rows` rows into contiguous bands and run fn over them on a
+   persistent pool of worker threads, returning when every band is done. Safe
+   to call from several threads at once and from inside fn. Stays on the calling thread
+   when `work_pixels` is below the parallel threshold, when only one thread
+   is configured, or if worker threads cannot be started. */
+void overlay_parallel_rows(int rows, size_t work_pixels, OverlayBandFn fn, void *ctx);
+
+/* Number of logical CPUs (at least 1) */
+int overlay_cpu_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLAY_PARALLEL_H */
@@ -0,0 +1,552 @@
+#include "overlay_png.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WINDOW_SIZE 32768
+#define WINDOW_MASK (WINDOW_SIZE - 1)
+#define MAX_CODE_BITS 15
+#define FAST_BITS 9
+
+/* Canonical Huffman code: a FAST_BITS lookup for short codes and a
+   bit-serial walk over the sorted symbols for the rest */
+typedef struct {
+    uint16_t fast[1 << FAST_BITS]; /* (length << 9) | symbol, 0 = not fast */
+    uint16_t count[MAX_CODE_BITS + 1];
+    uint16_t symbol[288];
+} Huffman;
+
+enum { BLOCK_NONE, BLOCK_STORED, BLOCK_HUFFMAN };
+
+struct OverlayPngStream {
+    /* Chunked input: IDAT payloads are one zlib stream */
+    const unsigned char *data;
+    size_t len;
+    size_t pos;       /* next byte of the current IDAT payload */
+    size_t chunk_end; /* end of the current IDAT payload */
+    uint64_t bitbuf;
+    int bitcnt;
+
+    /* Inflate state, resumable between rows */
+    int block;
+    int final_block;
+    int done;
+    unsigned stored_left;
+    unsigned match_len;
+    unsigned match_dist;
+    Huffman lit;
+    Huffman dist;
+    unsigned char window[WINDOW_SIZE];
+    size_t total_out;
+
+    /* Image */
+    int width;
+    int height;
+    int depth;
+    int color_type;
+    int samples;    /* per pixel in the file */
+    int filter_bpp; /* bytes per complete pixel for filtering, at least 1 */
+    size_t row_bytes;
+    int row;
+    unsigned char palette[256 * 4];
+    int has_trns;
+    uint16_t trns[3]; /* 16-bit files: the raw key */
+    unsigned char trns8[3]; /* otherwise: the key as stb_image expands it */
+    unsigned char *cur;  /* filter byte + row */
+    unsigned char *prev;
+};
+
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static uint32_t read_be32(const unsigned char *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/* Next compressed byte, moving on to the following IDAT chunk as needed;
+   -1 at the end of the image data */
+static int next_byte(OverlayPngStream *s) {
+    while (s->pos >= s->chunk_end) {
+        size_t next = s->chunk_end + 4; /* skip CRC */
+        if (next > s->len || s->len - next < 8) return -1;
+        uint32_t len = read_be32(s->data + next);
+        if (memcmp(s->data + next + 4, "IDAT", 4) != 0) return -1;
+        if (len > s->len - next - 8) return -1;
+        s->pos = next + 8;
+        s->chunk_end = s->pos + len;
+    }
+    return s->data[s->pos++];
+}
+
+/* Top up to at least n bits (n <= 32); 0 if the input ends first */
+static int need_bits(OverlayPngStream *s, int n) {
+    while (s->bitcnt < n) {
+        int b = next_byte(s);
+        if (b < 0) return 0;
+        s->bitbuf |= (uint64_t)b << s->bitcnt;
+        s->bitcnt += 8;
+    }
+    return 1;
+}
+
+static int get_bits(OverlayPngStream *s, int n, unsigned *out) {
+    if (!need_bits(s, n)) return 0;
+    *out = (unsigned)(s->bitbuf & ((1u << n) - 1));
+    s->bitbuf >>= n;
+    s->bitcnt -= n;
+    return 1;
+}
+
+static int build_huffman(Huffman *h, const uint8_t *lengths, int n) {
+    uint16_t offs[MAX_CODE_BITS + 2];
+    int next_code[MAX_CODE_BITS + 1];
+
+    memset(h->count, 0, sizeof(h->count));
+    memset(h->fast, 0, sizeof(h->fast));
+    for (int i = 0; i < n; i++) h->count[lengths[i]]++;
+    h->count[0] = 0;
+
+    /* Over-subscribed sets are invalid; incomplete ones are allowed */
+    int left = 1;
+    for (int len = 1; len <= MAX_CODE_BITS; len++) {
+        left <<= 1;
+        left -= h->count[len];
+        if (left < 0) return 0;
+    }
+
+    offs[1] = 0;
+    for (int len = 1; len <= MAX_CODE_BITS; len++) offs[len + 1] = offs[len] + h->count[len];
+    int code = 0;
+    for (int len = 1; len <= MAX_CODE_BITS; len++) {
+        code = (code + h->count[len - 1]) << 1;
+        next_code[len] = code;
+    }
+    /* count[0] took part above as 0, which is what the canonical rule wants */
+
+    for (int sym = 0; sym < n; sym++) {
+        int len = lengths[sym];
+        if (!len) continue;
+        h->symbol[offs[len]++] = (uint16_t)sym;
+        int c = next_code[len]++;
+        if (len <= FAST_BITS) {
+            /* Codes are read LSB first: index by the reversed code */
+            int r = 0;
+            for (int b = 0; b < len; b++) r |= ((c >> b) & 1) << (len - 1 - b);
+            for (int j = r; j < (1 << FAST_BITS); j += 1 << len) {
+                h->fast[j] = (uint16_t)((len << 9) | sym);
+            }
+        }
+    }
+    return 1;
+}
+
+static int decode_symbol(OverlayPngStream *s, const Huffman *h) {
+    /* Near the end of the stream fewer bits than a full code may remain */
+    need_bits(s, MAX_CODE_BITS);
+    uint16_t e = h->fast[s->bitbuf & ((1u << FAST_BITS) - 1)];
+    if (e && (e >> 9) <= s->bitcnt) {
+        s->bitbuf >>= e >> 9;
+        s->bitcnt -= e >> 9;
+        return e & 511;
+    }
+
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len <= MAX_CODE_BITS && len <= s->bitcnt; len++) {
+        code |= (int)((s->bitbuf >> (len - 1)) & 1);
+        int count = h->count[len];
+        if (code - count < first) {
+            s->bitbuf >>= len;
+            s->bitcnt -= len;
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+static int read_dynamic_tables(OverlayPngStream *s) {
+    static const uint8_t order[19] = {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+    };
+    unsigned hlit, hdist, hclen;
+    if (!get_bits(s, 5, &hlit) || !get_bits(s, 5, &hdist) || !get_bits(s, 4, &hclen)) return 0;
+    hlit += 257;
+    hdist += 1;
+    hclen += 4;
+    if (hlit > 286 || hdist > 30) return 0;
+
+    uint8_t lengths[286 + 30];
+    uint8_t cl_lengths[19];
+    memset(cl_lengths, 0, sizeof(cl_lengths));
+    for (unsigned i = 0; i < hclen; i++) {
+        unsigned v;
+        if (!get_bits(s, 3, &v)) return 0;
+        cl_lengths[order[i]] = (uint8_t)v;
+    }
+    Huffman cl;
+    if (!build_huffman(&cl, cl_lengths, 19)) return 0;
+
+    unsigned n = 0;
+    while (n < hlit + hdist) {
+        int sym = decode_symbol(s, &cl);
+        if (sym < 0) return 0;
+        if (sym < 16) {
+            lengths[n++] = (uint8_t)sym;
+            continue;
+        }
+        unsigned repeat;
+        uint8_t fill = 0;
+        if (sym == 16) {
+            if (n == 0 || !get_bits(s, 2, &repeat)) return 0;
+            repeat += 3;
+            fill = lengths[n - 1];
+        } else if (sym == 17) {
+            if (!get_bits(s, 3, &repeat)) return 0;
+            repeat += 3;
+        } else {
+            if (!get_bits(s, 7, &repeat)) return 0;
+            repeat += 11;
+        }
+        if (n + repeat > hlit + hdist) return 0;
+        memset(lengths + n, fill, repeat);
+        n += repeat;
+    }
+    if (lengths[256] == 0) return 0; /* no end-of-block code */
+    return build_huffman(&s->lit, lengths, (int)hlit) &&
+           build_huffman(&s->dist, lengths + hlit, (int)hdist);
+}
+
+static int start_block(OverlayPngStream *s) {
+    unsigned final_bit, type;
+    if (!get_bits(s, 1, &final_bit) || !get_bits(s, 2, &type)) return 0;
+    s->final_block = (int)final_bit;
+
+    if (type == 0) {
+        /* Stored: byte aligned LEN and its complement */
+        unsigned len, nlen;
+        s->bitbuf >>= s->bitcnt & 7;
+        s->bitcnt -= s->bitcnt & 7;
+        if (!get_bits(s, 16, &len) || !get_bits(s, 16, &nlen)) return 0;
+        if ((len ^ 0xFFFFu) != nlen) return 0;
+        s->stored_left = len;
+        s->block = BLOCK_STORED;
+        return 1;
+    }
+    if (type == 1) {
+        uint8_t lengths[288 + 30];
+        memset(lengths, 8, 144);
+        memset(lengths + 144, 9, 112);
+        memset(lengths + 256, 7, 24);
+        memset(lengths + 280, 8, 8);
+        memset(lengths + 288, 5, 30);
+        build_huffman(&s->lit, lengths, 288);
+        build_huffman(&s->dist, lengths + 288, 30);
+        s->block = BLOCK_HUFFMAN;
+        return 1;
+    }
+    if (type == 2) {
+        if (!read_dynamic_tables(s)) return 0;
+        s->block = BLOCK_HUFFMAN;
+        return 1;
+    }
+    return 0;
+}
+
+static void put_byte(OverlayPngStream *s, unsigned char *out, unsigned char b) {
+    *out = b;
+    s->window[s->total_out & WINDOW_MASK] = b;
+    s->total_out++;
+}
+
+/* Produce exactly n bytes of the zlib stream; 0 on corrupt or short data */
+static int inflate_bytes(OverlayPngStream *s, unsigned char *out, size_t n) {
+    size_t produced = 0;
+    while (produced < n) {
+        if (s->match_len) {
+            size_t from = s->total_out - s->match_dist;
+            while (s->match_len && produced < n) {
+                put_byte(s, out + produced++, s->window[from++ & WINDOW_MASK]);
+                s->match_len--;
+            }
+            continue;
+        }
+
+        if (s->block == BLOCK_STORED) {
+            if (s->stored_left == 0) {
+                s->block = BLOCK_NONE;
+                s->done = s->final_block;
+                continue;
+            }
+            unsigned v;
+            if (!get_bits(s, 8, &v)) return 0;
+            put_byte(s, out + produced++, (unsigned char)v);
+            s->stored_left--;
+            continue;
+        }
+
+        if (s->block == BLOCK_HUFFMAN) {
+            int sym = decode_symbol(s, &s->lit);
+            if (sym < 0) return 0;
+            if (sym < 256) {
+                put_byte(s, out + produced++, (unsigned char)sym);
+            } else if (sym == 256) {
+                s->block = BLOCK_NONE;
+                s->done = s->final_block;
+            } else {
+                sym -= 257;
+                if (sym >= 29) return 0;
+                unsigned extra, len = length_base[sym];
+                if (!get_bits(s, length_extra[sym], &extra)) return 0;
+                len += extra;
+                int dsym = decode_symbol(s, &s->dist);
+                if (dsym < 0 || dsym >= 30) return 0;
+                unsigned dist = dist_base[dsym];
+                if (!get_bits(s, dist_extra[dsym], &extra)) return 0;
+                dist += extra;
+                if (dist > s->total_out || dist > WINDOW_SIZE) return 0;
+                s->match_len = len;
+                s->match_dist = dist;
+            }
+            continue;
+        }
+
+        if (s->done || !start_block(s)) return 0;
+    }
+    return 1;
+}
+
+static unsigned char paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return (unsigned char)a;
+    if (pb <= pc) return (unsigned char)b;
+    return (unsigned char)c;
+}
+
+static int unfilter(OverlayPngStream *s) {
+    unsigned char *x = s->cur + 1;
+    const unsigned char *p = s->prev + 1;
+    size_t n = s->row_bytes;
+    size_t bpp = (size_t)s->filter_bpp;
+    switch (s->cur[0]) {
+    case 0:
+        break;
+    case 1:
+        for (size_t i = bpp; i < n; i++) x[i] = (unsigned char)(x[i] + x[i - bpp]);
+        break;
+    case 2:
+        for (size_t i = 0; i < n; i++) x[i] = (unsigned char)(x[i] + p[i]);
+        break;
+    case 3:
+        for (size_t i = 0; i < bpp && i < n; i++) x[i] = (unsigned char)(x[i] + (p[i] >> 1));
+        for (size_t i = bpp; i < n; i++) x[i] = (unsigned char)(x[i] + ((x[i - bpp] + p[i]) >> 1));
+        break;
+    case 4:
+        for (size_t i = 0; i < bpp && i < n; i++) x[i] = (unsigned char)(x[i] + p[i]);
+        for (size_t i = bpp; i < n; i++) {
+            x[i] = (unsigned char)(x[i] + paeth(x[i - bpp], p[i], p[i - bpp]));
+        }
+        break;
+    default:
+        return 0;
+    }
+    return 1;
+}
+
+/* Sample i of the row at the file's bit depth */
+static unsigned sample_at(const unsigned char *x, int depth, size_t i) {
+    switch (depth) {
+    case 16: return ((unsigned)x[2 * i] << 8) | x[2 * i + 1];
+    case 8: return x[i];
+    default: {
+        size_t bit = i * (size_t)depth;
+        unsigned shift = (unsigned)(8 - depth - (int)(bit & 7));
+        return (x[bit >> 3] >> shift) & ((1u << depth) - 1);
+    }
+    }
+}
+
+/* To 8 bits the way stb_image does: replicate low depths, keep the high
+   byte of 16-bit samples */
+static unsigned char to8(unsigned v, int depth) {
+    static const unsigned char scale[9] = {0, 255, 85, 0, 17, 0, 0, 0, 1};
+    if (depth == 16) return (unsigned char)(v >> 8);
+    return (unsigned char)(v * scale[depth]);
+}
+
+static void convert_row(const OverlayPngStream *s, unsigned char *rgba) {
+    const unsigned char *x = s->cur + 1;
+    int depth = s->depth;
+    for (int i = 0; i < s->width; i++) {
+        unsigned char *o = rgba + (size_t)i * 4;
+        size_t k = (size_t)i * (size_t)s->samples;
+        switch (s->color_type) {
+        case 0: {
+            unsigned g = sample_at(x, depth, k);
+            o[0] = o[1] = o[2] = to8(g, depth);
+            int key = depth == 16 ? g == s->trns[0] : o[0] == s->trns8[0];
+            o[3] = (s->has_trns && key) ? 0 : 255;
+            break;
+        }
+        case 2: {
+            unsigned r = sample_at(x, depth, k);
+            unsigned g = sample_at(x, depth, k + 1);
+            unsigned b = sample_at(x, depth, k + 2);
+            o[0] = to8(r, depth);
+            o[1] = to8(g, depth);
+            o[2] = to8(b, depth);
+            int key = depth == 16
+                ? r == s->trns[0] && g == s->trns[1] && b == s->trns[2]
+                : o[0] == s->trns8[0] && o[1] == s->trns8[1] && o[2] == s->trns8[2];
+            o[3] = (s->has_trns && key) ? 0 : 255;
+            break;
+        }
+        case 3:
+            memcpy(o, s->palette + sample_at(x, depth, k) * 4, 4);
+            break;
+        case 4:
+            o[0] = o[1] = o[2] = to8(sample_at(x, depth, k), depth);
+            o[3] = to8(sample_at(x, depth, k + 1), depth);
+            break;
+        default:
+            o[0] = to8(sample_at(x, depth, k), depth);
+            o[1] = to8(sample_at(x, depth, k + 1), depth);
+            o[2] = to8(sample_at(x, depth, k + 2), depth);
+            o[3] = to8(sample_at(x, depth, k + 3), depth);
+            break;
+        }
+    }
+}
+
+static int valid_format(int color_type, int depth) {
+    switch (color_type) {
+    case 0: return depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+    case 3: return depth == 1 || depth == 2 || depth == 4 || depth == 8;
+    case 2: case 4: case 6: return depth == 8 || depth == 16;
+    default: return 0;
+    }
+}
+
+OverlayPngStream *overlay_png_open(const unsigned char *data, size_t len) {
+    static const unsigned char sig[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+    if (!data || len < 8 + 25 || memcmp(data, sig, 8) != 0) return NULL;
+
+    OverlayPngStream *s = (OverlayPngStream *)calloc(1, sizeof(OverlayPngStream));
+    if (!s) return NULL;
+    s->data = data;
+    s->len = len;
+    for (int i = 0; i < 256; i++) s->palette[i * 4 + 3] = 255;
+
+    /* Header chunks up to the first IDAT */
+    size_t pos = 8;
+    int have_header = 0, palette_len = 0;
+    for (;;) {
+        if (len - pos < 12) goto fail;
+        uint32_t clen = read_be32(data + pos);
+        const unsigned char *type = data + pos + 4;
+        const unsigned char *body = data + pos + 8;
+        if (clen > len - pos - 12) goto fail;
+
+        if (!have_header) {
+            if (memcmp(type, "IHDR", 4) != 0 || clen != 13) goto fail;
+            uint32_t w = read_be32(body), h = read_be32(body + 4);
+            s->depth = body[8];
+            s->color_type = body[9];
+            if (w == 0 || h == 0 || w > (1u << 24) || h > (1u << 24)) goto fail;
+            if (!valid_format(s->color_type, s->depth)) goto fail;
+            if (body[10] != 0 || body[11] != 0 || body[12] != 0) goto fail; /* interlaced */
+            s->width = (int)w;
+            s->height = (int)h;
+            have_header = 1;
+        } else if (memcmp(type, "PLTE", 4) == 0) {
+            if (clen % 3 || clen > 256 * 3) goto fail;
+            palette_len = (int)(clen / 3);
+            for (int i = 0; i < palette_len; i++) memcpy(s->palette + i * 4, body + i * 3, 3);
+        } else if (memcmp(type, "tRNS", 4) == 0) {
+            if (s->color_type == 3) {
+                if (clen > 256) goto fail;
+                for (uint32_t i = 0; i < clen; i++) s->palette[i * 4 + 3] = body[i];
+            } else if (s->color_type == 0 && clen == 2) {
+                s->trns[0] = (uint16_t)((body[0] << 8) | body[1]);
+                s->has_trns = 1;
+            } else if (s->color_type == 2 && clen == 6) {
+                for (int c = 0; c < 3; c++) s->trns[c] = (uint16_t)((body[2 * c] << 8) | body[2 * c + 1]);
+                s->has_trns = 1;
+            }
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            s->pos = pos + 8;
+            s->chunk_end = s->pos + clen;
+            break;
+        } else if (memcmp(type, "IEND", 4) == 0 || !(type[0] & 0x20)) {
+            goto fail; /* no image data, or a critical chunk we don't know */
+        }
+        pos += 12 + clen;
+    }
+    if (s->color_type == 3 && palette_len == 0) goto fail;
+    if (s->has_trns && s->depth < 16) {
+        /* stb_image keeps the low byte of the key and expands it like a sample */
+        for (int c = 0; c < 3; c++) s->trns8[c] = to8(s->trns[c] & 255u, s->depth);
+    }
+
+    static const int samples[7] = {1, 0, 3, 1, 2, 0, 4};
+    s->samples = samples[s->color_type];
+    size_t bits = (size_t)s->width * (size_t)s->samples * (size_t)s->depth;
+    s->row_bytes = (bits + 7) / 8;
+    s->filter_bpp = (s->samples * s->depth + 7) / 8;
+    s->cur = (unsigned char *)calloc(1, s->row_bytes + 1);
+    s->prev = (unsigned char *)calloc(1, s->row_bytes + 1);
+    if (!s->cur || !s->prev) goto fail;
+
+    /* zlib header: deflate, no preset dictionary */
+    unsigned cmf, flg;
+    if (!get_bits(s, 8, &cmf) || !get_bits(s, 8, &flg)) goto fail;
+    if ((cmf & 15) != 8 || (cmf >> 4) > 7 || (flg & 32) || ((cmf << 8) | flg) % 31 != 0) goto fail;
+    s->block = BLOCK_NONE;
+    return s;
+
+fail:
+    overlay_png_close(s);
+    return NULL;
+}
+
+void overlay_png_size(const OverlayPngStream *s, int *width, int *height) {
+    if (width) *width = s ? s->width : 0;
+    if (height) *height = s ? s->height : 0;
+}
+
+int overlay_png_read_row(OverlayPngStream *s, unsigned char *rgba) {
+    if (!s || !rgba || s->row >= s->height) return 0;
+    if (!inflate_bytes(s, s->cur, s->row_bytes + 1)) return 0;
+    if (!unfilter(s)) return 0;
+    convert_row(s, rgba);
+
+    unsigned char *t = s->prev;
+    s->prev = s->cur;
+    s->cur = t;
+    s->row++;
+    return 1;
+}
+
+void overlay_png_close(OverlayPngStream *s) {
+    if (!s) return;
+    free(s->cur);
+    free(s->prev);
+    free(s);
+}
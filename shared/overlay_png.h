@@ -0,0 +1,35 @@
+#ifndef OVERLAY_PNG_H
+#define OVERLAY_PNG_H
+
+/* Internal streaming PNG decoder used by overlay.c: inflates and unfilters
+   one scanline at a time, so a decode can feed the resampler row by row
+   instead of materialising the whole image. Handles every non-interlaced
+   PNG (all colour types and bit depths, PLTE and tRNS) and produces the same
+   straight RGBA8 as stb_image; anything else is left to stb_image. */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct OverlayPngStream OverlayPngStream;
+
+/* NULL if data is not a PNG this decoder handles (interlaced, unknown
+   layout, damaged header) or on allocation failure. data must stay valid
+   until overlay_png_close. */
+OverlayPngStream *overlay_png_open(const unsigned char *data, size_t len);
+
+void overlay_png_size(const OverlayPngStream *s, int *width, int *height);
+
+/* Decode the next row into width * 4 bytes of RGBA. Returns 1 on success,
+   0 past the last row or on corrupt data. */
+int overlay_png_read_row(OverlayPngStream *s, unsigned char *rgba);
+
+void overlay_png_close(OverlayPngStream *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLAY_PNG_H */
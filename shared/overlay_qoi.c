@@ -0,0 +1,211 @@
+#include "overlay_qoi.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define QOI_OP_INDEX 0x00 /* 00xxxxxx */
+#define QOI_OP_DIFF  0x40 /* 01xxxxxx */
+#define QOI_OP_LUMA  0x80 /* 10xxxxxx */
+#define QOI_OP_RUN   0xC0 /* 11xxxxxx */
+#define QOI_OP_RGB   0xFE
+#define QOI_OP_RGBA  0xFF
+#define QOI_MASK_2   0xC0
+
+#define QOI_PADDING 8 /* seven 0x00 and a 0x01 close the stream */
+/* The reference decoder's limit: keeps width * height * 4 well inside int */
+#define QOI_PIXELS_MAX 400000000u
+
+static const unsigned char g_padding[QOI_PADDING] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+struct OverlayQoiStream {
+    const unsigned char *data;
+    size_t pos;
+    size_t end; /* ops stop where the padding starts */
+    int width;
+    int height;
+    int row;
+    int run;            /* repeats of px still owed */
+    unsigned char px[4];
+    unsigned char index[64][4];
+};
+
+static inline int qoi_hash(const unsigned char *p) {
+    return (p[0] * 3 + p[1] * 5 + p[2] * 7 + p[3] * 11) & 63;
+}
+
+static uint32_t read_be32(const unsigned char *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void write_be32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+OverlayQoiStream *overlay_qoi_open(const unsigned char *data, size_t len) {
+    if (!data || len < OVERLAY_QOI_HEADER_SIZE + QOI_PADDING) return NULL;
+    if (memcmp(data, "qoif", 4) != 0) return NULL;
+    uint32_t width = read_be32(data + 4), height = read_be32(data + 8);
+    unsigned char channels = data[12], colorspace = data[13];
+    if (width == 0 || height == 0 || (channels != 3 && channels != 4) || colorspace > 1 ||
+        height >= QOI_PIXELS_MAX / width) {
+        return NULL;
+    }
+
+    OverlayQoiStream *s = (OverlayQoiStream *)calloc(1, sizeof(OverlayQoiStream));
+    if (!s) return NULL;
+    s->data = data;
+    s->pos = OVERLAY_QOI_HEADER_SIZE;
+    s->end = len - QOI_PADDING;
+    s->width = (int)width;
+    s->height = (int)height;
+    s->px[3] = 255;
+    return s;
+}
+
+void overlay_qoi_size(const OverlayQoiStream *s, int *width, int *height) {
+    *width = s->width;
+    *height = s->height;
+}
+
+int overlay_qoi_read_row(OverlayQoiStream *s, unsigned char *rgba) {
+    if (s->row >= s->height) return 0;
+
+    /* Hot state in locals; written back once per row */
+    const unsigned char *data = s->data;
+    size_t pos = s->pos, end = s->end;
+    int run = s->run;
+    unsigned char px[4];
+    memcpy(px, s->px, 4);
+
+    for (int x = 0; x < s->width; x++, rgba += 4) {
+        if (run > 0) {
+            run--;
+        } else {
+            if (pos >= end) return 0;
+            int b1 = data[pos++];
+            if (b1 == QOI_OP_RGB) {
+                if (end - pos < 3) return 0;
+                px[0] = data[pos];
+                px[1] = data[pos + 1];
+                px[2] = data[pos + 2];
+                pos += 3;
+            } else if (b1 == QOI_OP_RGBA) {
+                if (end - pos < 4) return 0;
+                memcpy(px, data + pos, 4);
+                pos += 4;
+            } else {
+                switch (b1 & QOI_MASK_2) {
+                    case QOI_OP_INDEX:
+                        memcpy(px, s->index[b1], 4);
+                        break;
+                    case QOI_OP_DIFF:
+                        px[0] = (unsigned char)(px[0] + ((b1 >> 4) & 3) - 2);
+                        px[1] = (unsigned char)(px[1] + ((b1 >> 2) & 3) - 2);
+                        px[2] = (unsigned char)(px[2] + (b1 & 3) - 2);
+                        break;
+                    case QOI_OP_LUMA: {
+                        if (pos >= end) return 0;
+                        int b2 = data[pos++];
+                        int vg = (b1 & 63) - 32;
+                        px[0] = (unsigned char)(px[0] + vg - 8 + ((b2 >> 4) & 15));
+                        px[1] = (unsigned char)(px[1] + vg);
+                        px[2] = (unsigned char)(px[2] + vg - 8 + (b2 & 15));
+                        break;
+                    }
+                    default: /* QOI_OP_RUN: this pixel and (b1 & 63) more */
+                        run = b1 & 63;
+                        break;
+                }
+            }
+            memcpy(s->index[qoi_hash(px)], px, 4);
+        }
+        memcpy(rgba, px, 4);
+    }
+
+    s->pos = pos;
+    s->run = run;
+    memcpy(s->px, px, 4);
+    s->row++;
+    return 1;
+}
+
+void overlay_qoi_close(OverlayQoiStream *s) {
+    free(s);
+}
+
+unsigned char *overlay_qoi_encode(const unsigned char *rgba, int width, int height,
+                                  size_t *out_len) {
+    if (!rgba || !out_len || width < 1 || height < 1 ||
+        (uint32_t)height >= QOI_PIXELS_MAX / (uint32_t)width) {
+        return NULL;
+    }
+    size_t count = (size_t)width * height;
+    /* Worst case: every pixel a QOI_OP_RGBA */
+    unsigned char *out = (unsigned char *)malloc(OVERLAY_QOI_HEADER_SIZE + count * 5 + QOI_PADDING);
+    if (!out) return NULL;
+
+    memcpy(out, "qoif", 4);
+    write_be32(out + 4, (uint32_t)width);
+    write_be32(out + 8, (uint32_t)height);
+    out[12] = 4; /* channels */
+    out[13] = 0; /* sRGB with linear alpha */
+    size_t pos = OVERLAY_QOI_HEADER_SIZE;
+
+    unsigned char index[64][4];
+    memset(index, 0, sizeof(index));
+    unsigned char prev[4] = {0, 0, 0, 255};
+    int run = 0;
+    for (size_t i = 0; i < count; i++) {
+        const unsigned char *px = rgba + i * 4;
+        if (memcmp(px, prev, 4) == 0) {
+            run++;
+            if (run == 62 || i + 1 == count) {
+                out[pos++] = (unsigned char)(QOI_OP_RUN | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            out[pos++] = (unsigned char)(QOI_OP_RUN | (run - 1));
+            run = 0;
+        }
+
+        int h = qoi_hash(px);
+        if (memcmp(index[h], px, 4) == 0) {
+            out[pos++] = (unsigned char)(QOI_OP_INDEX | h);
+        } else {
+            memcpy(index[h], px, 4);
+            if (px[3] == prev[3]) {
+                signed char vr = (signed char)(px[0] - prev[0]);
+                signed char vg = (signed char)(px[1] - prev[1]);
+                signed char vb = (signed char)(px[2] - prev[2]);
+                int vg_r = vr - vg, vg_b = vb - vg;
+                if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                    out[pos++] = (unsigned char)(QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                    out[pos++] = (unsigned char)(QOI_OP_LUMA | (vg + 32));
+                    out[pos++] = (unsigned char)((vg_r + 8) << 4 | (vg_b + 8));
+                } else {
+                    out[pos++] = QOI_OP_RGB;
+                    memcpy(out + pos, px, 3);
+                    pos += 3;
+                }
+            } else {
+                out[pos++] = QOI_OP_RGBA;
+                memcpy(out + pos, px, 4);
+                pos += 4;
+            }
+        }
+        memcpy(prev, px, 4);
+    }
+    memcpy(out + pos, g_padding, QOI_PADDING);
+    pos += QOI_PADDING;
+
+    /* Usually far below the worst case */
+    unsigned char *shrunk = (unsigned char *)realloc(out, pos);
+    *out_len = pos;
+    return shrunk ? shrunk : out;
+}
@@ -0,0 +1,42 @@
+#ifndef OVERLAY_QOI_H
+#define OVERLAY_QOI_H
+
+/* Internal QOI codec used by overlay.c and the keymap_predecode converter.
+   QOI ("Quite OK Image", qoiformat.org) is lossless RGBA with byte-oriented
+   ops and no entropy coder, so it decodes several times faster than PNG's
+   inflate at a similar size. Like overlay_png the decoder hands out one
+   scanline at a time, so it feeds the streaming resampler directly. */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OVERLAY_QOI_HEADER_SIZE 14
+
+typedef struct OverlayQoiStream OverlayQoiStream;
+
+/* NULL unless data starts with a valid QOI header ("qoif"), or on
+   allocation failure. data must stay valid until overlay_qoi_close. */
+OverlayQoiStream *overlay_qoi_open(const unsigned char *data, size_t len);
+
+void overlay_qoi_size(const OverlayQoiStream *s, int *width, int *height);
+
+/* Decode the next row into width * 4 bytes of straight RGBA. Returns 1 on
+   success, 0 past the last row or on truncated data. */
+int overlay_qoi_read_row(OverlayQoiStream *s, unsigned char *rgba);
+
+void overlay_qoi_close(OverlayQoiStream *s);
+
+/* Encode straight RGBA pixels as a complete QOI file (4 channels, sRGB).
+   Returns a malloc'd buffer of *out_len bytes, NULL on allocation failure
+   or bad arguments. */
+unsigned char *overlay_qoi_encode(const unsigned char *rgba, int width, int height,
+                                  size_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLAY_QOI_H */
@@ -0,0 +1,597 @@
+#include "overlay_resample.h"
+#include "overlay_simd.h"
+#include "overlay_mip.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static volatile int g_resize_filter = OVERLAY_FILTER_AUTO;
+
+void overlay_set_resize_filter(OverlayResizeFilter filter) {
+    if ((int)filter < OVERLAY_FILTER_AUTO || (int)filter > OVERLAY_FILTER_LANCZOS3) {
+        filter = OVERLAY_FILTER_AUTO;
+    }
+    g_resize_filter = (int)filter;
+}
+
+OverlayResizeFilter overlay_get_resize_filter(void) {
+    return (OverlayResizeFilter)g_resize_filter;
+}
+
+/* Taps of one output sample: weights for source pixels first.. */
+typedef struct {
+    int first;
+    int count;
+    const float *weights;
+} Contrib;
+
+typedef struct {
+    Contrib *contribs;
+    float *weights;
+    int max_taps;
+} Axis;
+
+/* Exact-ratio box resizes that reduce to integer averaging or copying */
+typedef enum {
+    FAST_NONE = 0,
+    FAST_BOX_DOWN2,
+    FAST_BOX_DOWN4,
+    FAST_BOX_REPLICATE
+} FastPath;
+
+struct OverlayResamplePlan {
+    int src_width;
+    int src_height;
+    int dst_width;
+    int dst_height;
+    Axis h;
+    Axis v;
+    int ring_rows; /* widest vertical footprint */
+    FastPath fast;
+};
+
+struct OverlayResampler {
+    OverlayResamplePlan *plan;
+    unsigned char *dst;
+    float *ring;        /* horizontally resampled source rows, ring_rows deep */
+    const float **taps; /* ring rows under the current output row */
+    int next_src;       /* source rows pushed so far */
+    int next_dst;       /* output rows written so far */
+};
+
+/* ---- Filters ---------------------------------------------------------- */
+
+typedef struct {
+    float (*fn)(float x);
+    float support; /* radius in source pixels when enlarging */
+} FilterDef;
+
+static float box(float x) {
+    /* Half-open so a tap exactly between two pixels counts once */
+    return x > -0.5f && x <= 0.5f ? 1.0f : 0.0f;
+}
+
+static float triangle(float x) {
+    x = fabsf(x);
+    return x < 1.0f ? 1.0f - x : 0.0f;
+}
+
+static float catmull_rom(float x) {
+    x = fabsf(x);
+    if (x < 1.0f) return 1.5f * x * x * x - 2.5f * x * x + 1.0f;
+    if (x < 2.0f) return -0.5f * x * x * x + 2.5f * x * x - 4.0f * x + 2.0f;
+    return 0.0f;
+}
+
+static float mitchell(float x) {
+    x = fabsf(x);
+    if (x < 1.0f) return (7.0f * x * x * x - 12.0f * x * x + 16.0f / 3.0f) / 6.0f;
+    if (x < 2.0f) return (-7.0f / 3.0f * x * x * x + 12.0f * x * x - 20.0f * x + 32.0f / 3.0f) / 6.0f;
+    return 0.0f;
+}
+
+static float sinc(float x) {
+    if (x == 0.0f) return 1.0f;
+    x *= 3.14159265358979f;
+    return sinf(x) / x;
+}
+
+static float lanczos3(float x) {
+    return fabsf(x) < 3.0f ? sinc(x) * sinc(x / 3.0f) : 0.0f;
+}
+
+static const FilterDef FILTER_BOX = {box, 0.5f};
+static const FilterDef FILTER_TRIANGLE = {triangle, 1.0f};
+static const FilterDef FILTER_CATMULL_ROM = {catmull_rom, 2.0f};
+static const FilterDef FILTER_MITCHELL = {mitchell, 2.0f};
+static const FilterDef FILTER_LANCZOS3 = {lanczos3, 3.0f};
+
+static const FilterDef *filter_def(OverlayResizeFilter filter, int enlarge) {
+    switch (filter) {
+        case OVERLAY_FILTER_BOX: return &FILTER_BOX;
+        case OVERLAY_FILTER_BILINEAR: return &FILTER_TRIANGLE;
+        case OVERLAY_FILTER_CATMULL_ROM: return &FILTER_CATMULL_ROM;
+        case OVERLAY_FILTER_LANCZOS3: return &FILTER_LANCZOS3;
+        default: return enlarge ? &FILTER_CATMULL_ROM : &FILTER_MITCHELL;
+    }
+}
+
+/* Weights for every output sample along one axis. Reductions stretch the
+   filter over 1 / scale source pixels; taps past either edge fold onto the
+   edge sample (clamp), and each set is normalised to 1. */
+static int build_axis(Axis *a, int src, int dst, OverlayResizeFilter filter) {
+    double scale = (double)dst / (double)src;
+    int up = scale >= 1.0;
+    const FilterDef *f = filter_def(filter, up);
+    double support = up ? f->support : f->support / scale;
+    double fscale = up ? 1.0 : scale;
+
+    a->max_taps = (int)ceil(support) * 2 + 2;
+    if (a->max_taps > src) a->max_taps = src;
+    a->contribs = (Contrib *)malloc((size_t)dst * sizeof(Contrib));
+    a->weights = (float *)malloc((size_t)dst * a->max_taps * sizeof(float));
+    if (!a->contribs || !a->weights) return 0;
+
+    for (int d = 0; d < dst; d++) {
+        double center = (d + 0.5) / scale; /* in source pixels, centres at i + 0.5 */
+        int lo = (int)floor(center - support);
+        int hi = (int)ceil(center + support); /* exclusive */
+
+        int first = lo < 0 ? 0 : lo;
+        int last = hi - 1 >= src ? src - 1 : hi - 1;
+        if (first > src - 1) first = src - 1;
+        if (last < 0) last = 0;
+        if (last < first) last = first;
+        int count = last - first + 1;
+
+        float *w = a->weights + (size_t)d * a->max_taps;
+        memset(w, 0, (size_t)a->max_taps * sizeof(float));
+        double sum = 0.0;
+        for (int i = lo; i < hi; i++) {
+            float v = f->fn((float)((i + 0.5 - center) * fscale));
+            if (v == 0.0f) continue;
+            int ci = i < first ? first : (i > last ? last : i);
+            w[ci - first] += v;
+            sum += v;
+        }
+        if (sum != 0.0) {
+            for (int k = 0; k < count; k++) w[k] = (float)(w[k] / sum);
+        } else {
+            w[0] = 1.0f;
+        }
+
+        a->contribs[d].first = first;
+        a->contribs[d].count = count;
+        a->contribs[d].weights = w;
+    }
+    return 1;
+}
+
+static void free_axis(Axis *a) {
+    free(a->contribs);
+    free(a->weights);
+}
+
+/* ---- Kernels ---------------------------------------------------------- */
+
+/* One source row into dst_width float RGBA samples */
+typedef void (*HorizontalFn)(const unsigned char *row, float *out,
+                             const Contrib *contribs, int dst_width);
+
+/* n bytes of one output row from taps horizontally resampled rows: the
+   weighted sum per sample, plus 0.5, clamped to 0..255 and truncated */
+typedef void (*VerticalFn)(const float *const *rows, const float *weights, int taps,
+                           unsigned char *out, size_t n);
+
+/* Products and sums are separate statements so compilers that contract
+   within an expression do not turn them into FMAs the SIMD kernels lack */
+static void horizontal_scalar(const unsigned char *row, float *out,
+                              const Contrib *contribs, int dst_width) {
+    for (int x = 0; x < dst_width; x++) {
+        const Contrib *c = &contribs[x];
+        const unsigned char *p = row + (size_t)c->first * 4;
+        float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+        for (int k = 0; k < c->count; k++, p += 4) {
+            float w = c->weights[k];
+            float t0 = w * p[0], t1 = w * p[1], t2 = w * p[2], t3 = w * p[3];
+            s0 += t0;
+            s1 += t1;
+            s2 += t2;
+            s3 += t3;
+        }
+        out[x * 4 + 0] = s0;
+        out[x * 4 + 1] = s1;
+        out[x * 4 + 2] = s2;
+        out[x * 4 + 3] = s3;
+    }
+}
+
+/* Bytes [begin, n) */
+static void vertical_tail(const float *const *rows, const float *weights, int taps,
+                          unsigned char *out, size_t begin, size_t n) {
+    for (size_t i = begin; i < n; i++) {
+        float s = 0.0f;
+        for (int k = 0; k < taps; k++) {
+            float t = weights[k] * rows[k][i];
+            s += t;
+        }
+        s += 0.5f;
+        out[i] = s <= 0.0f ? 0 : (s >= 255.0f ? 255 : (unsigned char)s);
+    }
+}
+
+static void vertical_scalar(const float *const *rows, const float *weights, int taps,
+                            unsigned char *out, size_t n) {
+    vertical_tail(rows, weights, taps, out, 0, n);
+}
+
+/* 4x4 box: output pixels [begin, dst_width), each (sum + 8) >> 4 */
+static void down4_tail(const unsigned char *const *rows, unsigned char *dst,
+                       int begin, int dst_width) {
+    for (int x = begin; x < dst_width; x++) {
+        for (int k = 0; k < 4; k++) {
+            unsigned int sum = 8;
+            for (int r = 0; r < 4; r++) {
+                const unsigned char *p = rows[r] + (size_t)x * 16 + k;
+                sum += p[0] + p[4] + p[8] + p[12];
+            }
+            dst[(size_t)x * 4 + k] = (unsigned char)(sum >> 4);
+        }
+    }
+}
+
+typedef void (*Down4RowFn)(const unsigned char *const *rows, unsigned char *dst, int dst_width);
+
+static void down4_row_scalar(const unsigned char *const *rows, unsigned char *dst, int dst_width) {
+    down4_tail(rows, dst, 0, dst_width);
+}
+
+#ifdef OVERLAY_ARCH_X86
+OVERLAY_TARGET("sse2")
+static void horizontal_sse2(const unsigned char *row, float *out,
+                            const Contrib *contribs, int dst_width) {
+    const __m128i zero = _mm_setzero_si128();
+    for (int x = 0; x < dst_width; x++) {
+        const Contrib *c = &contribs[x];
+        const unsigned char *p = row + (size_t)c->first * 4;
+        __m128 acc = _mm_setzero_ps();
+        for (int k = 0; k < c->count; k++, p += 4) {
+            int v;
+            memcpy(&v, p, 4);
+            __m128i px = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero), zero);
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(c->weights[k]), _mm_cvtepi32_ps(px)));
+        }
+        _mm_storeu_ps(out + (size_t)x * 4, acc);
+    }
+}
+
+/* Sixteen bytes per step; the clamp happens in float, so the saturating
+   packs never change a value */
+OVERLAY_TARGET("sse2")
+static void vertical_sse2(const float *const *rows, const float *weights, int taps,
+                          unsigned char *out, size_t n) {
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 lo = _mm_setzero_ps();
+    const __m128 hi = _mm_set1_ps(255.0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128 a0 = _mm_setzero_ps(), a1 = a0, a2 = a0, a3 = a0;
+        for (int k = 0; k < taps; k++) {
+            const __m128 w = _mm_set1_ps(weights[k]);
+            const float *r = rows[k] + i;
+            a0 = _mm_add_ps(a0, _mm_mul_ps(w, _mm_loadu_ps(r)));
+            a1 = _mm_add_ps(a1, _mm_mul_ps(w, _mm_loadu_ps(r + 4)));
+            a2 = _mm_add_ps(a2, _mm_mul_ps(w, _mm_loadu_ps(r + 8)));
+            a3 = _mm_add_ps(a3, _mm_mul_ps(w, _mm_loadu_ps(r + 12)));
+        }
+        __m128i q0 = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(a0, half), lo), hi));
+        __m128i q1 = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(a1, half), lo), hi));
+        __m128i q2 = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(a2, half), lo), hi));
+        __m128i q3 = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(a3, half), lo), hi));
+        _mm_storeu_si128((__m128i *)(out + i),
+                         _mm_packus_epi16(_mm_packs_epi32(q0, q1), _mm_packs_epi32(q2, q3)));
+    }
+    vertical_tail(rows, weights, taps, out, i, n);
+}
+
+/* One output pixel per step: four rows summed in 16-bit lanes, then the
+   two halves and the two remaining pixels folded together */
+OVERLAY_TARGET("sse2")
+static void down4_row_sse2(const unsigned char *const *rows, unsigned char *dst, int dst_width) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i eight = _mm_set1_epi16(8);
+    for (int x = 0; x < dst_width; x++) {
+        __m128i lo = zero, hi = zero;
+        for (int r = 0; r < 4; r++) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(rows[r] + (size_t)x * 16));
+            lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+            hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+        }
+        __m128i sum = _mm_add_epi16(lo, hi);
+        sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, eight), 4);
+        int px = _mm_cvtsi128_si32(_mm_packus_epi16(sum, zero));
+        memcpy(dst + (size_t)x * 4, &px, 4);
+    }
+}
+#endif /* OVERLAY_ARCH_X86 */
+
+#ifdef OVERLAY_ARCH_NEON
+static void horizontal_neon(const unsigned char *row, float *out,
+                            const Contrib *contribs, int dst_width) {
+    for (int x = 0; x < dst_width; x++) {
+        const Contrib *c = &contribs[x];
+        const unsigned char *p = row + (size_t)c->first * 4;
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        for (int k = 0; k < c->count; k++, p += 4) {
+            uint32_t v;
+            memcpy(&v, p, 4);
+            uint16x8_t px16 = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(v)));
+            float32x4_t px = vcvtq_f32_u32(vmovl_u16(vget_low_u16(px16)));
+            acc = vaddq_f32(acc, vmulq_n_f32(px, c->weights[k]));
+        }
+        vst1q_f32(out + (size_t)x * 4, acc);
+    }
+}
+
+static uint16x4_t vertical_narrow_neon(float32x4_t a) {
+    a = vminq_f32(vmaxq_f32(vaddq_f32(a, vdupq_n_f32(0.5f)), vdupq_n_f32(0.0f)),
+                  vdupq_n_f32(255.0f));
+    return vmovn_u32(vcvtq_u32_f32(a));
+}
+
+static void vertical_neon(const float *const *rows, const float *weights, int taps,
+                          unsigned char *out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        float32x4_t a0 = vdupq_n_f32(0.0f), a1 = a0, a2 = a0, a3 = a0;
+        for (int k = 0; k < taps; k++) {
+            const float w = weights[k];
+            const float *r = rows[k] + i;
+            a0 = vaddq_f32(a0, vmulq_n_f32(vld1q_f32(r), w));
+            a1 = vaddq_f32(a1, vmulq_n_f32(vld1q_f32(r + 4), w));
+            a2 = vaddq_f32(a2, vmulq_n_f32(vld1q_f32(r + 8), w));
+            a3 = vaddq_f32(a3, vmulq_n_f32(vld1q_f32(r + 12), w));
+        }
+        uint8x8_t b01 = vmovn_u16(vcombine_u16(vertical_narrow_neon(a0), vertical_narrow_neon(a1)));
+        uint8x8_t b23 = vmovn_u16(vcombine_u16(vertical_narrow_neon(a2), vertical_narrow_neon(a3)));
+        vst1q_u8(out + i, vcombine_u8(b01, b23));
+    }
+    vertical_tail(rows, weights, taps, out, i, n);
+}
+
+/* Sixteen input pixels per row, deinterleaved by vld4q: two pairwise
+   widening adds give the 4-pixel sums, vrshrn rounds (sum + 8) >> 4 */
+static void down4_row_neon(const unsigned char *const *rows, unsigned char *dst, int dst_width) {
+    int x = 0;
+    for (; x + 4 <= dst_width; x += 4) {
+        uint8x16x4_t r0 = vld4q_u8(rows[0] + (size_t)x * 16);
+        uint8x16x4_t r1 = vld4q_u8(rows[1] + (size_t)x * 16);
+        uint8x16x4_t r2 = vld4q_u8(rows[2] + (size_t)x * 16);
+        uint8x16x4_t r3 = vld4q_u8(rows[3] + (size_t)x * 16);
+        uint8x8x4_t out;
+        for (int k = 0; k < 4; k++) {
+            uint16x8_t pairs = vaddq_u16(vaddq_u16(vpaddlq_u8(r0.val[k]), vpaddlq_u8(r1.val[k])),
+                                         vaddq_u16(vpaddlq_u8(r2.val[k]), vpaddlq_u8(r3.val[k])));
+            uint16x4_t mean = vrshrn_n_u32(vpaddlq_u16(pairs), 4);
+            out.val[k] = vmovn_u16(vcombine_u16(mean, mean));
+        }
+        vst4_lane_u8(dst + (size_t)x * 4, out, 0);
+        vst4_lane_u8(dst + (size_t)x * 4 + 4, out, 1);
+        vst4_lane_u8(dst + (size_t)x * 4 + 8, out, 2);
+        vst4_lane_u8(dst + (size_t)x * 4 + 12, out, 3);
+    }
+    down4_tail(rows, dst, x, dst_width);
+}
+#endif /* OVERLAY_ARCH_NEON */
+
+typedef struct {
+    HorizontalFn horizontal;
+    VerticalFn vertical;
+    Down4RowFn down4;
+} Kernels;
+
+static Kernels get_kernels(void) {
+    Kernels k;
+    k.horizontal = horizontal_scalar;
+    k.vertical = vertical_scalar;
+    k.down4 = down4_row_scalar;
+    switch (overlay_get_simd_level()) {
+#ifdef OVERLAY_ARCH_X86
+        case OVERLAY_SIMD_SSE2:
+        case OVERLAY_SIMD_AVX2:
+            k.horizontal = horizontal_sse2;
+            k.vertical = vertical_sse2;
+            k.down4 = down4_row_sse2;
+            break;
+#endif
+#ifdef OVERLAY_ARCH_NEON
+        case OVERLAY_SIMD_NEON:
+            k.horizontal = horizontal_neon;
+            k.vertical = vertical_neon;
+            k.down4 = down4_row_neon;
+            break;
+#endif
+        default:
+            break;
+    }
+    return k;
+}
+
+/* ---- Plans ------------------------------------------------------------ */
+
+OverlayResamplePlan *overlay_resample_plan_create(int src_width, int src_height,
+                                                  int dst_width, int dst_height,
+                                                  OverlayResizeFilter filter) {
+    if (src_width < 1 || src_height < 1 || dst_width < 1 || dst_height < 1) return NULL;
+
+    OverlayResamplePlan *plan = (OverlayResamplePlan *)calloc(1, sizeof(OverlayResamplePlan));
+    if (!plan) return NULL;
+    plan->src_width = src_width;
+    plan->src_height = src_height;
+    plan->dst_width = dst_width;
+    plan->dst_height = dst_height;
+    if (!build_axis(&plan->h, src_width, dst_width, filter) ||
+        !build_axis(&plan->v, src_height, dst_height, filter)) {
+        overlay_resample_plan_free(plan);
+        return NULL;
+    }
+    for (int y = 0; y < dst_height; y++) {
+        if (plan->v.contribs[y].count > plan->ring_rows) plan->ring_rows = plan->v.contribs[y].count;
+    }
+
+    /* The tables give the same pixels; these just skip the float passes */
+    if (filter == OVERLAY_FILTER_BOX) {
+        if (src_width == 2 * dst_width && src_height == 2 * dst_height) {
+            plan->fast = FAST_BOX_DOWN2;
+        } else if (src_width == 4 * dst_width && src_height == 4 * dst_height) {
+            plan->fast = FAST_BOX_DOWN4;
+        } else if (dst_width % src_width == 0 && dst_height % src_height == 0) {
+            plan->fast = FAST_BOX_REPLICATE;
+        }
+    }
+    return plan;
+}
+
+void overlay_resample_plan_free(OverlayResamplePlan *plan) {
+    if (!plan) return;
+    free_axis(&plan->h);
+    free_axis(&plan->v);
+    free(plan);
+}
+
+static void replicate_rows(const OverlayResamplePlan *plan, const unsigned char *src,
+                           unsigned char *dst, int begin, int end) {
+    int kx = plan->dst_width / plan->src_width;
+    int ky = plan->dst_height / plan->src_height;
+    size_t stride = (size_t)plan->dst_width * 4;
+    for (int y = begin; y < end; y++) {
+        unsigned char *out = dst + (size_t)y * stride;
+        if (y > begin && y % ky != 0) {
+            memcpy(out, out - stride, stride);
+            continue;
+        }
+        const unsigned char *in = src + (size_t)(y / ky) * plan->src_width * 4;
+        for (int x = 0; x < plan->src_width; x++) {
+            for (int j = 0; j < kx; j++) memcpy(out + ((size_t)x * kx + j) * 4, in + (size_t)x * 4, 4);
+        }
+    }
+}
+
+int overlay_resample_rows(const OverlayResamplePlan *plan, const unsigned char *src,
+                          unsigned char *dst, int begin, int end) {
+    if (!plan || !src || !dst) return 0;
+    if (begin < 0) begin = 0;
+    if (end > plan->dst_height) end = plan->dst_height;
+    if (begin >= end) return 1;
+
+    size_t src_stride = (size_t)plan->src_width * 4;
+    size_t dst_stride = (size_t)plan->dst_width * 4;
+    Kernels k = get_kernels();
+
+    if (plan->fast == FAST_BOX_DOWN2) {
+        OverlayDownsampleRowFn row_fn = overlay_get_downsample_row();
+        for (int y = begin; y < end; y++) {
+            row_fn(src + (size_t)(2 * y) * src_stride, src + (size_t)(2 * y + 1) * src_stride,
+                   dst + (size_t)y * dst_stride, plan->dst_width, plan->src_width);
+        }
+        return 1;
+    }
+    if (plan->fast == FAST_BOX_DOWN4) {
+        for (int y = begin; y < end; y++) {
+            const unsigned char *rows[4];
+            for (int r = 0; r < 4; r++) rows[r] = src + (size_t)(4 * y + r) * src_stride;
+            k.down4(rows, dst + (size_t)y * dst_stride, plan->dst_width);
+        }
+        return 1;
+    }
+    if (plan->fast == FAST_BOX_REPLICATE) {
+        replicate_rows(plan, src, dst, begin, end);
+        return 1;
+    }
+
+    float *ring = (float *)malloc((size_t)plan->ring_rows * dst_stride * sizeof(float));
+    const float **taps = (const float **)malloc((size_t)plan->ring_rows * sizeof(float *));
+    if (!ring || !taps) {
+        free(ring);
+        free(taps);
+        return 0;
+    }
+
+    /* Footprints only move down, so each source row is resampled once */
+    int next = plan->v.contribs[begin].first;
+    for (int y = begin; y < end; y++) {
+        const Contrib *c = &plan->v.contribs[y];
+        if (next < c->first) next = c->first;
+        for (; next < c->first + c->count; next++) {
+            k.horizontal(src + (size_t)next * src_stride,
+                         ring + (size_t)(next % plan->ring_rows) * dst_stride,
+                         plan->h.contribs, plan->dst_width);
+        }
+        for (int t = 0; t < c->count; t++) {
+            taps[t] = ring + (size_t)((c->first + t) % plan->ring_rows) * dst_stride;
+        }
+        k.vertical(taps, c->weights, c->count, dst + (size_t)y * dst_stride, dst_stride);
+    }
+
+    free(ring);
+    free(taps);
+    return 1;
+}
+
+/* ---- Streaming -------------------------------------------------------- */
+
+OverlayResampler *overlay_resampler_create(int src_width, int src_height,
+                                           unsigned char *dst, int dst_width, int dst_height,
+                                           OverlayResizeFilter filter) {
+    if (!dst) return NULL;
+
+    OverlayResampler *r = (OverlayResampler *)calloc(1, sizeof(OverlayResampler));
+    if (!r) return NULL;
+    r->dst = dst;
+    r->plan = overlay_resample_plan_create(src_width, src_height, dst_width, dst_height, filter);
+    if (!r->plan) {
+        free(r);
+        return NULL;
+    }
+
+    /* Output rows need consecutive source rows, so the widest vertical
+       footprint bounds how many are live at once */
+    r->ring = (float *)malloc((size_t)r->plan->ring_rows * dst_width * 4 * sizeof(float));
+    r->taps = (const float **)malloc((size_t)r->plan->ring_rows * sizeof(float *));
+    if (!r->ring || !r->taps) {
+        overlay_resampler_destroy(r);
+        return NULL;
+    }
+    return r;
+}
+
+void overlay_resampler_push_row(OverlayResampler *r, const unsigned char *row) {
+    if (!r || !row || r->next_src >= r->plan->src_height) return;
+
+    const OverlayResamplePlan *plan = r->plan;
+    size_t stride = (size_t)plan->dst_width * 4;
+    Kernels k = get_kernels();
+    int sy = r->next_src++;
+    k.horizontal(row, r->ring + (size_t)(sy % plan->ring_rows) * stride,
+                 plan->h.contribs, plan->dst_width);
+
+    /* Every output row whose footprint ends here is now complete */
+    while (r->next_dst < plan->dst_height) {
+        const Contrib *c = &plan->v.contribs[r->next_dst];
+        if (c->first + c->count - 1 > sy) break;
+        for (int t = 0; t < c->count; t++) {
+            r->taps[t] = r->ring + (size_t)((c->first + t) % plan->ring_rows) * stride;
+        }
+        k.vertical(r->taps, c->weights, c->count, r->dst + (size_t)r->next_dst * stride, stride);
+        r->next_dst++;
+    }
+}
+
+void overlay_resampler_destroy(OverlayResampler *r) {
+    if (!r) return;
+    overlay_resample_plan_free(r->plan);
+    free(r->ring);
+    free(r->taps);
+    free(r);
+}
@@ -0,0 +1,49 @@
+#ifndef OVERLAY_RESAMPLE_H
+#define OVERLAY_RESAMPLE_H
+
+/* Internal separable resampler used by overlay.c. A plan holds the filter
+   weight tables for one source/destination size pair; whole images are
+   resampled in row bands from it (safe to run bands on several threads),
+   and streaming decodes push source rows into an OverlayResampler, which
+   writes each output row as soon as the rows under its filter arrived.
+   Edges are clamped. The filter is chosen through overlay.h
+   (overlay_set_resize_filter). */
+
+#include "overlay.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct OverlayResamplePlan OverlayResamplePlan;
+
+/* NULL on bad sizes or allocation failure */
+OverlayResamplePlan *overlay_resample_plan_create(int src_width, int src_height,
+                                                  int dst_width, int dst_height,
+                                                  OverlayResizeFilter filter);
+void overlay_resample_plan_free(OverlayResamplePlan *plan);
+
+/* Write output rows [begin, end) of dst (dst_width * 4 bytes per row) from
+   the whole source image. Returns 0 on allocation failure. */
+int overlay_resample_rows(const OverlayResamplePlan *plan, const unsigned char *src,
+                          unsigned char *dst, int begin, int end);
+
+typedef struct OverlayResampler OverlayResampler;
+
+/* Resample RGBA src_width x src_height into dst (dst_width x dst_height,
+   caller-owned) as rows arrive. Same pixels as overlay_resample_rows with
+   the same filter. NULL on allocation failure. */
+OverlayResampler *overlay_resampler_create(int src_width, int src_height,
+                                           unsigned char *dst, int dst_width, int dst_height,
+                                           OverlayResizeFilter filter);
+
+/* Feed the next source row (src_width * 4 bytes) */
+void overlay_resampler_push_row(OverlayResampler *r, const unsigned char *row);
+
+void overlay_resampler_destroy(OverlayResampler *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLAY_RESAMPLE_H */
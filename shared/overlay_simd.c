@@ -0,0 +1,505 @@
+#include "overlay_simd.h"
+#include <stdint.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/* Compile opacity into the alpha table and look for a 16-bit multiplier that
+   reproduces it. For every a > 0 the multiplier must land in
+   [lut*65536/a, (lut+1)*65536/a); intersecting those ranges gives the valid
+   multipliers, if any. */
+void overlay_effect_params_init(OverlayEffectParams *params, float opacity, int invert) {
+    if (opacity < 0.0f) opacity = 0.0f;
+    if (opacity > 1.0f) opacity = 1.0f;
+
+    params->invert = invert ? 1 : 0;
+    params->premultiply = 0;
+    params->swap_rb = 0;
+    params->alpha_identity = 1;
+    for (int a = 0; a < 256; a++) {
+        params->alpha_lut[a] = (unsigned char)(a * opacity);
+        if (params->alpha_lut[a] != a) params->alpha_identity = 0;
+    }
+
+    long lo = 0, hi = 65535;
+    for (long a = 1; a < 256 && lo <= hi; a++) {
+        long v = params->alpha_lut[a];
+        long min_m = (v * 65536 + a - 1) / a;
+        long max_m = ((v + 1) * 65536 - 1) / a;
+        if (min_m > lo) lo = min_m;
+        if (max_m < hi) hi = max_m;
+    }
+    params->alpha_mul_exact = lo <= hi;
+    params->alpha_mul = (uint16_t)(params->alpha_mul_exact ? lo : 0);
+}
+
+void overlay_effect_params_set_format(OverlayEffectParams *params, OverlayPixelFormat format) {
+    params->premultiply = format == OVERLAY_FORMAT_RGBA_PREMUL ||
+                          format == OVERLAY_FORMAT_BGRA_PREMUL;
+    params->swap_rb = format == OVERLAY_FORMAT_BGRA_PREMUL;
+}
+
+/* Rounded c * a / 255 without a divide; equals (c * a + 127) / 255 for all
+   8-bit inputs, and the SIMD kernels use the same formula in 16-bit lanes. */
+static unsigned char premul_channel(unsigned int c, unsigned int a) {
+    unsigned int t = c * a + 128;
+    return (unsigned char)((t + (t >> 8)) >> 8);
+}
+
+/* Reference for the output-format stage (premultiply and/or R/B swap) */
+static void overlay_effects_format_scalar(const unsigned char *src, unsigned char *dst,
+                                          size_t count, const OverlayEffectParams *params) {
+    const unsigned char *lut = params->alpha_lut;
+    const unsigned int flip = params->invert ? 255 : 0;
+    for (size_t i = 0; i < count; i++, src += 4, dst += 4) {
+        unsigned int r = src[0] ^ flip;
+        unsigned int g = src[1] ^ flip;
+        unsigned int b = src[2] ^ flip;
+        unsigned int a = lut[src[3]];
+        if (params->premultiply) {
+            r = premul_channel(r, a);
+            g = premul_channel(g, a);
+            b = premul_channel(b, a);
+        }
+        dst[0] = (unsigned char)(params->swap_rb ? b : r);
+        dst[1] = (unsigned char)g;
+        dst[2] = (unsigned char)(params->swap_rb ? r : b);
+        dst[3] = (unsigned char)a;
+    }
+}
+
+/* Scalar reference */
+void overlay_effects_scalar(const unsigned char *src, unsigned char *dst,
+                            size_t count, const OverlayEffectParams *params) {
+    const unsigned char *lut = params->alpha_lut;
+    if (params->premultiply || params->swap_rb) {
+        overlay_effects_format_scalar(src, dst, count, params);
+    } else if (params->invert) {
+        for (size_t i = 0; i < count; i++, src += 4, dst += 4) {
+            dst[0] = 255 - src[0]; /* R */
+            dst[1] = 255 - src[1]; /* G */
+            dst[2] = 255 - src[2]; /* B */
+            dst[3] = lut[src[3]];  /* A */
+        }
+    } else if (!params->alpha_identity) {
+        for (size_t i = 0; i < count; i++, src += 4, dst += 4) {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            dst[3] = lut[src[3]];
+        }
+    } else if (src != dst) {
+        memcpy(dst, src, count * 4);
+    }
+}
+
+/* Whether the SIMD kernels can reproduce alpha_lut. Identity needs a
+   multiplier of 65536, which does not fit in alpha_mul, but the kernels keep
+   alpha as it is in that case and never multiply. */
+#if defined(OVERLAY_ARCH_X86) || defined(OVERLAY_ARCH_NEON)
+static int alpha_vectorizable(const OverlayEffectParams *params) {
+    return params->alpha_identity || params->alpha_mul_exact;
+}
+#endif
+
+#ifdef OVERLAY_ARCH_X86
+/* Leading pixels to run scalar so dst reaches `align` bytes, or SIZE_MAX when
+   dst can never get there (not pixel aligned). */
+static size_t pixels_to_alignment(const unsigned char *dst, size_t align) {
+    uintptr_t mis = (uintptr_t)dst & (align - 1);
+    if (mis == 0) return 0;
+    if (mis & 3) return (size_t)-1;
+    return (align - mis) / 4;
+}
+
+/* Output-format stage, four pixels per step: effects as below, then widen
+   to 16-bit lanes, premultiply with the shared rounding formula (alpha lanes
+   multiply by 255, which leaves them unchanged) and swap R/B with a word
+   shuffle before packing back. */
+OVERLAY_TARGET("sse2")
+static void overlay_effects_format_sse2(const unsigned char *src, unsigned char *dst,
+                                        size_t count, const OverlayEffectParams *params) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i xor_mask = params->invert ? rgb_mask : zero;
+    const __m128i alpha_keep = params->alpha_identity ? _mm_set1_epi32((int)0xFF000000u) : zero;
+    const __m128i mul = _mm_set1_epi32(params->alpha_identity ? 0 : params->alpha_mul);
+    const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    const __m128i alpha_one = _mm_and_si128(_mm_set1_epi16(255), alpha_lanes);
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i rb_mask = _mm_set1_epi32(0x00FF00FF);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4, src += 16, dst += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)src);
+        __m128i rgb = _mm_and_si128(_mm_xor_si128(v, xor_mask), rgb_mask);
+        __m128i alpha = _mm_or_si128(_mm_and_si128(v, alpha_keep),
+                                     _mm_slli_epi32(_mm_mulhi_epu16(_mm_srli_epi32(v, 24), mul), 24));
+        __m128i p = _mm_or_si128(rgb, alpha);
+
+        if (params->premultiply) {
+            __m128i lo = _mm_unpacklo_epi8(p, zero);
+            __m128i hi = _mm_unpackhi_epi8(p, zero);
+            __m128i alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xFF), 0xFF);
+            __m128i ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xFF), 0xFF);
+            alo = _mm_or_si128(_mm_andnot_si128(alpha_lanes, alo), alpha_one);
+            ahi = _mm_or_si128(_mm_andnot_si128(alpha_lanes, ahi), alpha_one);
+            __m128i tlo = _mm_add_epi16(_mm_mullo_epi16(lo, alo), bias);
+            __m128i thi = _mm_add_epi16(_mm_mullo_epi16(hi, ahi), bias);
+            lo = _mm_srli_epi16(_mm_add_epi16(tlo, _mm_srli_epi16(tlo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(thi, _mm_srli_epi16(thi, 8)), 8);
+            if (params->swap_rb) {
+                lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+                hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+            }
+            p = _mm_packus_epi16(lo, hi);
+        } else if (params->swap_rb) {
+            __m128i rb = _mm_and_si128(p, rb_mask);
+            rb = _mm_or_si128(_mm_srli_epi32(rb, 16), _mm_slli_epi32(rb, 16));
+            p = _mm_or_si128(_mm_andnot_si128(rb_mask, p), rb);
+        }
+        _mm_storeu_si128((__m128i *)dst, p);
+    }
+    overlay_effects_format_scalar(src, dst, count - i, params);
+}
+
+OVERLAY_TARGET("avx2")
+static void overlay_effects_format_avx2(const unsigned char *src, unsigned char *dst,
+                                        size_t count, const OverlayEffectParams *params) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i rgb_mask = _mm256_set1_epi32(0x00FFFFFF);
+    const __m256i xor_mask = params->invert ? rgb_mask : zero;
+    const __m256i alpha_keep = params->alpha_identity ? _mm256_set1_epi32((int)0xFF000000u) : zero;
+    const __m256i mul = _mm256_set1_epi32(params->alpha_identity ? 0 : params->alpha_mul);
+    const __m256i alpha_lanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0,
+                                                 -1, 0, 0, 0, -1, 0, 0, 0);
+    const __m256i alpha_one = _mm256_and_si256(_mm256_set1_epi16(255), alpha_lanes);
+    const __m256i bias = _mm256_set1_epi16(128);
+    const __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+    size_t i = 0;
+
+    /* unpack/pack work within 128-bit lanes, so pixel order is preserved */
+    for (; i + 8 <= count; i += 8, src += 32, dst += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)src);
+        __m256i rgb = _mm256_and_si256(_mm256_xor_si256(v, xor_mask), rgb_mask);
+        __m256i alpha = _mm256_or_si256(_mm256_and_si256(v, alpha_keep),
+                                        _mm256_slli_epi32(_mm256_mulhi_epu16(_mm256_srli_epi32(v, 24), mul), 24));
+        __m256i p = _mm256_or_si256(rgb, alpha);
+
+        if (params->premultiply) {
+            __m256i lo = _mm256_unpacklo_epi8(p, zero);
+            __m256i hi = _mm256_unpackhi_epi8(p, zero);
+            __m256i alo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, 0xFF), 0xFF);
+            __m256i ahi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, 0xFF), 0xFF);
+            alo = _mm256_or_si256(_mm256_andnot_si256(alpha_lanes, alo), alpha_one);
+            ahi = _mm256_or_si256(_mm256_andnot_si256(alpha_lanes, ahi), alpha_one);
+            __m256i tlo = _mm256_add_epi16(_mm256_mullo_epi16(lo, alo), bias);
+            __m256i thi = _mm256_add_epi16(_mm256_mullo_epi16(hi, ahi), bias);
+            lo = _mm256_srli_epi16(_mm256_add_epi16(tlo, _mm256_srli_epi16(tlo, 8)), 8);
+            hi = _mm256_srli_epi16(_mm256_add_epi16(thi, _mm256_srli_epi16(thi, 8)), 8);
+            if (params->swap_rb) {
+                lo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+                hi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+            }
+            p = _mm256_packus_epi16(lo, hi);
+        } else if (params->swap_rb) {
+            __m256i rb = _mm256_and_si256(p, rb_mask);
+            rb = _mm256_or_si256(_mm256_srli_epi32(rb, 16), _mm256_slli_epi32(rb, 16));
+            p = _mm256_or_si256(_mm256_andnot_si256(rb_mask, p), rb);
+        }
+        _mm256_storeu_si256((__m256i *)dst, p);
+    }
+    overlay_effects_format_sse2(src, dst, count - i, params);
+}
+
+/* Four pixels per step. 255 - x == x ^ 0xFF for bytes, so invert is an xor on
+   RGB. Alpha sits alone in the low 16 bits of each lane after the shift, so
+   mulhi_epu16 against the compiled multiplier gives (a * mul) >> 16 and the
+   zero high halves stay zero. Large copies use streaming stores. */
+OVERLAY_TARGET("sse2")
+static void overlay_effects_sse2(const unsigned char *src, unsigned char *dst,
+                                 size_t count, const OverlayEffectParams *params) {
+    if (params->premultiply || params->swap_rb) {
+        if (alpha_vectorizable(params)) {
+            overlay_effects_format_sse2(src, dst, count, params);
+        } else {
+            overlay_effects_scalar(src, dst, count, params);
+        }
+        return;
+    }
+    if (!alpha_vectorizable(params) || (!params->invert && params->alpha_identity)) {
+        overlay_effects_scalar(src, dst, count, params);
+        return;
+    }
+    const __m128i rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i xor_mask = params->invert ? rgb_mask : _mm_setzero_si128();
+    const __m128i keep_mask = params->alpha_identity ? _mm_set1_epi32(-1) : rgb_mask;
+    const __m128i mul = _mm_set1_epi32(params->alpha_identity ? 0 : params->alpha_mul);
+    size_t i = 0;
+
+    int stream = src != dst && count * 4 >= OVERLAY_STREAM_MIN_BYTES;
+    if (stream) {
+        size_t head = pixels_to_alignment(dst, 16);
+        if (head > count) {
+            stream = 0;
+        } else if (head) {
+            overlay_effects_scalar(src, dst, head, params);
+            i = head;
+            src += head * 4;
+            dst += head * 4;
+        }
+    }
+
+#define SSE2_EFFECT_LOOP(STORE)                                                      \
+    for (; i + 4 <= count; i += 4, src += 16, dst += 16) {                           \
+        __m128i v = _mm_loadu_si128((const __m128i *)src);                           \
+        __m128i kept = _mm_and_si128(_mm_xor_si128(v, xor_mask), keep_mask);         \
+        __m128i alpha = _mm_slli_epi32(_mm_mulhi_epu16(_mm_srli_epi32(v, 24), mul), 24); \
+        STORE((__m128i *)dst, _mm_or_si128(kept, alpha));                            \
+    }
+    if (stream) {
+        SSE2_EFFECT_LOOP(_mm_stream_si128)
+        _mm_sfence();
+    } else {
+        SSE2_EFFECT_LOOP(_mm_storeu_si128)
+    }
+#undef SSE2_EFFECT_LOOP
+    overlay_effects_scalar(src, dst, count - i, params);
+}
+
+OVERLAY_TARGET("avx2")
+static void overlay_effects_avx2(const unsigned char *src, unsigned char *dst,
+                                 size_t count, const OverlayEffectParams *params) {
+    if (params->premultiply || params->swap_rb) {
+        if (alpha_vectorizable(params)) {
+            overlay_effects_format_avx2(src, dst, count, params);
+        } else {
+            overlay_effects_scalar(src, dst, count, params);
+        }
+        return;
+    }
+    if (!alpha_vectorizable(params) || (!params->invert && params->alpha_identity)) {
+        overlay_effects_scalar(src, dst, count, params);
+        return;
+    }
+    const __m256i rgb_mask = _mm256_set1_epi32(0x00FFFFFF);
+    const __m256i xor_mask = params->invert ? rgb_mask : _mm256_setzero_si256();
+    const __m256i keep_mask = params->alpha_identity ? _mm256_set1_epi32(-1) : rgb_mask;
+    const __m256i mul = _mm256_set1_epi32(params->alpha_identity ? 0 : params->alpha_mul);
+    size_t i = 0;
+
+    int stream = src != dst && count * 4 >= OVERLAY_STREAM_MIN_BYTES;
+    if (stream) {
+        size_t head = pixels_to_alignment(dst, 32);
+        if (head > count) {
+            stream = 0;
+        } else if (head) {
+            overlay_effects_scalar(src, dst, head, params);
+            i = head;
+            src += head * 4;
+            dst += head * 4;
+        }
+    }
+
+#define AVX2_EFFECT_LOOP(STORE)                                                      \
+    for (; i + 8 <= count; i += 8, src += 32, dst += 32) {                           \
+        __m256i v = _mm256_loadu_si256((const __m256i *)src);                        \
+        __m256i kept = _mm256_and_si256(_mm256_xor_si256(v, xor_mask), keep_mask);   \
+        __m256i alpha = _mm256_slli_epi32(_mm256_mulhi_epu16(_mm256_srli_epi32(v, 24), mul), 24); \
+        STORE((__m256i *)dst, _mm256_or_si256(kept, alpha));                         \
+    }
+    if (stream) {
+        AVX2_EFFECT_LOOP(_mm256_stream_si256)
+        _mm_sfence();
+    } else {
+        AVX2_EFFECT_LOOP(_mm256_storeu_si256)
+    }
+#undef AVX2_EFFECT_LOOP
+    overlay_effects_scalar(src, dst, count - i, params);
+}
+
+static int cpu_has_sse2(void) {
+#if defined(__x86_64__) || defined(_M_X64)
+    return 1;
+#elif defined(_MSC_VER)
+    int r[4];
+    __cpuid(r, 1);
+    return (r[3] >> 26) & 1;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+static int cpu_has_avx2(void) {
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] < 7) return 0;
+    __cpuid(r, 1);
+    /* AVX and OSXSAVE, then make sure the OS saves YMM state */
+    if (((r[2] >> 27) & 1) == 0 || ((r[2] >> 28) & 1) == 0) return 0;
+    if ((_xgetbv(0) & 6) != 6) return 0;
+    __cpuidex(r, 7, 0);
+    return (r[1] >> 5) & 1;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif /* OVERLAY_ARCH_X86 */
+
+#ifdef OVERLAY_ARCH_NEON
+/* NEON has no non-temporal store intrinsic; plain stores are used for both
+   the in-place and copy paths. */
+static void overlay_effects_format_neon(const unsigned char *src, unsigned char *dst,
+                                        size_t count, const OverlayEffectParams *params) {
+    const uint8x8_t flip = vdup_n_u8(params->invert ? 0xFF : 0);
+    const uint16x8_t bias = vdupq_n_u16(128);
+    const uint16_t mul = params->alpha_mul;
+    size_t i = 0;
+
+    /* vld4/vst4 deinterleave eight pixels into per-channel registers */
+    for (; i + 8 <= count; i += 8, src += 32, dst += 32) {
+        uint8x8x4_t px = vld4_u8(src);
+        uint8x8_t r = veor_u8(px.val[0], flip);
+        uint8x8_t g = veor_u8(px.val[1], flip);
+        uint8x8_t b = veor_u8(px.val[2], flip);
+        uint8x8_t a = px.val[3];
+        if (!params->alpha_identity) {
+            uint16x8_t a16 = vmovl_u8(a);
+            uint16x4_t alo = vshrn_n_u32(vmull_n_u16(vget_low_u16(a16), mul), 16);
+            uint16x4_t ahi = vshrn_n_u32(vmull_n_u16(vget_high_u16(a16), mul), 16);
+            a = vmovn_u16(vcombine_u16(alo, ahi));
+        }
+        if (params->premultiply) {
+            uint16x8_t tr = vmlal_u8(bias, r, a);
+            uint16x8_t tg = vmlal_u8(bias, g, a);
+            uint16x8_t tb = vmlal_u8(bias, b, a);
+            r = vshrn_n_u16(vsraq_n_u16(tr, tr, 8), 8);
+            g = vshrn_n_u16(vsraq_n_u16(tg, tg, 8), 8);
+            b = vshrn_n_u16(vsraq_n_u16(tb, tb, 8), 8);
+        }
+        uint8x8x4_t out;
+        out.val[0] = params->swap_rb ? b : r;
+        out.val[1] = g;
+        out.val[2] = params->swap_rb ? r : b;
+        out.val[3] = a;
+        vst4_u8(dst, out);
+    }
+    overlay_effects_format_scalar(src, dst, count - i, params);
+}
+
+static void overlay_effects_neon(const unsigned char *src, unsigned char *dst,
+                                 size_t count, const OverlayEffectParams *params) {
+    if (params->premultiply || params->swap_rb) {
+        if (alpha_vectorizable(params)) {
+            overlay_effects_format_neon(src, dst, count, params);
+        } else {
+            overlay_effects_scalar(src, dst, count, params);
+        }
+        return;
+    }
+    if (!alpha_vectorizable(params) || (!params->invert && params->alpha_identity)) {
+        overlay_effects_scalar(src, dst, count, params);
+        return;
+    }
+    const uint32x4_t rgb_mask = vdupq_n_u32(0x00FFFFFF);
+    const uint32x4_t xor_mask = params->invert ? rgb_mask : vdupq_n_u32(0);
+    const uint32x4_t keep_mask = params->alpha_identity ? vdupq_n_u32(0xFFFFFFFF) : rgb_mask;
+    const uint32_t mul = params->alpha_identity ? 0 : params->alpha_mul;
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4, src += 16, dst += 16) {
+        uint32x4_t v = vreinterpretq_u32_u8(vld1q_u8(src));
+        uint32x4_t kept = vandq_u32(veorq_u32(v, xor_mask), keep_mask);
+        /* a <= 255 and mul <= 65535, so the 32-bit product cannot overflow */
+        uint32x4_t alpha = vshlq_n_u32(vshrq_n_u32(vmulq_n_u32(vshrq_n_u32(v, 24), mul), 16), 24);
+        vst1q_u8(dst, vreinterpretq_u8_u32(vorrq_u32(kept, alpha)));
+    }
+    overlay_effects_scalar(src, dst, count - i, params);
+}
+#endif /* OVERLAY_ARCH_NEON */
+
+/* Runtime dispatch: detect once, then every call goes through g_kernel */
+static OverlaySimdLevel g_detected = OVERLAY_SIMD_SCALAR;
+static OverlaySimdLevel g_level = OVERLAY_SIMD_SCALAR;
+static OverlayEffectKernel g_kernel = overlay_effects_scalar;
+
+static OverlayEffectKernel kernel_for_level(OverlaySimdLevel level) {
+    switch (level) {
+#ifdef OVERLAY_ARCH_X86
+        case OVERLAY_SIMD_SSE2: return overlay_effects_sse2;
+        case OVERLAY_SIMD_AVX2: return overlay_effects_avx2;
+#endif
+#ifdef OVERLAY_ARCH_NEON
+        case OVERLAY_SIMD_NEON: return overlay_effects_neon;
+#endif
+        default: return overlay_effects_scalar;
+    }
+}
+
+static void detect_simd_level(void) {
+    OverlaySimdLevel level = OVERLAY_SIMD_SCALAR;
+#ifdef OVERLAY_ARCH_X86
+    if (cpu_has_sse2()) level = OVERLAY_SIMD_SSE2;
+    if (level == OVERLAY_SIMD_SSE2 && cpu_has_avx2()) level = OVERLAY_SIMD_AVX2;
+#endif
+#ifdef OVERLAY_ARCH_NEON
+    level = OVERLAY_SIMD_NEON;
+#endif
+    g_detected = level;
+    g_level = level;
+    g_kernel = kernel_for_level(level);
+}
+
+#ifdef _WIN32
+static INIT_ONCE g_detect_once = INIT_ONCE_STATIC_INIT;
+static BOOL CALLBACK detect_once_cb(PINIT_ONCE once, PVOID param, PVOID *ctx) {
+    (void)once; (void)param; (void)ctx;
+    detect_simd_level();
+    return TRUE;
+}
+static void ensure_detected(void) {
+    InitOnceExecuteOnce(&g_detect_once, detect_once_cb, NULL, NULL);
+}
+#else
+static pthread_once_t g_detect_once = PTHREAD_ONCE_INIT;
+static void ensure_detected(void) {
+    pthread_once(&g_detect_once, detect_simd_level);
+}
+#endif
+
+OverlayEffectKernel overlay_get_effect_kernel(void) {
+    ensure_detected();
+    return g_kernel;
+}
+
+OverlaySimdLevel overlay_simd_detect(void) {
+    ensure_detected();
+    return g_detected;
+}
+
+OverlaySimdLevel overlay_get_simd_level(void) {
+    ensure_detected();
+    return g_level;
+}
+
+int overlay_set_simd_level(OverlaySimdLevel level) {
+    ensure_detected();
+    if (level != OVERLAY_SIMD_SCALAR) {
+#ifdef OVERLAY_ARCH_X86
+        if (level == OVERLAY_SIMD_NEON || level > g_detected) return 0;
+#elif defined(OVERLAY_ARCH_NEON)
+        if (level != OVERLAY_SIMD_NEON) return 0;
+#else
+        return 0;
+#endif
+    }
+    g_level = level;
+    g_kernel = kernel_for_level(level);
+    return 1;
+}
@@ -0,0 +1,73 @@
+#ifndef OVERLAY_SIMD_H
+#define OVERLAY_SIMD_H
+
+/* Internal pixel kernels used by overlay.c. Not part of the public API;
+   use overlay.h (apply_effects, overlay_set_simd_level) from app code. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "overlay.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define OVERLAY_ARCH_X86 1
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+    #define OVERLAY_ARCH_NEON 1
+    #include <arm_neon.h>
+#endif
+
+/* GCC/Clang need per-function target attributes to emit SSE2/AVX2 code
+   without raising the baseline ISA of the whole library. MSVC does not. */
+#if defined(__GNUC__) || defined(__clang__)
+    #define OVERLAY_TARGET(x) __attribute__((target(x)))
+#else
+    #define OVERLAY_TARGET(x)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Opacity/invert compiled once per call. alpha_lut[a] is exactly what the
+   original float expression (unsigned char)(a * opacity) produced; when a
+   16-bit multiplier reproduces the whole table (the usual case) the SIMD
+   kernels use (a * alpha_mul) >> 16 instead of a table lookup. */
+typedef struct {
+    unsigned char alpha_lut[256];
+    uint16_t alpha_mul;
+    int alpha_mul_exact;   /* alpha_mul reproduces alpha_lut for all 256 inputs */
+    int alpha_identity;    /* alpha_lut[a] == a, alpha can be left untouched */
+    int invert;
+    int premultiply;       /* write color * alpha / 255, rounded to nearest */
+    int swap_rb;           /* write B G R A instead of R G B A */
+} OverlayEffectParams;
+
+/* Initialises with straight RGBA output; set_format selects another layout */
+void overlay_effect_params_init(OverlayEffectParams *params, float opacity, int invert);
+void overlay_effect_params_set_format(OverlayEffectParams *params, OverlayPixelFormat format);
+
+/* Copies at or above this many bytes bypass the cache with non-temporal
+   stores: the destination is not read again before it is presented. */
+#define OVERLAY_STREAM_MIN_BYTES ((size_t)4 * 1024 * 1024)
+
+/* Read `count` RGBA pixels from src once, invert RGB and remap alpha, and
+   write them to dst once. src == dst runs in place; otherwise the buffers
+   must not overlap. */
+typedef void (*OverlayEffectKernel)(const unsigned char *src, unsigned char *dst,
+                                    size_t count, const OverlayEffectParams *params);
+
+/* Scalar reference kernel; every SIMD variant must match it bit for bit */
+void overlay_effects_scalar(const unsigned char *src, unsigned char *dst,
+                            size_t count, const OverlayEffectParams *params);
+
+/* Kernel for the active SIMD level (detected once, see overlay_get_simd_level) */
+OverlayEffectKernel overlay_get_effect_kernel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLAY_SIMD_H */
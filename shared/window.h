@@ -25,6 +25,13 @@ void set_overlay_opacity(OverlayWindow* window, float opacity);
 void set_overlay_click_through(OverlayWindow* window, int enabled);
 void set_overlay_always_on_top(OverlayWindow* window, int enabled);
 
+/* Presenter capabilities, see get_overlay_window_caps */
+#define OVERLAY_WINDOW_CAP_GLOBAL_ALPHA 0x1 /* set_overlay_opacity is applied by the
+                                               compositor, so the pixel pipeline can
+                                               leave alpha alone and opacity changes
+                                               never touch pixels */
+int get_overlay_window_caps(OverlayWindow* window);
+
 /* Window content */
 void update_overlay_content(OverlayWindow* window, const unsigned char* rgba_data,
                            int width, int height);
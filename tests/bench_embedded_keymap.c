@@ -0,0 +1,67 @@
+/* Startup cost of the embedded default keymap in both build modes: decoding
+   the embedded PNG (default) vs. handing off RGBA decoded at build time
+   (EMBED_KEYMAP_RGBA). Both headers are compiled in here so one run compares
+   them on the same machine. Not part of the test suite. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "overlay.h"
+#include "keymap_embedded.h"
+#include "keymap_rgba_embedded.h"
+
+#define ITERATIONS 20
+
+/* Unlike assert, stays active in release builds, which is what gets timed */
+#define CHECK(cond) do { if (!(cond)) { \
+        fprintf(stderr, "bench_embedded_keymap: %s failed\n", #cond); exit(1); } } while (0)
+
+static double now_ms(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/* Source plus the first full-size overlay, as the app builds it on startup */
+static double run(int predecoded, int with_overlay) {
+    double best = 1e30;
+    for (int i = 0; i < ITERATIONS; i++) {
+        OverlaySource src;
+        Overlay ov;
+        double t0 = now_ms();
+        if (predecoded) {
+            CHECK(overlay_source_wrap(embedded_keymap_rgba, embedded_keymap_rgba_width,
+                                       embedded_keymap_rgba_height, &src) == OVERLAY_OK);
+        } else {
+            CHECK(overlay_source_load_mem(embedded_keymap_data, (int)embedded_keymap_size,
+                                           &src) == OVERLAY_OK);
+        }
+        if (with_overlay) {
+            CHECK(overlay_from_source(&src, src.width, src.height, &ov) == OVERLAY_OK);
+        }
+        double t = now_ms() - t0;
+        if (t < best) best = t;
+        if (with_overlay) free_overlay(&ov);
+        overlay_source_free(&src);
+    }
+    return best;
+}
+
+int main(void) {
+    /* Both modes must produce the same pixels */
+    OverlaySource png, rgba;
+    CHECK(overlay_source_load_mem(embedded_keymap_data, (int)embedded_keymap_size, &png) == OVERLAY_OK);
+    CHECK(overlay_source_wrap(embedded_keymap_rgba, embedded_keymap_rgba_width,
+                               embedded_keymap_rgba_height, &rgba) == OVERLAY_OK);
+    CHECK(png.width == rgba.width && png.height == rgba.height);
+    CHECK(memcmp(png.pixels, rgba.pixels, (size_t)png.width * png.height * 4) == 0);
+    overlay_source_free(&png);
+    overlay_source_free(&rgba);
+
+    printf("embedded keymap %dx%d, PNG %u bytes, RGBA %u bytes (best of %d)\n",
+           embedded_keymap_rgba_width, embedded_keymap_rgba_height,
+           (unsigned)embedded_keymap_size, (unsigned)sizeof(embedded_keymap_rgba), ITERATIONS);
+    printf("  source          PNG decode %8.3f ms   RGBA handoff %8.3f ms\n", run(0, 0), run(1, 0));
+    printf("  source+overlay  PNG decode %8.3f ms   RGBA handoff %8.3f ms\n", run(0, 1), run(1, 1));
+    return 0;
+}
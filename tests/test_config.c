@@ -19,6 +19,9 @@ int main(void) {
         c.position_mode = 1;
         c.click_through = 1;
         c.monitor_index = 1;
+        c.resize_filter = 4;
+        c.lazy_load = 0;
+        c.memory_lean = 1;
         const char *hk = "Command+Option+K";
         strncpy(c.hotkey, hk, sizeof(c.hotkey)-1);
         c.hotkey[sizeof(c.hotkey)-1] = '\0';
@@ -36,9 +39,9 @@ int main(void) {
             return 3;
         }
 
-        if (!float_eq(out.auto_hide, 2.0f) || out.position_mode != 1 || out.click_through != 1 || out.monitor_index != 1 || strcmp(out.hotkey, hk) != 0) {
-            fprintf(stderr, "Test1: mismatch after load: auto_hide=%.3f pos=%d click=%d monitor=%d hotkey=%s\n",
-                    out.auto_hide, out.position_mode, out.click_through, out.monitor_index, out.hotkey);
+        if (!float_eq(out.auto_hide, 2.0f) || out.position_mode != 1 || out.click_through != 1 || out.monitor_index != 1 || out.resize_filter != 4 || out.lazy_load != 0 || out.memory_lean != 1 || strcmp(out.hotkey, hk) != 0) {
+            fprintf(stderr, "Test1: mismatch after load: auto_hide=%.3f pos=%d click=%d monitor=%d filter=%d lazy=%d lean=%d hotkey=%s\n",
+                    out.auto_hide, out.position_mode, out.click_through, out.monitor_index, out.resize_filter, out.lazy_load, out.memory_lean, out.hotkey);
             unlink(path);
             return 4;
         }
@@ -0,0 +1,28 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+/* LICENSE run through embed_asset at build time (see CMakeLists.txt) */
+#include "embedded_license.h"
+
+int main(void) {
+    FILE *f = fopen(LICENSE_PATH, "rb");
+    assert(f != NULL);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    assert(size > 0);
+    unsigned char *bytes = (unsigned char *)malloc((size_t)size);
+    assert(bytes != NULL);
+    size_t got = fread(bytes, 1, (size_t)size, f);
+    assert(got == (size_t)size);
+    fclose(f);
+
+    /* Byte-exact, including a partial last line */
+    assert(embedded_license_size == (unsigned int)size);
+    assert(memcmp(embedded_license_data, bytes, (size_t)size) == 0);
+    free(bytes);
+
+    printf("test_embed_asset: OK\n");
+    return 0;
+}
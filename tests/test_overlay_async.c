@@ -0,0 +1,236 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "overlay.h"
+#include "test_util.h"
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define W 300
+#define H 200
+
+/* Dispatcher that queues callbacks for the main thread to run */
+#define QUEUE_MAX 8
+static struct {
+    void (*fn)(void *);
+    void *arg;
+} g_queue[QUEUE_MAX];
+static int g_queued = 0;
+static overlay_mutex_t g_queue_lock;
+static int g_pumping = 0;
+
+static void queue_dispatch(void (*fn)(void *arg), void *arg, void *ctx) {
+    assert(ctx == &g_queue_lock);
+    overlay_mutex_lock(&g_queue_lock);
+    assert(g_queued < QUEUE_MAX);
+    g_queue[g_queued].fn = fn;
+    g_queue[g_queued].arg = arg;
+    g_queued++;
+    overlay_mutex_unlock(&g_queue_lock);
+}
+
+static int pump(void) {
+    overlay_mutex_lock(&g_queue_lock);
+    int n = g_queued;
+    overlay_mutex_unlock(&g_queue_lock);
+    g_pumping = 1;
+    for (int i = 0; i < n; i++) g_queue[i].fn(g_queue[i].arg);
+    g_pumping = 0;
+    overlay_mutex_lock(&g_queue_lock);
+    memmove(g_queue, g_queue + n, (size_t)(g_queued - n) * sizeof(g_queue[0]));
+    g_queued -= n;
+    overlay_mutex_unlock(&g_queue_lock);
+    return n;
+}
+
+typedef struct {
+    int calls;
+    int on_main;
+    OverlayError result;
+    Overlay overlay;
+} Completion;
+
+static void on_complete(OverlayLoad *load, OverlayError result, void *user) {
+    Completion *c = (Completion *)user;
+    /* The handle is finished by now: taking the result never blocks */
+    int done = overlay_load_poll(load);
+    assert(done);
+    Overlay overlay;
+    memset(&overlay, 0, sizeof(overlay));
+    if (result == OVERLAY_OK) {
+        OverlayError err = overlay_load_result(load, &overlay);
+        assert(err == OVERLAY_OK);
+    }
+    overlay_mutex_lock(&g_queue_lock);
+    c->calls++;
+    c->on_main = g_pumping;
+    c->result = result;
+    c->overlay = overlay;
+    overlay_mutex_unlock(&g_queue_lock);
+}
+
+static int completed(Completion *c) {
+    overlay_mutex_lock(&g_queue_lock);
+    int calls = c->calls;
+    overlay_mutex_unlock(&g_queue_lock);
+    return calls;
+}
+
+int main(void) {
+    unsigned char *rgba = (unsigned char *)malloc((size_t)W * H * 4);
+    if (!rgba) {
+        fprintf(stderr, "malloc failed\n");
+        return 2;
+    }
+    test_fill_pattern(rgba, (size_t)W * H * 4, 777u);
+    TestBuf png = test_encode_png(rgba, W, H);
+    overlay_mutex_init(&g_queue_lock);
+
+    Overlay ref;
+    OverlayError err = load_overlay_mem(png.data, (int)png.len, 120, 120, &ref);
+    assert(err == OVERLAY_OK);
+
+    OverlayLoad *none = load_overlay_async(NULL, 10, 10, NULL);
+    assert(none == NULL);
+    none = load_overlay_mem_async(NULL, 0, 10, 10, NULL);
+    assert(none == NULL);
+
+    /* No callbacks: poll, wait and take the same pixels as the blocking call */
+    {
+        OverlayLoad *load = load_overlay_mem_async(png.data, (int)png.len, 120, 120, NULL);
+        assert(load != NULL);
+        int done = overlay_load_wait(load, -1);
+        assert(done == 1);
+        done = overlay_load_poll(load);
+        assert(done == 1);
+        done = overlay_load_wait(load, 0);
+        assert(done == 1);
+        Overlay out;
+        err = overlay_load_result(load, &out);
+        assert(err == OVERLAY_OK);
+        assert(test_same_pixels(&out, &ref));
+        /* The overlay moved out: a second take gets nothing */
+        Overlay again;
+        err = overlay_load_result(load, &again);
+        assert(err == OVERLAY_ERROR_NULL_PARAM);
+        overlay_load_free(load);
+        free_overlay(&out);
+    }
+
+    /* Dispatched: the callback runs on the pumping thread, once, even after
+       the caller has already let go of the handle */
+    {
+        Completion c;
+        memset(&c, 0, sizeof(c));
+        OverlayLoadCallbacks cb = {on_complete, &c, queue_dispatch, &g_queue_lock};
+        OverlayLoad *load = load_overlay_mem_async(png.data, (int)png.len, 120, 120, &cb);
+        assert(load != NULL);
+        int done = overlay_load_wait(load, -1);
+        assert(done == 1);
+        overlay_load_free(load);
+        assert(c.calls == 0);
+        /* Finished comes before the dispatch: spin until it arrives */
+        while (pump() == 0) {
+        }
+        assert(c.calls == 1 && c.on_main && c.result == OVERLAY_OK);
+        assert(test_same_pixels(&c.overlay, &ref));
+        int pumped = pump();
+        assert(pumped == 0);
+        free_overlay(&c.overlay);
+    }
+
+    /* Without a dispatcher the loader thread calls back itself */
+    {
+        Completion c;
+        memset(&c, 0, sizeof(c));
+        OverlayLoadCallbacks cb = {on_complete, &c, NULL, NULL};
+        OverlayLoad *load = load_overlay_mem_async(png.data, (int)png.len, 120, 120, &cb);
+        assert(load != NULL);
+        /* Freed while possibly still running: cancels, never leaks */
+        overlay_load_free(load);
+        while (!completed(&c)) {
+        }
+        assert(c.calls == 1 && !c.on_main);
+        assert(c.result == OVERLAY_OK || c.result == OVERLAY_ERROR_CANCELLED);
+        if (c.result == OVERLAY_OK) free_overlay(&c.overlay);
+    }
+
+    /* Errors are delivered like results */
+    {
+        Completion c;
+        memset(&c, 0, sizeof(c));
+        OverlayLoadCallbacks cb = {on_complete, &c, queue_dispatch, &g_queue_lock};
+        OverlayLoad *load = load_overlay_async("does/not/exist.png", 10, 10, &cb);
+        assert(load != NULL);
+        Overlay out;
+        err = overlay_load_result(load, &out);
+        assert(err == OVERLAY_ERROR_FILE_NOT_FOUND);
+        overlay_load_free(load);
+        while (pump() == 0) {
+        }
+        assert(c.calls == 1 && c.result == OVERLAY_ERROR_FILE_NOT_FOUND);
+    }
+
+    /* Cancelled right after the start: the loader stops between rows */
+    {
+        int cancelled = 0;
+        for (int i = 0; i < 20; i++) {
+            OverlayLoad *load = load_overlay_mem_async(png.data, (int)png.len, 120, 120, NULL);
+            assert(load != NULL);
+            overlay_load_cancel(load);
+            Overlay out;
+            err = overlay_load_result(load, &out);
+            assert(err == OVERLAY_OK || err == OVERLAY_ERROR_CANCELLED);
+            if (err == OVERLAY_OK) free_overlay(&out);
+            else cancelled++;
+            overlay_load_free(load);
+        }
+        assert(cancelled > 0);
+    }
+
+#ifndef _WIN32
+    /* Timeouts and cancelling mid-load: opening a FIFO holds the loader
+       until the test opens the other end */
+    {
+        char fifo[] = "/tmp/klo_async_fifoXXXXXX";
+        int fd = mkstemp(fifo);
+        assert(fd >= 0);
+        close(fd);
+        unlink(fifo);
+        int rc = mkfifo(fifo, 0600);
+        assert(rc == 0);
+
+        OverlayLoad *load = load_overlay_async(fifo, 120, 120, NULL);
+        assert(load != NULL);
+        int done = overlay_load_wait(load, 0);
+        assert(done == 0);
+        done = overlay_load_wait(load, 50);
+        assert(done == 0);
+        done = overlay_load_poll(load);
+        assert(done == 0);
+        overlay_load_cancel(load);
+
+        /* Nothing to read; the loader then sees the cancel instead of
+           falling back to stb_image */
+        FILE *f = fopen(fifo, "wb");
+        assert(f != NULL);
+        fclose(f);
+
+        Overlay out;
+        err = overlay_load_result(load, &out);
+        assert(err == OVERLAY_ERROR_CANCELLED);
+        overlay_load_free(load);
+        unlink(fifo);
+    }
+#endif
+
+    overlay_mutex_destroy(&g_queue_lock);
+    free_overlay(&ref);
+    free(png.data);
+    free(rgba);
+    printf("test_overlay_async: OK\n");
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "overlay.h"
+
+static const unsigned char png_1x1[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A,
+    0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01,
+    0x08, 0x04, 0x00, 0x00, 0x00, 0xB5, 0x1C, 0x0C,
+    0x02, 0x00, 0x00, 0x00, 0x0B, 0x49, 0x44, 0x41,
+    0x54, 0x78, 0xDA, 0x63, 0xFC, 0xFF, 0x1F, 0x00,
+    0x03, 0x03, 0x01, 0xFE, 0x08, 0x79, 0x80, 0xED,
+    0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44,
+    0xAE, 0x42, 0x60, 0x82
+};
+
+/* data must be exactly one effect pass over base, whatever ran before */
+static void check_derived(const Overlay *img, float opacity, int invert) {
+    size_t sz = (size_t)img->width * img->height * 4;
+    for (size_t i = 0; i < sz; i += 4) {
+        for (int c = 0; c < 3; c++) {
+            unsigned char expect = invert ? (unsigned char)(255 - img->base[i + c])
+                                          : img->base[i + c];
+            assert(img->data[i + c] == expect);
+        }
+        assert(img->data[i + 3] == (unsigned char)(img->base[i + 3] * opacity));
+    }
+}
+
+int main(void) {
+    Overlay img;
+    OverlayError err = load_overlay_mem(png_1x1, sizeof(png_1x1), 3, 3, &img);
+    assert(err == OVERLAY_OK);
+    assert(img.base != NULL);
+    assert(img.data == img.base);
+
+    size_t sz = (size_t)img.width * img.height * 4;
+    unsigned char pristine[3 * 3 * 4];
+    assert(sz == sizeof(pristine));
+    memcpy(pristine, img.base, sz);
+
+    /* Effects go to a derived buffer; base is left alone */
+    apply_effects(&img, 0.5f, 1);
+    assert(img.data != img.base);
+    assert(memcmp(img.base, pristine, sz) == 0);
+    check_derived(&img, 0.5f, 1);
+
+    /* A second change starts from base again instead of stacking */
+    unsigned char *derived = img.data;
+    apply_effects(&img, 0.25f, 0);
+    assert(img.data == derived); /* derived buffer is reused */
+    check_derived(&img, 0.25f, 0);
+
+    /* Identity effects give back the original pixels without a copy */
+    apply_effects(&img, 1.0f, 0);
+    assert(img.data == img.base);
+
+    /* Editing base is picked up after overlay_base_changed, even with
+       unchanged parameters */
+    apply_effects(&img, 0.5f, 0);
+    img.base[0] = (unsigned char)(img.base[0] ^ 0xFF);
+    img.base[3] = 200;
+    apply_effects(&img, 0.5f, 0);
+    assert(img.data[3] != 100); /* stale: same params, base not marked */
+    overlay_base_changed(&img);
+    apply_effects(&img, 0.5f, 0);
+    check_derived(&img, 0.5f, 0);
+    assert(img.data[3] == 100);
+
+    /* The cache derives from base too, not from the already-faded data */
+    OverlayCache cache;
+    int cached = init_overlay_cache(&cache, &img);
+    assert(cached == OVERLAY_OK);
+    const Overlay *v = get_cached_variation(&cache, 0.5f, 1);
+    assert(v != NULL);
+    assert(v->data[3] == 100);
+    assert(v->data[0] == (unsigned char)(255 - img.base[0]));
+    free_overlay_cache(&cache);
+
+    free_overlay(&img);
+    assert(img.data == NULL && img.base == NULL);
+
+    printf("test_overlay_base: OK\n");
+    return 0;
+}
@@ -0,0 +1,231 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "overlay.h"
+#include "overlay_bundle.h"
+#include "overlay_qoi.h"
+
+#define VARIANTS 3
+#define FILE_PATH "overlay_bundle_test.bundle"
+
+/* Blue tells the variants apart after resizing */
+static unsigned char *make_variant(int w, int h, int id) {
+    unsigned char *rgba = (unsigned char *)malloc((size_t)w * h * 4);
+    assert(rgba != NULL);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            unsigned char *p = rgba + ((size_t)y * w + x) * 4;
+            p[0] = (unsigned char)(x * 255 / w);
+            p[1] = (unsigned char)(y * 255 / h);
+            p[2] = (unsigned char)(id * 80);
+            p[3] = 255;
+        }
+    }
+    return rgba;
+}
+
+/* Loads at the bounds and checks the size and which variant it came from */
+static void expect_load(const unsigned char *bundle, size_t len, int max_w, int max_h,
+                        int width, int height, int id) {
+    Overlay img;
+    OverlayError err = load_overlay_mem(bundle, (int)len, max_w, max_h, &img);
+    assert(err == OVERLAY_OK);
+    assert(img.width == width && img.height == height);
+    const unsigned char *p = img.data + ((size_t)(height / 2) * width + width / 2) * 4;
+    assert(abs(p[2] - id * 80) <= 2);
+    free_overlay(&img);
+}
+
+int main(void) {
+    static const int sizes[VARIANTS][2] = {{200, 100}, {400, 200}, {800, 400}};
+    unsigned char *pixels[VARIANTS];
+    OverlayBundleVariant variants[VARIANTS];
+    for (int i = 0; i < VARIANTS; i++) {
+        pixels[i] = make_variant(sizes[i][0], sizes[i][1], i);
+        variants[i].width = sizes[i][0];
+        variants[i].height = sizes[i][1];
+        variants[i].data = overlay_qoi_encode(pixels[i], sizes[i][0], sizes[i][1], &variants[i].size);
+        assert(variants[i].data != NULL);
+    }
+
+    size_t len;
+    unsigned char *bundle = overlay_bundle_write(variants, VARIANTS, &len);
+    assert(bundle != NULL);
+    OverlayError err;
+    assert(overlay_bundle_detect(bundle, len));
+    assert(!overlay_bundle_detect(variants[0].data, variants[0].size));
+    assert(overlay_bundle_count(bundle, len) == VARIANTS);
+    for (int i = 0; i < VARIANTS; i++) {
+        OverlayBundleVariant v;
+        err = overlay_bundle_variant(bundle, len, i, &v);
+        assert(err == OVERLAY_OK);
+        assert(v.width == sizes[i][0] && v.height == sizes[i][1]);
+        assert(v.size == variants[i].size && memcmp(v.data, variants[i].data, v.size) == 0);
+    }
+    {
+        OverlayBundleVariant v;
+        err = overlay_bundle_variant(bundle, len, VARIANTS, &v);
+        assert(err == OVERLAY_ERROR_DECODE_FAILED);
+        err = overlay_bundle_variant(bundle, len, -1, &v);
+        assert(err == OVERLAY_ERROR_DECODE_FAILED);
+    }
+
+    /* Selection: exact, smallest downscale, smallest upscale, and a slight
+       upscale over decoding 4x the pixels for a 2x downscale */
+    assert(overlay_bundle_select(bundle, len, 400, 400) == 1);
+    assert(overlay_bundle_select(bundle, len, 800, 300) == 2);
+    assert(overlay_bundle_select(bundle, len, 350, 350) == 1);
+    assert(overlay_bundle_select(bundle, len, 100, 100) == 0);
+    assert(overlay_bundle_select(bundle, len, 2000, 2000) == 2);
+    assert(overlay_bundle_select(bundle, len, 410, 205) == 1);
+    assert(overlay_bundle_select(bundle, len, 700, 350) == 2);
+
+    /* An exact match comes back untouched */
+    for (int i = 0; i < VARIANTS; i++) {
+        Overlay img;
+        err = load_overlay_mem(bundle, (int)len, sizes[i][0], sizes[i][0], &img);
+        assert(err == OVERLAY_OK);
+        assert(img.width == sizes[i][0] && img.height == sizes[i][1]);
+        assert(memcmp(img.data, pixels[i], (size_t)sizes[i][0] * sizes[i][1] * 4) == 0);
+        free_overlay(&img);
+    }
+    /* Otherwise the nearest variant is resized the rest of the way */
+    expect_load(bundle, len, 800, 300, 600, 300, 2);
+    expect_load(bundle, len, 350, 350, 350, 175, 1);
+    expect_load(bundle, len, 100, 100, 100, 50, 0);
+    expect_load(bundle, len, 2000, 2000, 2000, 1000, 2);
+    expect_load(bundle, len, 410, 205, 410, 205, 1);
+
+    /* The same from a file */
+    {
+        FILE *f = fopen(FILE_PATH, "wb");
+        assert(f != NULL);
+        size_t written = fwrite(bundle, 1, len, f);
+        assert(written == len);
+        fclose(f);
+        Overlay from_file, from_mem;
+        err = load_overlay(FILE_PATH, 350, 350, &from_file);
+        assert(err == OVERLAY_OK);
+        err = load_overlay_mem(bundle, (int)len, 350, 350, &from_mem);
+        assert(err == OVERLAY_OK);
+        assert(from_file.width == from_mem.width && from_file.height == from_mem.height);
+        assert(memcmp(from_file.data, from_mem.data,
+                      (size_t)from_file.width * from_file.height * 4) == 0);
+        free_overlay(&from_file);
+        free_overlay(&from_mem);
+        remove(FILE_PATH);
+    }
+
+    /* Damaged bundles */
+    {
+        unsigned char *bad = (unsigned char *)malloc(len);
+        assert(bad != NULL);
+        Overlay img;
+
+        memcpy(bad, bundle, len);
+        bad[4] = 2; /* version */
+        assert(overlay_bundle_count(bad, len) == -1);
+        err = load_overlay_mem(bad, (int)len, 400, 400, &img);
+        assert(err == OVERLAY_ERROR_DECODE_FAILED);
+
+        memcpy(bad, bundle, len);
+        memset(bad + 8, 0, 4); /* no variants */
+        assert(overlay_bundle_count(bad, len) == -1);
+
+        memcpy(bad, bundle, len);
+        bad[16 + 24 + 15] = 0x01; /* second variant's offset past the end */
+        assert(overlay_bundle_count(bad, len) == -1);
+        assert(overlay_bundle_select(bad, len, 400, 400) == -1);
+
+        /* Table cut short, and a variant cut short */
+        assert(overlay_bundle_count(bundle, 40) == -1);
+        assert(overlay_bundle_count(bundle, len - 1) == -1);
+
+        /* A variant that does not decode */
+        memcpy(bad, bundle, len);
+        memset(bad + len - variants[2].size, 0, 4);
+        err = load_overlay_mem(bad, (int)len, 800, 800, &img);
+        assert(err == OVERLAY_ERROR_DECODE_FAILED);
+        free(bad);
+
+        /* Bundles do not nest */
+        OverlayBundleVariant nested = {1, 1, bundle, len};
+        size_t nested_len;
+        unsigned char *outer = overlay_bundle_write(&nested, 1, &nested_len);
+        assert(outer != NULL);
+        err = load_overlay_mem(outer, (int)nested_len, 1, 1, &img);
+        assert(err == OVERLAY_ERROR_DECODE_FAILED);
+        free(outer);
+
+        unsigned char *rejected = overlay_bundle_write(variants, 0, &nested_len);
+        assert(rejected == NULL);
+        OverlayBundleVariant empty = {10, 10, bundle, 0};
+        rejected = overlay_bundle_write(&empty, 1, &nested_len);
+        assert(rejected == NULL);
+    }
+
+#ifdef KEYMAP_PNG_PATH
+    /* The keymap as PNG next to a half-size QOI: each loads like the image
+       it was made from */
+    {
+        OverlaySource png;
+        err = overlay_source_load(KEYMAP_PNG_PATH, &png);
+        assert(err == OVERLAY_OK);
+        FILE *f = fopen(KEYMAP_PNG_PATH, "rb");
+        assert(f != NULL);
+        fseek(f, 0, SEEK_END);
+        size_t png_len = (size_t)ftell(f);
+        fseek(f, 0, SEEK_SET);
+        unsigned char *png_bytes = (unsigned char *)malloc(png_len);
+        assert(png_bytes != NULL);
+        size_t got = fread(png_bytes, 1, png_len, f);
+        assert(got == png_len);
+        fclose(f);
+
+        Overlay half;
+        err = overlay_from_source(&png, png.width / 2, png.height / 2, &half);
+        assert(err == OVERLAY_OK);
+        size_t half_len;
+        unsigned char *half_qoi = overlay_qoi_encode(half.data, half.width, half.height, &half_len);
+        assert(half_qoi != NULL);
+
+        OverlayBundleVariant keymap[2] = {
+            {png.width, png.height, png_bytes, png_len},
+            {half.width, half.height, half_qoi, half_len}};
+        size_t keymap_len;
+        unsigned char *keymap_bundle = overlay_bundle_write(keymap, 2, &keymap_len);
+        assert(keymap_bundle != NULL);
+
+        Overlay a, b;
+        err = load_overlay_mem(keymap_bundle, (int)keymap_len, png.width, png.height, &a);
+        assert(err == OVERLAY_OK);
+        err = load_overlay(KEYMAP_PNG_PATH, png.width, png.height, &b);
+        assert(err == OVERLAY_OK);
+        assert(a.width == b.width && a.height == b.height);
+        assert(memcmp(a.data, b.data, (size_t)a.width * a.height * 4) == 0);
+        free_overlay(&a);
+        free_overlay(&b);
+
+        err = load_overlay_mem(keymap_bundle, (int)keymap_len, half.width, half.height, &a);
+        assert(err == OVERLAY_OK);
+        assert(a.width == half.width && a.height == half.height);
+        assert(memcmp(a.data, half.data, (size_t)a.width * a.height * 4) == 0);
+        free_overlay(&a);
+
+        free(keymap_bundle);
+        free(half_qoi);
+        free_overlay(&half);
+        free(png_bytes);
+        overlay_source_free(&png);
+    }
+#endif
+
+    for (int i = 0; i < VARIANTS; i++) {
+        free((void *)variants[i].data);
+        free(pixels[i]);
+    }
+    free(bundle);
+    printf("test_overlay_bundle: OK\n");
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "overlay.h"
+#include "overlay_bytes.h"
+
+#define FILE_PATH "overlay_bytes_test.bin"
+#define EMPTY_PATH "overlay_bytes_test_empty.bin"
+
+static void write_file(const char *path, const unsigned char *data, size_t len) {
+    FILE *f = fopen(path, "wb");
+    assert(f != NULL);
+    size_t written = len ? fwrite(data, 1, len, f) : 0;
+    assert(written == len);
+    fclose(f);
+}
+
+int main(void) {
+    unsigned char content[5000];
+    for (size_t i = 0; i < sizeof(content); i++) content[i] = (unsigned char)(i * 7 + 3);
+    write_file(FILE_PATH, content, sizeof(content));
+    write_file(EMPTY_PATH, NULL, 0);
+
+    /* Mapped files read back byte for byte */
+    OverlayBytes b;
+    OverlayError err = overlay_bytes_map(FILE_PATH, &b);
+    assert(err == OVERLAY_OK);
+    assert(b.kind == OVERLAY_BYTES_MAPPED);
+    assert(b.size == sizeof(content));
+    assert(memcmp(b.data, content, sizeof(content)) == 0);
+    overlay_bytes_release(&b);
+    assert(b.kind == OVERLAY_BYTES_NONE && b.data == NULL && b.size == 0);
+    overlay_bytes_release(&b); /* harmless twice */
+
+    err = overlay_bytes_map("overlay_bytes_missing.bin", &b);
+    assert(err == OVERLAY_ERROR_FILE_NOT_FOUND);
+    assert(b.data == NULL);
+    err = overlay_bytes_map(EMPTY_PATH, &b);
+    assert(err == OVERLAY_ERROR_IO);
+    assert(b.data == NULL);
+    err = overlay_bytes_map(NULL, &b);
+    assert(err == OVERLAY_ERROR_NULL_PARAM);
+
+    /* The embedded keymap is borrowed, never copied */
+    int png_size = 0, rgba_w = 0, rgba_h = 0;
+    const unsigned char *png = get_default_keymap(&png_size);
+    const unsigned char *rgba = get_default_keymap_rgba(&rgba_w, &rgba_h);
+    OverlayError embedded = overlay_bytes_embedded(&b);
+    if (png) {
+        assert(embedded == OVERLAY_OK && b.kind == OVERLAY_BYTES_EMBEDDED);
+        assert(b.data == png && b.size == (size_t)png_size);
+    } else if (rgba) {
+        assert(embedded == OVERLAY_OK && b.kind == OVERLAY_BYTES_EMBEDDED_RGBA);
+        assert(b.data == rgba && b.width == rgba_w && b.height == rgba_h);
+        assert(b.size == (size_t)rgba_w * rgba_h * 4);
+    } else {
+        assert(embedded == OVERLAY_ERROR_FILE_NOT_FOUND && b.data == NULL);
+    }
+    overlay_bytes_release(&b);
+
+    /* Search order: first path that maps, then the embedded keymap */
+    const char *paths[] = {"overlay_bytes_missing.bin", EMPTY_PATH, FILE_PATH, NULL};
+    err = overlay_bytes_open(paths, &b);
+    assert(err == OVERLAY_OK);
+    assert(b.kind == OVERLAY_BYTES_MAPPED && b.size == sizeof(content));
+    overlay_bytes_release(&b);
+
+    const char *none[] = {"overlay_bytes_missing.bin", NULL};
+    err = overlay_bytes_open(none, &b);
+    assert(err == embedded);
+    assert(b.kind == (png ? OVERLAY_BYTES_EMBEDDED
+                          : rgba ? OVERLAY_BYTES_EMBEDDED_RGBA : OVERLAY_BYTES_NONE));
+    overlay_bytes_release(&b);
+
+    remove(FILE_PATH);
+    remove(EMPTY_PATH);
+
+#ifdef KEYMAP_PNG_PATH
+    /* load_overlay decodes from the mapping: same pixels as from memory */
+    {
+        err = overlay_bytes_map(KEYMAP_PNG_PATH, &b);
+        assert(err == OVERLAY_OK);
+        Overlay from_file, from_mem;
+        err = load_overlay(KEYMAP_PNG_PATH, 300, 300, &from_file);
+        assert(err == OVERLAY_OK);
+        err = load_overlay_mem(b.data, (int)b.size, 300, 300, &from_mem);
+        assert(err == OVERLAY_OK);
+        assert(from_file.width == from_mem.width && from_file.height == from_mem.height);
+        assert(memcmp(from_file.data, from_mem.data,
+                      (size_t)from_file.width * from_file.height * 4) == 0);
+        free_overlay(&from_file);
+        free_overlay(&from_mem);
+        overlay_bytes_release(&b);
+    }
+#endif
+
+    printf("test_overlay_bytes: OK\n");
+    return 0;
+}
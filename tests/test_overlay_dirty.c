@@ -0,0 +1,128 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "overlay.h"
+
+static const unsigned char png_1x1[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A,
+    0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01,
+    0x08, 0x04, 0x00, 0x00, 0x00, 0xB5, 0x1C, 0x0C,
+    0x02, 0x00, 0x00, 0x00, 0x0B, 0x49, 0x44, 0x41,
+    0x54, 0x78, 0xDA, 0x63, 0xFC, 0xFF, 0x1F, 0x00,
+    0x03, 0x03, 0x01, 0xFE, 0x08, 0x79, 0x80, 0xED,
+    0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44,
+    0xAE, 0x42, 0x60, 0x82
+};
+
+static int in_rect(int x, int y, int rx, int ry, int rw, int rh) {
+    return x >= rx && x < rx + rw && y >= ry && y < ry + rh;
+}
+
+int main(void) {
+    Overlay img;
+    OverlayError err = load_overlay_mem(png_1x1, sizeof(png_1x1), 30, 30, &img);
+    assert(err == OVERLAY_OK);
+    int w = img.width, h = img.height;
+    size_t sz = (size_t)w * h * 4;
+
+    /* A fresh load is dirty everywhere for presenters */
+    assert(img.dirty_count == 1);
+    assert(img.dirty[0].width == w && img.dirty[0].height == h);
+    overlay_clear_dirty(&img);
+
+    /* A full effect pass marks the whole image */
+    apply_effects(&img, 0.5f, 1);
+    assert(img.dirty_count == 1 && img.dirty[0].width == w);
+    overlay_clear_dirty(&img);
+
+    /* Poison data, edit a patch of base: only that patch is re-derived */
+    memset(img.data, 0xAB, sz);
+    const int rx = 3, ry = 5, rw = 7, rh = 4;
+    for (int y = ry; y < ry + rh; y++) {
+        for (int x = rx; x < rx + rw; x++) {
+            unsigned char *p = img.base + ((size_t)y * w + x) * 4;
+            p[0] = 10; p[1] = 20; p[2] = 30; p[3] = 200;
+        }
+    }
+    overlay_mark_dirty(&img, rx, ry, rw, rh);
+    assert(img.dirty_count == 1);
+    apply_effects(&img, 0.5f, 1);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            const unsigned char *p = img.data + ((size_t)y * w + x) * 4;
+            if (in_rect(x, y, rx, ry, rw, rh)) {
+                assert(p[0] == 245 && p[1] == 235 && p[2] == 225 && p[3] == 100);
+            } else {
+                assert(p[0] == 0xAB && p[3] == 0xAB);
+            }
+        }
+    }
+    /* The presenter still sees the rect until it clears it */
+    assert(img.dirty_count == 1 && img.dirty[0].x == rx && img.dirty[0].y == ry);
+
+    /* Format conversion of a rect leaves the rest of dst alone */
+    unsigned char *dst = (unsigned char *)malloc(sz);
+    assert(dst != NULL);
+    memset(dst, 0x11, sz);
+    int ok = apply_effects_format_rect(&img, dst, 1.0f, 0, OVERLAY_FORMAT_BGRA_PREMUL,
+                                       &img.dirty[0]);
+    assert(ok == 1);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            const unsigned char *p = dst + ((size_t)y * w + x) * 4;
+            if (in_rect(x, y, rx, ry, rw, rh)) {
+                /* BGRA premultiplied by alpha 100 */
+                assert(p[0] == (225 * 100 + 127) / 255);
+                assert(p[2] == (245 * 100 + 127) / 255);
+                assert(p[3] == 100);
+            } else {
+                assert(p[0] == 0x11 && p[3] == 0x11);
+            }
+        }
+    }
+    overlay_clear_dirty(&img);
+    assert(img.dirty_count == 0);
+
+    /* A presenter that blits and clears between a base edit and the next
+       apply_effects must not stop that edit from being re-derived */
+    for (int y = ry; y < ry + rh; y++) {
+        for (int x = rx; x < rx + rw; x++) {
+            unsigned char *p = img.base + ((size_t)y * w + x) * 4;
+            p[0] = 50; p[1] = 60; p[2] = 70; p[3] = 100;
+        }
+    }
+    overlay_mark_dirty(&img, rx, ry, rw, rh);
+    overlay_clear_dirty(&img);
+    assert(img.dirty_count == 0 && img.effects_dirty_count == 1);
+    apply_effects(&img, 0.5f, 1);
+    const unsigned char *edited = img.data + ((size_t)ry * w + rx) * 4;
+    assert(edited[0] == 205 && edited[1] == 195 && edited[2] == 185 && edited[3] == 50);
+    /* ...and the re-derived pixels are presented again */
+    assert(img.dirty_count == 1 && img.dirty[0].x == rx && img.dirty[0].width == rw);
+    assert(img.effects_dirty_count == 0);
+    overlay_clear_dirty(&img);
+
+    /* Clipping, containment and collapse into a bounding box */
+    overlay_mark_dirty(&img, -5, -5, 8, 8);
+    assert(img.dirty_count == 1 && img.dirty[0].x == 0 && img.dirty[0].width == 3);
+    overlay_mark_dirty(&img, 1, 1, 1, 1); /* inside the first */
+    assert(img.dirty_count == 1);
+    overlay_mark_dirty(&img, w, h, 4, 4); /* fully outside */
+    assert(img.dirty_count == 1);
+    for (int i = 0; i < OVERLAY_MAX_DIRTY_RECTS; i++) {
+        overlay_mark_dirty(&img, 4 + i * 2, 10, 1, 1);
+    }
+    assert(img.dirty_count == 1);
+    assert(img.dirty[0].x == 0 && img.dirty[0].y == 0);
+    assert(img.dirty[0].width == 4 + (OVERLAY_MAX_DIRTY_RECTS - 1) * 2 + 1);
+    assert(img.dirty[0].height == 11);
+
+    free(dst);
+    free_overlay(&img);
+    assert(img.dirty_count == 0);
+
+    printf("test_overlay_dirty: OK\n");
+    return 0;
+}
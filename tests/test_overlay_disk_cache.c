@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include "overlay.h"
+#include "overlay_disk_cache.h"
+#ifdef _WIN32
+#include <direct.h>
+#include <sys/utime.h>
+#define rmdir _rmdir
+#define utime _utime
+#define utimbuf _utimbuf
+#define SEP "\\"
+#else
+#include <unistd.h>
+#include <utime.h>
+#define SEP "/"
+#endif
+
+/* Relative to the working directory; nested to exercise directory creation */
+#define DIR "overlay_disk_cache_test" SEP "cache"
+
+static const unsigned char png_1x1[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A,
+    0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01,
+    0x08, 0x04, 0x00, 0x00, 0x00, 0xB5, 0x1C, 0x0C,
+    0x02, 0x00, 0x00, 0x00, 0x0B, 0x49, 0x44, 0x41,
+    0x54, 0x78, 0xDA, 0x63, 0xFC, 0xFF, 0x1F, 0x00,
+    0x03, 0x03, 0x01, 0xFE, 0x08, 0x79, 0x80, 0xED,
+    0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44,
+    0xAE, 0x42, 0x60, 0x82
+};
+
+static void entry_file(char *buf, size_t size, uint64_t key) {
+    snprintf(buf, size, DIR SEP "%016llx.ovc", (unsigned long long)key);
+}
+
+static int file_exists(uint64_t key) {
+    char path[256];
+    entry_file(path, sizeof(path), key);
+    FILE *f = fopen(path, "rb");
+    if (f) fclose(f);
+    return f != NULL;
+}
+
+static void set_mtime(uint64_t key, time_t t) {
+    char path[256];
+    struct utimbuf times;
+    entry_file(path, sizeof(path), key);
+    times.actime = t;
+    times.modtime = t;
+    int rc = utime(path, &times);
+    assert(rc == 0);
+}
+
+static void cleanup(void) {
+    overlay_disk_cache_evict(DIR, 0, NULL);
+    rmdir(DIR);
+    rmdir("overlay_disk_cache_test");
+}
+
+int main(void) {
+    cleanup();
+
+    /* Keys change with the source, the size and the filter, not the effects */
+    uint64_t id = overlay_disk_cache_source_id(png_1x1, sizeof(png_1x1));
+    assert(id == overlay_disk_cache_source_id(png_1x1, sizeof(png_1x1)));
+    assert(id != overlay_disk_cache_source_id(png_1x1, sizeof(png_1x1) - 1));
+    uint64_t key = overlay_disk_cache_key(id, 16, 12, OVERLAY_FILTER_AUTO);
+    assert(key == overlay_disk_cache_key(id, 16, 12, OVERLAY_FILTER_AUTO));
+    assert(key != overlay_disk_cache_key(id + 1, 16, 12, OVERLAY_FILTER_AUTO));
+    assert(key != overlay_disk_cache_key(id, 17, 12, OVERLAY_FILTER_AUTO));
+    assert(key != overlay_disk_cache_key(id, 16, 13, OVERLAY_FILTER_AUTO));
+    assert(key != overlay_disk_cache_key(id, 16, 12, OVERLAY_FILTER_BOX));
+
+    Overlay loaded;
+    OverlayError err = overlay_disk_cache_load(DIR, key, &loaded);
+    assert(err == OVERLAY_ERROR_FILE_NOT_FOUND);
+
+    /* The base round-trips; effects already applied are not stored */
+    Overlay img;
+    err = load_overlay_mem(png_1x1, sizeof(png_1x1), 16, 12, &img);
+    assert(err == OVERLAY_OK);
+    for (int i = 0; i < img.width * img.height * 4; i++) img.base[i] = (unsigned char)(i * 7);
+    overlay_base_changed(&img);
+    apply_effects(&img, 0.5f, 1);
+    assert(img.data != img.base);
+    err = overlay_disk_cache_store(DIR, key, &img);
+    assert(err == OVERLAY_OK);
+
+    err = overlay_disk_cache_load(DIR, key, &loaded);
+    assert(err == OVERLAY_OK);
+    size_t bytes = (size_t)img.width * img.height * 4;
+    assert(loaded.width == img.width && loaded.height == img.height && loaded.channels == 4);
+    assert(loaded.data == loaded.base && loaded.cached_effects == 0);
+    assert(memcmp(loaded.base, img.base, bytes) == 0);
+    assert(loaded.dirty_count == 1 && loaded.dirty[0].width == img.width);
+
+    /* Effects derive from the borrowed base as usual */
+    apply_effects(&loaded, 0.5f, 1);
+    assert(loaded.data != loaded.base && memcmp(loaded.data, img.data, bytes) == 0);
+
+    /* The base is a private copy-on-write mapping: edits neither fault nor
+       reach the file */
+    loaded.base[0] ^= 0xFF;
+    overlay_mark_dirty(&loaded, 0, 0, 1, 1);
+    apply_effects(&loaded, 0.5f, 1);
+    assert(loaded.data[3] == img.data[3]);
+    free_overlay(&loaded);
+    assert(loaded.base == NULL && loaded.base_owner == NULL);
+    err = overlay_disk_cache_load(DIR, key, &loaded);
+    assert(err == OVERLAY_OK);
+    assert(memcmp(loaded.base, img.base, bytes) == 0);
+    free_overlay(&loaded);
+
+    /* A truncated or mismatched entry is a miss and gets deleted */
+    uint64_t plain = overlay_disk_cache_key(id, 16, 12, OVERLAY_FILTER_BOX);
+    char path[256];
+    entry_file(path, sizeof(path), plain);
+    FILE *f = fopen(path, "wb");
+    assert(f != NULL);
+    fwrite("KLOC", 1, 4, f);
+    fclose(f);
+    err = overlay_disk_cache_load(DIR, plain, &loaded);
+    assert(err == OVERLAY_ERROR_DECODE_FAILED);
+    assert(!file_exists(plain));
+    char other[256];
+    entry_file(other, sizeof(other), plain);
+    entry_file(path, sizeof(path), key);
+    err = overlay_disk_cache_store(DIR, key, &img);
+    assert(err == OVERLAY_OK);
+    int rc = rename(path, other);
+    assert(rc == 0);
+    err = overlay_disk_cache_load(DIR, plain, &loaded);
+    assert(err == OVERLAY_ERROR_DECODE_FAILED);
+    assert(!file_exists(plain));
+
+    /* Eviction drops the least recently used entries first, and a load
+       counts as a use */
+    uint64_t keys[4];
+    time_t now = time(NULL);
+    for (int i = 0; i < 4; i++) {
+        keys[i] = overlay_disk_cache_key(id, 100 + i, 12, OVERLAY_FILTER_AUTO);
+        err = overlay_disk_cache_store(DIR, keys[i], &img);
+        assert(err == OVERLAY_OK);
+        set_mtime(keys[i], now - 1000 + i * 100);
+    }
+    err = overlay_disk_cache_load(DIR, keys[0], &loaded);
+    assert(err == OVERLAY_OK);
+    free_overlay(&loaded);
+    overlay_disk_cache_evict(DIR, 3 * bytes + 100, NULL); /* room for three entries */
+    assert(file_exists(keys[0]) && !file_exists(keys[1]));
+    assert(file_exists(keys[2]) && file_exists(keys[3]));
+
+    /* The kept entry survives a bound smaller than itself, even when it is
+       the oldest */
+    set_mtime(keys[2], now - 5000);
+    overlay_disk_cache_evict(DIR, 1, &keys[2]);
+    assert(file_exists(keys[2]) && !file_exists(keys[0]) && !file_exists(keys[3]));
+    overlay_disk_cache_evict(DIR, 1, NULL);
+    for (int i = 0; i < 4; i++) assert(!file_exists(keys[i]));
+
+    err = overlay_disk_cache_load(NULL, key, &loaded);
+    assert(err == OVERLAY_ERROR_NULL_PARAM);
+    err = overlay_disk_cache_store(DIR, key, NULL);
+    assert(err == OVERLAY_ERROR_NULL_PARAM);
+
+    free_overlay(&img);
+    cleanup();
+    printf("test_overlay_disk_cache: OK\n");
+    return 0;
+}
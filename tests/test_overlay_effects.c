@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "overlay.h"
+
+#define W 16
+#define H 16
+
+static OverlayEffect effect(OverlayEffectType type, float value) {
+    OverlayEffect e;
+    memset(&e, 0, sizeof(e));
+    e.type = type;
+    e.value = value;
+    e.value2 = 1.0f;
+    return e;
+}
+
+/* Every R, G, B and A value appears: pixel i has channels i, 255-i, i*7, i */
+static void fill_ramp(unsigned char *buf) {
+    for (int i = 0; i < W * H; i++) {
+        buf[i * 4 + 0] = (unsigned char)i;
+        buf[i * 4 + 1] = (unsigned char)(255 - i);
+        buf[i * 4 + 2] = (unsigned char)(i * 7);
+        buf[i * 4 + 3] = (unsigned char)i;
+    }
+}
+
+int main(void) {
+    size_t sz = (size_t)W * H * 4;
+    unsigned char *src = (unsigned char *)malloc(sz);
+    unsigned char *out = (unsigned char *)malloc(sz);
+    unsigned char *ref = (unsigned char *)malloc(sz);
+    if (!src || !out || !ref) {
+        fprintf(stderr, "malloc failed\n");
+        return 2;
+    }
+    fill_ramp(src);
+
+    Overlay img;
+    memset(&img, 0, sizeof(img));
+    img.width = W;
+    img.height = H;
+    img.channels = 4;
+    img.data = src;
+    int ok;
+
+    /* Invert + opacity is the apply_effects fast path, bit for bit */
+    {
+        OverlayEffect chain[2];
+        chain[0] = effect(OVERLAY_EFFECT_INVERT, 0.0f);
+        chain[1] = effect(OVERLAY_EFFECT_OPACITY, 0.7f);
+        ok = apply_effect_chain_copy(&img, out, chain, 2);
+        assert(ok == 1);
+        ok = apply_effects_copy(&img, ref, 0.7f, 1);
+        assert(ok == 1);
+        assert(memcmp(out, ref, sz) == 0);
+    }
+
+    /* The general path gives the same answer for the same effects when an
+       unrelated no-op effect forces it */
+    {
+        OverlayEffect chain[3];
+        chain[0] = effect(OVERLAY_EFFECT_INVERT, 0.0f);
+        chain[1] = effect(OVERLAY_EFFECT_OPACITY, 0.7f);
+        chain[2] = effect(OVERLAY_EFFECT_ALPHA_THRESHOLD, 0.0f);
+        ok = apply_effect_chain_copy(&img, out, chain, 3);
+        assert(ok == 1);
+        assert(memcmp(out, ref, sz) == 0);
+    }
+
+    /* Gamma and its inverse fold to the identity */
+    {
+        OverlayEffect chain[2];
+        chain[0] = effect(OVERLAY_EFFECT_GAMMA, 2.2f);
+        chain[1] = effect(OVERLAY_EFFECT_GAMMA, 1.0f / 2.2f);
+        ok = apply_effect_chain_copy(&img, out, chain, 2);
+        assert(ok == 1);
+        assert(memcmp(out, src, sz) == 0);
+    }
+
+    /* Full grayscale: R == G == B == rounded Rec.601 luma, alpha untouched */
+    {
+        OverlayEffect gray = effect(OVERLAY_EFFECT_GRAYSCALE, 1.0f);
+        ok = apply_effect_chain_copy(&img, out, &gray, 1);
+        assert(ok == 1);
+        for (size_t i = 0; i < sz; i += 4) {
+            unsigned int y = (77u * src[i] + 150u * src[i + 1] + 29u * src[i + 2] + 128u) >> 8;
+            assert(out[i] == y && out[i + 1] == y && out[i + 2] == y);
+            assert(out[i + 3] == src[i + 3]);
+        }
+    }
+
+    /* Order matters: invert after grayscale inverts the grey */
+    {
+        OverlayEffect chain[2];
+        chain[0] = effect(OVERLAY_EFFECT_GRAYSCALE, 1.0f);
+        chain[1] = effect(OVERLAY_EFFECT_INVERT, 0.0f);
+        ok = apply_effect_chain_copy(&img, out, chain, 2);
+        assert(ok == 1);
+        for (size_t i = 0; i < sz; i += 4) {
+            unsigned int y = (77u * src[i] + 150u * src[i + 1] + 29u * src[i + 2] + 128u) >> 8;
+            assert(out[i] == 255 - y && out[i + 2] == 255 - y);
+        }
+    }
+
+    /* Full tint replaces the colour; threshold clears faint alpha */
+    {
+        OverlayEffect chain[2];
+        chain[0] = effect(OVERLAY_EFFECT_TINT, 1.0f);
+        chain[0].color[0] = 10;
+        chain[0].color[1] = 20;
+        chain[0].color[2] = 30;
+        chain[1] = effect(OVERLAY_EFFECT_ALPHA_THRESHOLD, 0.5f);
+        ok = apply_effect_chain_copy(&img, out, chain, 2);
+        assert(ok == 1);
+        for (size_t i = 0; i < sz; i += 4) {
+            assert(out[i] == 10 && out[i + 1] == 20 && out[i + 2] == 30);
+            assert(out[i + 3] == (src[i + 3] < 128 ? 0 : src[i + 3]));
+        }
+    }
+
+    /* Brightness/contrast: contrast 0 flattens to mid grey, brightness 1 saturates */
+    {
+        OverlayEffect bc = effect(OVERLAY_EFFECT_BRIGHTNESS_CONTRAST, 0.0f);
+        bc.value2 = 0.0f;
+        ok = apply_effect_chain_copy(&img, out, &bc, 1);
+        assert(ok == 1);
+        for (size_t i = 0; i < sz; i += 4) assert(out[i] == 128 && out[i + 1] == 128);
+        bc.value = 1.0f;
+        bc.value2 = 1.0f;
+        ok = apply_effect_chain_copy(&img, out, &bc, 1);
+        assert(ok == 1);
+        for (size_t i = 0; i < sz; i += 4) assert(out[i] == 255 && out[i + 2] == 255);
+    }
+
+    /* Invalid chains are rejected */
+    {
+        OverlayEffect bad = effect(OVERLAY_EFFECT_GAMMA, 0.0f);
+        ok = apply_effect_chain_copy(&img, out, &bad, 1);
+        assert(ok == 0);
+        OverlayEffect many[OVERLAY_MAX_EFFECT_CHAIN + 1];
+        for (int i = 0; i <= OVERLAY_MAX_EFFECT_CHAIN; i++) many[i] = effect(OVERLAY_EFFECT_INVERT, 0.0f);
+        ok = apply_effect_chain_copy(&img, out, many, OVERLAY_MAX_EFFECT_CHAIN + 1);
+        assert(ok == 0);
+    }
+
+    /* In place on a caller-filled overlay matches the copy path */
+    {
+        OverlayEffect chain[3];
+        chain[0] = effect(OVERLAY_EFFECT_GAMMA, 1.8f);
+        chain[1] = effect(OVERLAY_EFFECT_GRAYSCALE, 0.5f);
+        chain[2] = effect(OVERLAY_EFFECT_OPACITY, 0.4f);
+        ok = apply_effect_chain_copy(&img, ref, chain, 3);
+        assert(ok == 1);
+        img.data = out;
+        memcpy(out, src, sz);
+        ok = apply_effect_chain(&img, chain, 3);
+        assert(ok == 1);
+        assert(memcmp(out, ref, sz) == 0);
+        /* apply_effects afterwards is not mistaken for already applied */
+        assert(img.cached_effects == 4);
+    }
+
+    free(src);
+    free(out);
+    free(ref);
+
+    printf("test_overlay_effects: OK\n");
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "overlay.h"
+#include "overlay_simd.h"
+#include "test_util.h"
+
+#define W 61
+#define H 17
+
+int main(void) {
+    int ok;
+
+    /* Known pixel: R=200 G=100 B=50 A=128, no effects */
+    {
+        unsigned char px[4] = {200, 100, 50, 128};
+        unsigned char out[4];
+        Overlay one;
+        memset(&one, 0, sizeof(one));
+        one.width = 1;
+        one.height = 1;
+        one.channels = 4;
+        one.data = px;
+
+        ok = apply_effects_format(&one, out, 1.0f, 0, OVERLAY_FORMAT_BGRA_PREMUL);
+        assert(ok == 1);
+        assert(out[0] == (50 * 128 + 127) / 255);  /* B */
+        assert(out[1] == (100 * 128 + 127) / 255); /* G */
+        assert(out[2] == (200 * 128 + 127) / 255); /* R */
+        assert(out[3] == 128);
+
+        ok = apply_effects_format(&one, out, 1.0f, 0, OVERLAY_FORMAT_RGBA_PREMUL);
+        assert(ok == 1);
+        assert(out[0] == (200 * 128 + 127) / 255);
+        assert(out[2] == (50 * 128 + 127) / 255);
+
+        /* Invert + 50% opacity, then premultiply by the new alpha (64) */
+        ok = apply_effects_format(&one, out, 0.5f, 1, OVERLAY_FORMAT_BGRA_PREMUL);
+        assert(ok == 1);
+        assert(out[3] == 64);
+        assert(out[0] == ((255 - 50) * 64 + 127) / 255);
+        assert(out[2] == ((255 - 200) * 64 + 127) / 255);
+    }
+
+    /* Exhaustive check of the premultiply rounding for every color/alpha pair */
+    {
+        unsigned char *all = (unsigned char *)malloc(256 * 256 * 4);
+        unsigned char *out = (unsigned char *)malloc(256 * 256 * 4);
+        if (!all || !out) {
+            fprintf(stderr, "malloc failed\n");
+            return 2;
+        }
+        for (int a = 0; a < 256; a++) {
+            for (int c = 0; c < 256; c++) {
+                unsigned char *p = &all[(a * 256 + c) * 4];
+                p[0] = (unsigned char)c;
+                p[1] = (unsigned char)(255 - c);
+                p[2] = (unsigned char)(c ^ 0x55);
+                p[3] = (unsigned char)a;
+            }
+        }
+        Overlay grid;
+        memset(&grid, 0, sizeof(grid));
+        grid.width = 256;
+        grid.height = 256;
+        grid.channels = 4;
+        grid.data = all;
+        ok = apply_effects_format(&grid, out, 1.0f, 0, OVERLAY_FORMAT_RGBA_PREMUL);
+        assert(ok == 1);
+        for (int i = 0; i < 256 * 256; i++) {
+            const unsigned char *s = &all[i * 4];
+            const unsigned char *d = &out[i * 4];
+            for (int ch = 0; ch < 3; ch++) {
+                if (d[ch] != (s[ch] * s[3] + 127) / 255) {
+                    fprintf(stderr, "premultiply mismatch c=%d a=%d got %d\n", s[ch], s[3], d[ch]);
+                    return 1;
+                }
+            }
+            assert(d[3] == s[3]);
+        }
+        free(all);
+        free(out);
+    }
+
+    /* Every SIMD level must match the scalar kernel for every format */
+    {
+        const OverlaySimdLevel levels[] = {OVERLAY_SIMD_SSE2, OVERLAY_SIMD_AVX2, OVERLAY_SIMD_NEON};
+        const OverlayPixelFormat formats[] = {
+            OVERLAY_FORMAT_RGBA, OVERLAY_FORMAT_RGBA_PREMUL, OVERLAY_FORMAT_BGRA_PREMUL
+        };
+        const float opacities[] = {1.0f, 0.85f, 0.5f, 0.3f};
+        size_t sz = (size_t)W * H * 4;
+        Overlay img;
+        memset(&img, 0, sizeof(img));
+        img.width = W;
+        img.height = H;
+        img.channels = 4;
+        img.data = (unsigned char *)malloc(sz);
+        unsigned char *ref = (unsigned char *)malloc(sz);
+        unsigned char *out = (unsigned char *)malloc(sz);
+        if (!img.data || !ref || !out) {
+            fprintf(stderr, "malloc failed\n");
+            return 2;
+        }
+        test_fill_pattern(img.data, sz, 4242u);
+        OverlaySimdLevel best = overlay_get_simd_level();
+
+        for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+            for (size_t o = 0; o < sizeof(opacities) / sizeof(opacities[0]); o++) {
+                for (int invert = 0; invert < 2; invert++) {
+                    ok = overlay_set_simd_level(OVERLAY_SIMD_SCALAR);
+                    assert(ok);
+                    ok = apply_effects_format(&img, ref, opacities[o], invert, formats[f]);
+                    assert(ok == 1);
+                    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+                        if (!overlay_set_simd_level(levels[l])) continue;
+                        memset(out, 0, sz);
+                        ok = apply_effects_format(&img, out, opacities[o], invert, formats[f]);
+                        assert(ok == 1);
+                        if (memcmp(ref, out, sz) != 0) {
+                            fprintf(stderr, "level %d format %d opacity %.2f invert %d mismatch\n",
+                                    (int)levels[l], (int)formats[f], opacities[o], invert);
+                            return 1;
+                        }
+                    }
+                }
+            }
+        }
+
+        /* Opacity 1.0 plus premultiply is the conversion every presenter
+           runs; it must take the vectorized format stage. Scalar reads alpha
+           through alpha_lut and SIMD keeps identity alpha, so a poisoned
+           table shows which ran. */
+        for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+            if (!overlay_set_simd_level(levels[l])) continue;
+            for (size_t f = 1; f < sizeof(formats) / sizeof(formats[0]); f++) {
+                OverlayEffectParams params;
+                overlay_effect_params_init(&params, 1.0f, 0);
+                overlay_effect_params_set_format(&params, formats[f]);
+                memset(params.alpha_lut, 0, sizeof(params.alpha_lut));
+                overlay_get_effect_kernel()(img.data, out, 8, &params);
+                for (size_t i = 0; i < 8 * 4; i += 4) {
+                    if (out[i + 3] != img.data[i + 3]) {
+                        fprintf(stderr, "level %d format %d: premultiply at opacity 1.0 "
+                                "fell back to scalar\n", (int)levels[l], (int)formats[f]);
+                        return 1;
+                    }
+                }
+            }
+        }
+        overlay_set_simd_level(best);
+        free(ref);
+        free(out);
+        free_overlay(&img);
+    }
+
+    printf("test_overlay_format: OK\n");
+    return 0;
+}
@@ -0,0 +1,205 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "overlay.h"
+#include "overlay_layout.h"
+#include "test_util.h"
+
+/* Three keys on a transparent background: an opaque blank key, a
+   translucent one with a legend, and a wide key on the next row */
+static const char LAYOUT[] =
+    "{\n"
+    "  \"background\": \"#00000000\",\n"
+    "  \"key_color\": \"#204060\",\n"
+    "  \"radius\": 0.2, \"gap\": 0.1, \"font_size\": 0.3,\n"
+    "  \"comment\": [1, {\"nested\": true}, null, \"x\\u00e9\"],\n"
+    "  \"keys\": [\n"
+    "    {\"x\": 0, \"y\": 0},\n"
+    "    {\"label\": \"A\", \"color\": \"#80808080\", \"legend_color\": \"#FF0000FF\"},\n"
+    "    {\"x\": 0, \"y\": 1, \"w\": 2, \"label\": \"Tab\\nq\"}\n"
+    "  ]\n"
+    "}\n";
+
+static const unsigned char *pixel(const Overlay *o, int x, int y) {
+    return o->data + ((size_t)y * o->width + x) * 4;
+}
+
+static OverlayLayout *parse(const char *json) {
+    OverlayLayout *layout = NULL;
+    OverlayError err = overlay_layout_parse(json, strlen(json), &layout);
+    assert(err == OVERLAY_OK);
+    assert(layout != NULL);
+    return layout;
+}
+
+static OverlayError parse_error(const char *json) {
+    OverlayLayout *layout = (OverlayLayout *)&layout;
+    OverlayError err = overlay_layout_parse(json, strlen(json), &layout);
+    assert(layout == NULL);
+    return err;
+}
+
+int main(void) {
+    /* Detection: JSON objects, not images */
+    static const unsigned char png_sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    assert(overlay_layout_detect(png_sig, sizeof(png_sig)) == 0);
+    assert(overlay_layout_detect((const unsigned char *)LAYOUT, strlen(LAYOUT)) == 1);
+    assert(overlay_layout_detect((const unsigned char *)"\xEF\xBB\xBF  {}", 6) == 1);
+    assert(overlay_layout_detect((const unsigned char *)"[]", 2) == 0);
+    assert(overlay_layout_detect(NULL, 0) == 0);
+
+    /* Malformed descriptions */
+    OverlayError err = overlay_layout_parse(NULL, 0, NULL);
+    assert(err == OVERLAY_ERROR_NULL_PARAM);
+    err = parse_error("");
+    assert(err == OVERLAY_ERROR_DECODE_FAILED);
+    err = parse_error("{\"keys\": []}");
+    assert(err == OVERLAY_ERROR_DECODE_FAILED);
+    err = parse_error("{\"keys\": [{}]");
+    assert(err == OVERLAY_ERROR_DECODE_FAILED);
+    err = parse_error("{\"keys\": [{\"w\": 0}]}");
+    assert(err == OVERLAY_ERROR_DECODE_FAILED);
+    err = parse_error("{\"keys\": [{\"color\": \"#12345\"}]}");
+    assert(err == OVERLAY_ERROR_DECODE_FAILED);
+    err = parse_error("{\"keys\": [{\"label\": \"unterminated}]}");
+    assert(err == OVERLAY_ERROR_DECODE_FAILED);
+    err = parse_error("{\"keys\": [{\"x\": 1e999}]}");
+    assert(err == OVERLAY_ERROR_DECODE_FAILED);
+    err = parse_error("{\"keys\": [{}], \"width\": -3}");
+    assert(err == OVERLAY_ERROR_DECODE_FAILED);
+    err = parse_error("{\"a\": [[[[[[[[[[[[[[[[[[[[1]]]]]]]]]]]]]]]]]]], \"keys\": [{}]}");
+    assert(err == OVERLAY_ERROR_DECODE_FAILED);
+
+    /* Size: omitted x continues the row, the extent covers every key */
+    OverlayLayout *layout = parse(LAYOUT);
+    float w, h;
+    overlay_layout_size(layout, &w, &h);
+    assert(w == 2.0f && h == 2.0f);
+    {
+        OverlayLayout *sized = parse("{\"width\": 15, \"height\": 5, \"keys\": [{}]}");
+        overlay_layout_size(sized, &w, &h);
+        assert(w == 15.0f && h == 5.0f);
+        /* Rendered straight at the target size, however large */
+        Overlay big;
+        err = overlay_layout_render(sized, 5120, 2880, &big);
+        assert(err == OVERLAY_OK);
+        assert(big.width == 5120 && big.height == 1707);
+        assert(big.base == big.data && big.cached_effects == 0 && big.dirty_count == 1);
+        free_overlay(&big);
+        overlay_layout_free(sized);
+    }
+
+    err = overlay_layout_render(NULL, 10, 10, NULL);
+    assert(err == OVERLAY_ERROR_NULL_PARAM);
+    Overlay out;
+    err = overlay_layout_render(layout, 0, 10, &out);
+    assert(err == OVERLAY_ERROR_RESIZE_FAILED);
+
+    /* 100 px per key unit */
+    Overlay img;
+    err = overlay_layout_render(layout, 200, 300, &img);
+    assert(err == OVERLAY_OK);
+    assert(img.width == 200 && img.height == 200 && img.channels == 4);
+
+    /* Opaque key interior is exactly the key color */
+    const unsigned char *p = pixel(&img, 50, 50);
+    assert(p[0] == 0x20 && p[1] == 0x40 && p[2] == 0x60 && p[3] == 255);
+    /* The gap between keys and the rounded corner stay clear */
+    assert(pixel(&img, 100, 50)[3] == 0);
+    assert(pixel(&img, 0, 0)[3] == 0);
+    assert(pixel(&img, 6, 6)[3] == 0);
+    /* Anti-aliased corners: partial coverage, straight color kept up to the
+       rounding of premultiplied 8-bit at that alpha */
+    int partial = 0;
+    for (int y = 0; y < 100; y++) {
+        for (int x = 0; x < 100; x++) {
+            const unsigned char *e = pixel(&img, x, y);
+            if (e[3] > 0 && e[3] < 255) {
+                partial++;
+                int tol = 255 / e[3] + 1;
+                assert(abs(e[0] - 0x20) <= tol && abs(e[1] - 0x40) <= tol &&
+                       abs(e[2] - 0x60) <= tol);
+            }
+        }
+    }
+    assert(partial >= 8);
+
+    /* Translucent key with a red legend centered on it */
+    p = pixel(&img, 150, 20);
+    assert(p[0] == 0x80 && p[1] == 0x80 && p[2] == 0x80 && p[3] == 0x80);
+    int red = 0, ink_left = 200, ink_right = 0;
+    for (int y = 0; y < 100; y++) {
+        for (int x = 100; x < 200; x++) {
+            const unsigned char *q = pixel(&img, x, y);
+            if (q[0] == 255 && q[1] == 0 && q[3] == 255) red++;
+            if (q[0] > q[1] + 8) {
+                if (x < ink_left) ink_left = x;
+                if (x > ink_right) ink_right = x;
+            }
+        }
+    }
+    assert(red > 20);
+    assert(ink_left > 120 && ink_right < 180);
+    assert(abs((ink_left + ink_right) / 2 - 150) <= 2);
+    /* Two legend lines on the wide key: two separate runs of inked rows */
+    int runs = 0, inked = 0;
+    for (int y = 100; y < 200; y++) {
+        int any = 0;
+        for (int x = 0; x < 200; x++) any |= pixel(&img, x, y)[0] > 0x80;
+        if (any && !inked) runs++;
+        inked = any;
+    }
+    assert(runs == 2);
+    free_overlay(&img);
+
+    /* Every SIMD level and thread count renders the same bytes */
+    {
+        OverlaySimdLevel detected = overlay_simd_detect();
+        overlay_set_simd_level(OVERLAY_SIMD_SCALAR);
+        overlay_set_thread_count(1);
+        Overlay ref;
+        err = overlay_layout_render(layout, 733, 733, &ref);
+        assert(err == OVERLAY_OK);
+        static const OverlaySimdLevel levels[] = {OVERLAY_SIMD_SSE2, OVERLAY_SIMD_AVX2,
+                                                  OVERLAY_SIMD_NEON};
+        for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+            if (!overlay_set_simd_level(levels[i])) continue;
+            Overlay other;
+            err = overlay_layout_render(layout, 733, 733, &other);
+            assert(err == OVERLAY_OK);
+            assert(test_same_pixels(&ref, &other));
+            free_overlay(&other);
+        }
+        overlay_set_simd_level(detected);
+        overlay_set_thread_count(4);
+        overlay_set_parallel_threshold(1);
+        Overlay banded;
+        err = overlay_layout_render(layout, 733, 733, &banded);
+        assert(err == OVERLAY_OK);
+        assert(test_same_pixels(&ref, &banded));
+        free_overlay(&banded);
+        overlay_set_thread_count(0);
+        overlay_set_parallel_threshold(OVERLAY_PARALLEL_DEFAULT_MIN_PIXELS);
+        free_overlay(&ref);
+    }
+
+    /* Layout defaults may come after the keys; per-key values win */
+    {
+        OverlayLayout *late = parse("{\"keys\": [{\"label\": \"x\"}, {\"color\": \"#00FF00\"}],"
+                                    " \"key_color\": \"#0000FF\", \"gap\": 0, \"radius\": 0}");
+        Overlay o;
+        err = overlay_layout_render(late, 20, 10, &o);
+        assert(err == OVERLAY_OK);
+        assert(o.width == 20 && o.height == 10);
+        assert(memcmp(pixel(&o, 0, 0), "\x00\x00\xFF\xFF", 4) == 0);
+        assert(memcmp(pixel(&o, 15, 5), "\x00\xFF\x00\xFF", 4) == 0);
+        free_overlay(&o);
+        overlay_layout_free(late);
+    }
+
+    overlay_layout_free(layout);
+    overlay_layout_free(NULL);
+    printf("test_overlay_layout: OK\n");
+    return 0;
+}
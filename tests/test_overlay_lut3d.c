@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "overlay.h"
+#include "test_util.h"
+
+/* 61x67: odd sizes so band splits and tails are uneven */
+#define W 61
+#define H 67
+
+static Overlay make_overlay(void) {
+    Overlay img;
+    memset(&img, 0, sizeof(img));
+    img.width = W;
+    img.height = H;
+    img.channels = 4;
+    img.data = (unsigned char *)malloc((size_t)W * H * 4);
+    assert(img.data != NULL);
+    test_fill_pattern(img.data, (size_t)W * H * 4, 777u);
+    /* the extremes of every channel */
+    memset(img.data, 0, 4);
+    memset(img.data + 4, 255, 4);
+    return img;
+}
+
+int main(void) {
+    const OverlaySimdLevel levels[] = {
+        OVERLAY_SIMD_SSE2, OVERLAY_SIMD_AVX2, OVERLAY_SIMD_NEON
+    };
+    OverlaySimdLevel best = overlay_simd_detect();
+    size_t sz = (size_t)W * H * 4;
+    Overlay img = make_overlay();
+    unsigned char *out = (unsigned char *)malloc(sz);
+    unsigned char *ref = (unsigned char *)malloc(sz);
+    assert(out && ref);
+    OverlayError err;
+    int ok;
+
+    /* Identity LUTs whose grid lands on whole 8-bit steps are exact */
+    const int exact_sizes[] = {2, 4, 18};
+    for (size_t s = 0; s < sizeof(exact_sizes) / sizeof(exact_sizes[0]); s++) {
+        OverlayColorLut lut;
+        err = overlay_color_lut_init(&lut, exact_sizes[s], 1);
+        assert(err == OVERLAY_OK);
+        ok = apply_color_lut_copy(&img, out, &lut);
+        assert(ok == 1);
+        assert(memcmp(out, img.data, sz) == 0);
+        overlay_color_lut_free(&lut);
+    }
+
+    /* Common theme sizes stay within one step of the identity */
+    const int sizes[] = {17, 33};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        OverlayColorLut lut;
+        err = overlay_color_lut_init(&lut, sizes[s], 2);
+        assert(err == OVERLAY_OK);
+        ok = apply_color_lut_copy(&img, out, &lut);
+        assert(ok == 1);
+        for (size_t i = 0; i < sz; i++) {
+            int d = (int)out[i] - (int)img.data[i];
+            assert(d >= -1 && d <= 1);
+            if (i % 4 == 3) assert(d == 0);
+        }
+        overlay_color_lut_free(&lut);
+    }
+
+    /* Pixels on grid points return the table entry exactly */
+    {
+        OverlayColorLut lut;
+        err = overlay_color_lut_init(&lut, 18, 3);
+        assert(err == OVERLAY_OK);
+        size_t n = (size_t)18 * 18 * 18 * 3;
+        test_fill_pattern(lut.table, n, 18u);
+        Overlay grid;
+        memset(&grid, 0, sizeof(grid));
+        grid.width = 18 * 18;
+        grid.height = 18;
+        grid.channels = 4;
+        grid.data = (unsigned char *)malloc((size_t)grid.width * grid.height * 4);
+        unsigned char *gout = (unsigned char *)malloc((size_t)grid.width * grid.height * 4);
+        assert(grid.data && gout);
+        for (int i = 0; i < 18 * 18 * 18; i++) {
+            grid.data[i * 4 + 0] = (unsigned char)((i % 18) * 15);
+            grid.data[i * 4 + 1] = (unsigned char)((i / 18 % 18) * 15);
+            grid.data[i * 4 + 2] = (unsigned char)((i / 324) * 15);
+            grid.data[i * 4 + 3] = 77;
+        }
+        ok = apply_color_lut_copy(&grid, gout, &lut);
+        assert(ok == 1);
+        for (int i = 0; i < 18 * 18 * 18; i++) {
+            assert(gout[i * 4 + 0] == lut.table[i * 3 + 0]);
+            assert(gout[i * 4 + 1] == lut.table[i * 3 + 1]);
+            assert(gout[i * 4 + 2] == lut.table[i * 3 + 2]);
+            assert(gout[i * 4 + 3] == 77);
+        }
+        free(gout);
+        free_overlay(&grid);
+        overlay_color_lut_free(&lut);
+    }
+
+    /* Every SIMD level matches the scalar reference on a random LUT */
+    int tested = 0;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        OverlayColorLut lut;
+        err = overlay_color_lut_init(&lut, sizes[s], 4);
+        assert(err == OVERLAY_OK);
+        size_t n = (size_t)sizes[s] * sizes[s] * sizes[s] * 3;
+        test_fill_pattern(lut.table, n, (unsigned int)sizes[s]);
+
+        ok = overlay_set_simd_level(OVERLAY_SIMD_SCALAR);
+        assert(ok);
+        ok = apply_color_lut_copy(&img, ref, &lut);
+        assert(ok == 1);
+        for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+            if (!overlay_set_simd_level(levels[l])) continue;
+            tested++;
+            memset(out, 0, sz);
+            ok = apply_color_lut_copy(&img, out, &lut);
+            assert(ok == 1);
+            if (memcmp(out, ref, sz) != 0) {
+                fprintf(stderr, "level %d: LUT size %d mismatch\n", (int)levels[l], sizes[s]);
+                return 1;
+            }
+        }
+        overlay_set_simd_level(best);
+        overlay_color_lut_free(&lut);
+    }
+
+    err = overlay_color_lut_init(NULL, 17, 0);
+    assert(err == OVERLAY_ERROR_NULL_PARAM);
+    {
+        OverlayColorLut bad;
+        err = overlay_color_lut_init(&bad, 1, 0);
+        assert(err == OVERLAY_ERROR_INVALID_ARG);
+        ok = apply_color_lut_copy(&img, out, &bad);
+        assert(ok == 0);
+        err = overlay_color_lut_init(&bad, OVERLAY_COLOR_LUT_MAX_SIZE + 1, 0);
+        assert(err == OVERLAY_ERROR_INVALID_ARG);
+    }
+
+    /* Cached recolours: built once per id, oldest evicted when full */
+    {
+        OverlayCache cache;
+        err = init_overlay_cache(&cache, &img);
+        assert(err == OVERLAY_OK);
+        OverlayColorLut luts[MAX_CACHED_RECOLORS + 1];
+        for (int i = 0; i <= MAX_CACHED_RECOLORS; i++) {
+            err = overlay_color_lut_init(&luts[i], 5, 100u + (unsigned int)i);
+            assert(err == OVERLAY_OK);
+            test_fill_pattern(luts[i].table, (size_t)5 * 5 * 5 * 3, 500u + (unsigned int)i);
+        }
+        const Overlay *first = get_cached_recolor(&cache, &luts[0]);
+        assert(first != NULL);
+        const Overlay *again = get_cached_recolor(&cache, &luts[0]);
+        assert(again == first);
+        ok = apply_color_lut_copy(&img, ref, &luts[0]);
+        assert(ok == 1);
+        assert(memcmp(first->data, ref, sz) == 0);
+        for (int i = 1; i <= MAX_CACHED_RECOLORS; i++) {
+            const Overlay *v = get_cached_recolor(&cache, &luts[i]);
+            assert(v != NULL);
+        }
+        assert(cache.recolor_count == MAX_CACHED_RECOLORS);
+        for (int i = 0; i < cache.recolor_count; i++) assert(cache.recolor_ids[i] != 100u);
+        free_overlay_cache(&cache);
+        for (int i = 0; i <= MAX_CACHED_RECOLORS; i++) overlay_color_lut_free(&luts[i]);
+    }
+
+    free(out);
+    free(ref);
+    free_overlay(&img);
+
+    printf("test_overlay_lut3d: OK (%d SIMD run(s) checked)\n", tested);
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "overlay.h"
+#include "test_util.h"
+
+static OverlaySource make_source(int w, int h) {
+    OverlaySource src;
+    memset(&src, 0, sizeof(src));
+    src.width = w;
+    src.height = h;
+    src.pixels = (unsigned char *)malloc((size_t)w * h * 4);
+    assert(src.pixels != NULL);
+    test_fill_pattern(src.pixels, (size_t)w * h * 4, 4242u + (unsigned int)(w * h));
+    return src;
+}
+
+/* Straightforward 2x2 box with edge clamping */
+static void box_reference(const unsigned char *in, int w, int h, unsigned char *out) {
+    int nw = (w + 1) / 2, nh = (h + 1) / 2;
+    for (int y = 0; y < nh; y++) {
+        int y0 = 2 * y, y1 = 2 * y + 1 < h ? 2 * y + 1 : h - 1;
+        for (int x = 0; x < nw; x++) {
+            int x0 = 2 * x, x1 = 2 * x + 1 < w ? 2 * x + 1 : w - 1;
+            for (int c = 0; c < 4; c++) {
+                int sum = in[((size_t)y0 * w + x0) * 4 + c] + in[((size_t)y0 * w + x1) * 4 + c] +
+                          in[((size_t)y1 * w + x0) * 4 + c] + in[((size_t)y1 * w + x1) * 4 + c];
+                out[((size_t)y * nw + x) * 4 + c] = (unsigned char)((sum + 2) >> 2);
+            }
+        }
+    }
+}
+
+int main(void) {
+    const OverlaySimdLevel levels[] = {
+        OVERLAY_SIMD_SCALAR, OVERLAY_SIMD_SSE2, OVERLAY_SIMD_AVX2, OVERLAY_SIMD_NEON
+    };
+    OverlaySimdLevel best = overlay_simd_detect();
+    OverlayError err;
+
+    /* Every level of the pyramid is the exact box of the one above it, for
+       odd and even sizes and every SIMD level */
+    const int sizes[][2] = {{1, 1}, {2, 2}, {7, 5}, {64, 48}, {101, 37}, {3, 90}};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+            if (!overlay_set_simd_level(levels[l])) continue;
+            OverlaySource src = make_source(sizes[s][0], sizes[s][1]);
+            err = overlay_source_build_mips(&src);
+            assert(err == OVERLAY_OK);
+
+            const unsigned char *prev = src.pixels;
+            int w = src.width, h = src.height;
+            for (int i = 0; i < src.mip_count; i++) {
+                const OverlayMipLevel *m = &src.mips[i];
+                assert(m->width == (w + 1) / 2 && m->height == (h + 1) / 2);
+                unsigned char *ref = (unsigned char *)malloc((size_t)m->width * m->height * 4);
+                assert(ref != NULL);
+                box_reference(prev, w, h, ref);
+                if (memcmp(ref, m->pixels, (size_t)m->width * m->height * 4) != 0) {
+                    fprintf(stderr, "level %d: %dx%d mip %d mismatch\n",
+                            (int)levels[l], sizes[s][0], sizes[s][1], i);
+                    return 1;
+                }
+                free(ref);
+                prev = m->pixels;
+                w = m->width;
+                h = m->height;
+            }
+            /* down to 1x1; a 1x1 source has no levels */
+            assert(w == 1 && h == 1);
+            overlay_source_free(&src);
+            assert(src.mip_count == 0 && src.pixels == NULL);
+        }
+    }
+    overlay_set_simd_level(best);
+
+    /* Building twice is a no-op */
+    OverlaySource src = make_source(64, 48);
+    err = overlay_source_build_mips(&src);
+    assert(err == OVERLAY_OK);
+    int count = src.mip_count;
+    unsigned char *first = src.mips[0].pixels;
+    err = overlay_source_build_mips(&src);
+    assert(err == OVERLAY_OK);
+    assert(src.mip_count == count && src.mips[0].pixels == first);
+
+    /* A target that is exactly a level is a copy of that level */
+    Overlay ov;
+    err = overlay_from_source(&src, 32, 24, &ov);
+    assert(err == OVERLAY_OK);
+    assert(ov.width == 32 && ov.height == 24);
+    assert(memcmp(ov.data, src.mips[0].pixels, (size_t)32 * 24 * 4) == 0);
+    free_overlay(&ov);
+    err = overlay_from_source(&src, 8, 100, &ov);
+    assert(err == OVERLAY_OK);
+    assert(ov.width == 8 && ov.height == 6);
+    assert(memcmp(ov.data, src.mips[2].pixels, (size_t)8 * 6 * 4) == 0);
+    free_overlay(&ov);
+
+    /* Full size still copies the source itself */
+    err = overlay_from_source(&src, 64, 48, &ov);
+    assert(err == OVERLAY_OK);
+    assert(memcmp(ov.data, src.pixels, (size_t)64 * 48 * 4) == 0);
+    free_overlay(&ov);
+
+    /* In-between sizes resample from the nearest larger level and match
+       resampling that level directly */
+    OverlaySource level;
+    memset(&level, 0, sizeof(level));
+    level.pixels = src.mips[0].pixels;
+    level.width = src.mips[0].width;
+    level.height = src.mips[0].height;
+    Overlay a, b;
+    err = overlay_from_source(&src, 20, 15, &a);
+    assert(err == OVERLAY_OK);
+    err = overlay_from_source(&level, 20, 15, &b);
+    assert(err == OVERLAY_OK);
+    assert(a.width == 20 && a.height == 15);
+    assert(memcmp(a.data, b.data, (size_t)20 * 15 * 4) == 0);
+    free_overlay(&a);
+    free_overlay(&b);
+
+    /* Upscaling has no level to use and reads the source */
+    err = overlay_from_source(&src, 128, 96, &ov);
+    assert(err == OVERLAY_OK);
+    assert(ov.width == 128 && ov.height == 96);
+    free_overlay(&ov);
+
+    err = overlay_source_build_mips(NULL);
+    assert(err == OVERLAY_ERROR_NULL_PARAM);
+    overlay_source_free(&src);
+
+    printf("test_overlay_mip: OK\n");
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "overlay.h"
+#include "overlay_parallel.h"
+#include "test_util.h"
+
+/* Odd sizes so bands are uneven and rows are not a multiple of the SIMD width */
+#define W 333
+#define H 97
+
+static void reset(Overlay *img, const unsigned char *src, size_t sz) {
+    memcpy(img->data, src, sz);
+    img->cached_effects = 0;
+    img->cached_opacity = -1.0f;
+    img->cached_invert = 0;
+}
+
+/* Outer bands each post their own inner batch, so batches from several
+   threads share the pool at once and a band calls back into it */
+#define OUTER_ROWS 12
+#define INNER_ROWS 40
+
+typedef struct {
+    int (*hits)[INNER_ROWS];
+    int outer;
+} InnerCtx;
+
+static void inner_band(void *ctx, int begin, int end) {
+    InnerCtx *inner = (InnerCtx *)ctx;
+    for (int r = begin; r < end; r++) inner->hits[inner->outer][r]++;
+}
+
+static void outer_band(void *ctx, int begin, int end) {
+    for (int r = begin; r < end; r++) {
+        InnerCtx inner = {(int (*)[INNER_ROWS])ctx, r};
+        overlay_parallel_rows(INNER_ROWS, 0, inner_band, &inner);
+    }
+}
+
+int main(void) {
+    size_t sz = (size_t)W * H * 4;
+    unsigned char *src = (unsigned char *)malloc(sz);
+    unsigned char *ref = (unsigned char *)malloc(sz);
+    unsigned char *dst = (unsigned char *)malloc(sz);
+    Overlay img;
+    memset(&img, 0, sizeof(img));
+    img.width = W;
+    img.height = H;
+    img.channels = 4;
+    img.data = (unsigned char *)malloc(sz);
+    if (!src || !ref || !dst || !img.data) {
+        fprintf(stderr, "malloc failed\n");
+        return 2;
+    }
+    test_fill_pattern(src, sz, 777u);
+
+    assert(overlay_get_thread_count() >= 1);
+    assert(overlay_get_parallel_threshold() == OVERLAY_PARALLEL_DEFAULT_MIN_PIXELS);
+
+    /* Single-threaded reference */
+    overlay_set_thread_count(1);
+    reset(&img, src, sz);
+    apply_effects(&img, 0.85f, 1);
+    memcpy(ref, img.data, sz);
+
+    /* Force the parallel path regardless of image size */
+    overlay_set_parallel_threshold(0);
+    const int counts[] = {2, 3, 4, 7, 16, 200};
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        overlay_set_thread_count(counts[c]);
+
+        reset(&img, src, sz);
+        apply_effects(&img, 0.85f, 1);
+        if (memcmp(ref, img.data, sz) != 0) {
+            fprintf(stderr, "apply_effects mismatch with %d threads\n", counts[c]);
+            return 1;
+        }
+
+        reset(&img, src, sz);
+        memset(dst, 0, sz);
+        int copied = apply_effects_copy(&img, dst, 0.85f, 1);
+        assert(copied == 1);
+        if (memcmp(ref, dst, sz) != 0) {
+            fprintf(stderr, "apply_effects_copy mismatch with %d threads\n", counts[c]);
+            return 1;
+        }
+        assert(memcmp(img.data, src, sz) == 0);
+    }
+
+    /* Resizes split output rows into bands; every band count must give the
+       single-threaded pixels, downscaling and upscaling alike */
+    OverlaySource source;
+    OverlayError err = overlay_source_wrap(src, W, H, &source);
+    assert(err == OVERLAY_OK);
+    const int sizes[][2] = {{150, 150}, {1000, 1000}, {W, 40}, {W - 1, H + 1}};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        Overlay single;
+        overlay_set_thread_count(1);
+        err = overlay_from_source(&source, sizes[s][0], sizes[s][1], &single);
+        assert(err == OVERLAY_OK);
+        size_t rsz = (size_t)single.width * single.height * 4;
+
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+            Overlay banded;
+            overlay_set_thread_count(counts[c]);
+            err = overlay_from_source(&source, sizes[s][0], sizes[s][1], &banded);
+            assert(err == OVERLAY_OK);
+            assert(banded.width == single.width && banded.height == single.height);
+            if (memcmp(single.data, banded.data, rsz) != 0) {
+                fprintf(stderr, "resize to %dx%d mismatch with %d threads\n",
+                        single.width, single.height, counts[c]);
+                return 1;
+            }
+            free_overlay(&banded);
+        }
+        free_overlay(&single);
+    }
+    overlay_source_free(&source);
+
+    /* The pool covers every row exactly once however calls nest */
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        static int hits[OUTER_ROWS][INNER_ROWS];
+        memset(hits, 0, sizeof(hits));
+        overlay_set_thread_count(counts[c]);
+        overlay_parallel_rows(OUTER_ROWS, 0, outer_band, hits);
+        for (int o = 0; o < OUTER_ROWS; o++) {
+            for (int i = 0; i < INNER_ROWS; i++) {
+                if (hits[o][i] != 1) {
+                    fprintf(stderr, "nested bands: row %d/%d ran %d times with %d threads\n",
+                            o, i, hits[o][i], counts[c]);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    overlay_set_thread_count(0);
+    overlay_set_parallel_threshold(OVERLAY_PARALLEL_DEFAULT_MIN_PIXELS);
+    free(src);
+    free(ref);
+    free(dst);
+    free_overlay(&img);
+
+    printf("test_overlay_parallel: OK\n");
+    return 0;
+}
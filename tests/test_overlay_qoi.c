@@ -0,0 +1,213 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "overlay.h"
+#include "overlay_qoi.h"
+
+#define W 301
+#define H 97
+#define FILE_PATH "overlay_qoi_test.qoi"
+
+/* Every QOI op: long runs, small and luma diffs, index hits, alpha changes
+   and noise */
+static void fill(unsigned char *rgba, int w, int h) {
+    unsigned int seed = 12345u;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            unsigned char *p = rgba + ((size_t)y * w + x) * 4;
+            if (y < 10) {
+                p[0] = p[1] = p[2] = 0;
+                p[3] = 255;
+            } else if (y < 30) {
+                p[0] = (unsigned char)x;
+                p[1] = (unsigned char)(x * 2 + y);
+                p[2] = (unsigned char)(x + 3 * y);
+                p[3] = 255;
+            } else if (y < 50) {
+                static const unsigned char palette[3][4] = {
+                    {200, 10, 10, 255}, {10, 200, 10, 128}, {10, 10, 200, 0}};
+                memcpy(p, palette[(x / 3 + y) % 3], 4);
+            } else {
+                seed = seed * 1103515245u + 12345u;
+                p[0] = (unsigned char)(seed >> 24);
+                p[1] = (unsigned char)(seed >> 16);
+                p[2] = (unsigned char)(seed >> 8);
+                p[3] = (unsigned char)(x & 1 ? 255 : seed >> 20);
+            }
+        }
+    }
+}
+
+static int decode_all(const unsigned char *qoi, size_t len, unsigned char *out, int w, int h) {
+    OverlayQoiStream *s = overlay_qoi_open(qoi, len);
+    if (!s) return 0;
+    int sw, sh;
+    overlay_qoi_size(s, &sw, &sh);
+    assert(sw == w && sh == h);
+    int ok = 1;
+    for (int y = 0; y < h && ok; y++) ok = overlay_qoi_read_row(s, out + (size_t)y * w * 4);
+    if (ok) {
+        int extra = overlay_qoi_read_row(s, out); /* past the last row */
+        assert(extra == 0);
+    }
+    overlay_qoi_close(s);
+    return ok;
+}
+
+int main(void) {
+    /* Byte-exact against the format: a run, then an RGB op */
+    {
+        static const unsigned char px[3 * 4] = {0, 0, 0, 255, 0, 0, 0, 255, 10, 20, 30, 255};
+        static const unsigned char expect[] = {
+            'q', 'o', 'i', 'f', 0, 0, 0, 3, 0, 0, 0, 1, 4, 0,
+            0xC1,                    /* run of 2 of the initial pixel */
+            0xFE, 10, 20, 30,        /* RGB */
+            0, 0, 0, 0, 0, 0, 0, 1}; /* padding */
+        size_t len;
+        unsigned char *qoi = overlay_qoi_encode(px, 3, 1, &len);
+        assert(qoi != NULL);
+        assert(len == sizeof(expect) && memcmp(qoi, expect, len) == 0);
+        free(qoi);
+    }
+
+    unsigned char *rgba = (unsigned char *)malloc((size_t)W * H * 4);
+    unsigned char *back = (unsigned char *)malloc((size_t)W * H * 4);
+    if (!rgba || !back) {
+        fprintf(stderr, "malloc failed\n");
+        return 2;
+    }
+    fill(rgba, W, H);
+
+    size_t len;
+    unsigned char *qoi = overlay_qoi_encode(rgba, W, H, &len);
+    assert(qoi != NULL);
+    assert(len < (size_t)W * H * 4);
+
+    /* Lossless round trip */
+    OverlayError err;
+    int ok = decode_all(qoi, len, back, W, H);
+    assert(ok);
+    assert(memcmp(rgba, back, (size_t)W * H * 4) == 0);
+
+    /* Headers the decoder refuses */
+    unsigned char *none = overlay_qoi_encode(NULL, 1, 1, &len);
+    assert(none == NULL);
+    OverlayQoiStream *rejected = overlay_qoi_open(qoi, 10);
+    assert(rejected == NULL);
+    {
+        unsigned char bad[32];
+        memcpy(bad, qoi, sizeof(bad));
+        bad[0] = 'Q';
+        rejected = overlay_qoi_open(bad, sizeof(bad));
+        assert(rejected == NULL);
+        memcpy(bad, qoi, sizeof(bad));
+        bad[12] = 2; /* channels */
+        rejected = overlay_qoi_open(bad, sizeof(bad));
+        assert(rejected == NULL);
+        memcpy(bad, qoi, sizeof(bad));
+        memset(bad + 4, 0xFF, 8); /* absurd size */
+        rejected = overlay_qoi_open(bad, sizeof(bad));
+        assert(rejected == NULL);
+    }
+    /* Truncated streams fail a row instead of reading past the end */
+    ok = decode_all(qoi, len / 2, back, W, H);
+    assert(ok == 0);
+
+    /* load_overlay_mem takes QOI by its magic: at full size the pixels come
+       back untouched, resized it matches the same pixels wrapped as a
+       source */
+    {
+        Overlay full;
+        err = load_overlay_mem(qoi, (int)len, W, H, &full);
+        assert(err == OVERLAY_OK);
+        assert(full.width == W && full.height == H);
+        assert(memcmp(full.data, rgba, (size_t)W * H * 4) == 0);
+        free_overlay(&full);
+
+        Overlay small;
+        err = load_overlay_mem(qoi, (int)len, 120, 120, &small);
+        assert(err == OVERLAY_OK);
+        assert(small.width == 120 && small.height == 39);
+
+        /* Decoding on a helper thread gives the same result */
+        overlay_set_thread_count(4);
+        overlay_set_parallel_threshold(1);
+        Overlay piped;
+        err = load_overlay_mem(qoi, (int)len, 120, 120, &piped);
+        assert(err == OVERLAY_OK);
+        assert(memcmp(piped.data, small.data, (size_t)120 * 39 * 4) == 0);
+        free_overlay(&piped);
+        overlay_set_thread_count(0);
+        overlay_set_parallel_threshold(OVERLAY_PARALLEL_DEFAULT_MIN_PIXELS);
+        free_overlay(&small);
+
+        Overlay broken;
+        err = load_overlay_mem(qoi, (int)(len / 2), W, H, &broken);
+        assert(err == OVERLAY_ERROR_DECODE_FAILED);
+    }
+
+    /* Sources and files */
+    {
+        OverlaySource src;
+        err = overlay_source_load_mem(qoi, (int)len, &src);
+        assert(err == OVERLAY_OK);
+        assert(src.width == W && src.height == H && !src.borrowed);
+        assert(memcmp(src.pixels, rgba, (size_t)W * H * 4) == 0);
+        overlay_source_free(&src);
+        err = overlay_source_load_mem(qoi, (int)(len / 2), &src);
+        assert(err == OVERLAY_ERROR_DECODE_FAILED);
+        assert(src.pixels == NULL);
+
+        FILE *f = fopen(FILE_PATH, "wb");
+        assert(f != NULL);
+        size_t written = fwrite(qoi, 1, len, f);
+        assert(written == len);
+        fclose(f);
+        err = overlay_source_load(FILE_PATH, &src);
+        assert(err == OVERLAY_OK);
+        assert(memcmp(src.pixels, rgba, (size_t)W * H * 4) == 0);
+        overlay_source_free(&src);
+
+        Overlay from_file, from_mem;
+        err = load_overlay(FILE_PATH, 200, 200, &from_file);
+        assert(err == OVERLAY_OK);
+        err = load_overlay_mem(qoi, (int)len, 200, 200, &from_mem);
+        assert(err == OVERLAY_OK);
+        assert(from_file.width == from_mem.width && from_file.height == from_mem.height);
+        assert(memcmp(from_file.data, from_mem.data,
+                      (size_t)from_file.width * from_file.height * 4) == 0);
+        free_overlay(&from_file);
+        free_overlay(&from_mem);
+        remove(FILE_PATH);
+    }
+
+#ifdef KEYMAP_PNG_PATH
+    /* A transcoded keymap loads exactly like the PNG it came from */
+    {
+        OverlaySource png;
+        err = overlay_source_load(KEYMAP_PNG_PATH, &png);
+        assert(err == OVERLAY_OK);
+        size_t keymap_len;
+        unsigned char *keymap = overlay_qoi_encode(png.pixels, png.width, png.height, &keymap_len);
+        assert(keymap != NULL);
+        Overlay a, b;
+        err = load_overlay(KEYMAP_PNG_PATH, 300, 300, &a);
+        assert(err == OVERLAY_OK);
+        err = load_overlay_mem(keymap, (int)keymap_len, 300, 300, &b);
+        assert(err == OVERLAY_OK);
+        assert(a.width == b.width && a.height == b.height);
+        assert(memcmp(a.data, b.data, (size_t)a.width * a.height * 4) == 0);
+        free_overlay(&a);
+        free_overlay(&b);
+        free(keymap);
+        overlay_source_free(&png);
+    }
+#endif
+
+    free(qoi);
+    free(rgba);
+    free(back);
+    printf("test_overlay_qoi: OK\n");
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "overlay.h"
+#include "test_util.h"
+
+/* Divisible by 4 for the exact-ratio cases; the other bounds give output
+   widths that are not multiples of 4, so the SIMD tails run too */
+#define W 84
+#define H 60
+
+static const OverlayResizeFilter filters[] = {
+    OVERLAY_FILTER_AUTO, OVERLAY_FILTER_BOX, OVERLAY_FILTER_BILINEAR,
+    OVERLAY_FILTER_CATMULL_ROM, OVERLAY_FILTER_LANCZOS3
+};
+
+/* Bounds: reduce, odd reduce, exact 2x and 4x, enlarge, whole-number enlarge */
+static const int sizes[][2] = {
+    {50, 50}, {W - 7, H}, {W / 2, H / 2}, {W / 4, H / 4}, {200, 200}, {W * 3, H * 3}
+};
+
+static Overlay resize(const OverlaySource *src, OverlayResizeFilter filter, int w, int h) {
+    Overlay out;
+    overlay_set_resize_filter(filter);
+    OverlayError err = overlay_from_source(src, w, h, &out);
+    assert(err == OVERLAY_OK);
+    return out;
+}
+
+int main(void) {
+    size_t sz = (size_t)W * H * 4;
+    unsigned char *noise = (unsigned char *)malloc(sz);
+    unsigned char *flat = (unsigned char *)malloc(sz);
+    unsigned char *ramp = (unsigned char *)malloc(sz);
+    if (!noise || !flat || !ramp) {
+        fprintf(stderr, "malloc failed\n");
+        return 2;
+    }
+    test_fill_pattern(noise, sz, 4242u);
+    for (size_t i = 0; i < (size_t)W * H; i++) {
+        flat[i * 4 + 0] = 200;
+        flat[i * 4 + 1] = 100;
+        flat[i * 4 + 2] = 3;
+        flat[i * 4 + 3] = 255;
+    }
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            unsigned char *p = ramp + ((size_t)y * W + x) * 4;
+            p[0] = p[1] = p[2] = (unsigned char)(x * 3);
+            p[3] = 255;
+        }
+    }
+
+    OverlaySource src_noise, src_flat, src_ramp;
+    OverlayError err = overlay_source_wrap(noise, W, H, &src_noise);
+    assert(err == OVERLAY_OK);
+    err = overlay_source_wrap(flat, W, H, &src_flat);
+    assert(err == OVERLAY_OK);
+    err = overlay_source_wrap(ramp, W, H, &src_ramp);
+    assert(err == OVERLAY_OK);
+
+    /* The setting is process-wide and rejects unknown values */
+    assert(overlay_get_resize_filter() == OVERLAY_FILTER_AUTO);
+    overlay_set_resize_filter(OVERLAY_FILTER_LANCZOS3);
+    assert(overlay_get_resize_filter() == OVERLAY_FILTER_LANCZOS3);
+    overlay_set_resize_filter((OverlayResizeFilter)99);
+    assert(overlay_get_resize_filter() == OVERLAY_FILTER_AUTO);
+
+    const OverlaySimdLevel levels[] = {
+        OVERLAY_SIMD_SSE2, OVERLAY_SIMD_AVX2, OVERLAY_SIMD_NEON
+    };
+    int simd_checked = 0;
+    for (size_t f = 0; f < sizeof(filters) / sizeof(filters[0]); f++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            /* Normalised weights: flat colour stays exactly flat */
+            Overlay o = resize(&src_flat, filters[f], sizes[s][0], sizes[s][1]);
+            for (int i = 0; i < o.width * o.height; i++) {
+                assert(memcmp(o.data + (size_t)i * 4, flat, 4) == 0);
+            }
+            free_overlay(&o);
+
+            /* Every SIMD level gives the scalar pixels */
+            int scalar = overlay_set_simd_level(OVERLAY_SIMD_SCALAR);
+            assert(scalar);
+            Overlay ref = resize(&src_noise, filters[f], sizes[s][0], sizes[s][1]);
+            for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+                if (!overlay_set_simd_level(levels[l])) continue;
+                Overlay v = resize(&src_noise, filters[f], sizes[s][0], sizes[s][1]);
+                assert(v.width == ref.width && v.height == ref.height);
+                if (memcmp(v.data, ref.data, (size_t)v.width * v.height * 4) != 0) {
+                    fprintf(stderr, "filter %d to %dx%d: SIMD level %d mismatch\n",
+                            (int)filters[f], v.width, v.height, (int)levels[l]);
+                    return 1;
+                }
+                free_overlay(&v);
+                simd_checked++;
+            }
+            overlay_set_simd_level(overlay_simd_detect());
+            free_overlay(&ref);
+        }
+    }
+
+    /* Box fast paths: exact 2x and 4x are rounded block means, whole-number
+       enlargements repeat pixels */
+    Overlay half = resize(&src_noise, OVERLAY_FILTER_BOX, W / 2, H / 2);
+    Overlay quarter = resize(&src_noise, OVERLAY_FILTER_BOX, W / 4, H / 4);
+    Overlay triple = resize(&src_noise, OVERLAY_FILTER_BOX, W * 3, H * 3);
+    assert(half.width == W / 2 && quarter.width == W / 4 && triple.width == W * 3);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            for (int k = 0; k < 4; k++) {
+                unsigned char v = noise[((size_t)y * W + x) * 4 + k];
+                for (int j = 0; j < 9; j++) {
+                    size_t ty = (size_t)y * 3 + j / 3, tx = (size_t)x * 3 + j % 3;
+                    assert(triple.data[(ty * triple.width + tx) * 4 + k] == v);
+                }
+            }
+        }
+    }
+    for (int y = 0; y < H / 2; y++) {
+        for (int x = 0; x < W / 2; x++) {
+            for (int k = 0; k < 4; k++) {
+                unsigned int sum = 2;
+                for (int j = 0; j < 4; j++) {
+                    sum += noise[(((size_t)y * 2 + j / 2) * W + x * 2 + j % 2) * 4 + k];
+                }
+                assert(half.data[((size_t)y * half.width + x) * 4 + k] == sum >> 2);
+            }
+        }
+    }
+    for (int y = 0; y < H / 4; y++) {
+        for (int x = 0; x < W / 4; x++) {
+            for (int k = 0; k < 4; k++) {
+                unsigned int sum = 8;
+                for (int j = 0; j < 16; j++) {
+                    sum += noise[(((size_t)y * 4 + j / 4) * W + x * 4 + j % 4) * 4 + k];
+                }
+                assert(quarter.data[((size_t)y * quarter.width + x) * 4 + k] == sum >> 4);
+            }
+        }
+    }
+    free_overlay(&half);
+    free_overlay(&quarter);
+    free_overlay(&triple);
+
+    /* Enlarging a linear ramp: interpolating filters reproduce it away from
+       the clamped edges, and bilinear never overshoots */
+    const OverlayResizeFilter smooth[] = {
+        OVERLAY_FILTER_BILINEAR, OVERLAY_FILTER_CATMULL_ROM, OVERLAY_FILTER_LANCZOS3
+    };
+    for (size_t f = 0; f < sizeof(smooth) / sizeof(smooth[0]); f++) {
+        Overlay o = resize(&src_ramp, smooth[f], 200, 200);
+        double scale = (double)o.width / W;
+        for (int x = 0; x < o.width; x++) {
+            double ideal = 3.0 * ((x + 0.5) / scale - 0.5);
+            int v = o.data[((size_t)(o.height / 2) * o.width + x) * 4];
+            if (ideal > 9.0 && ideal < 3.0 * (W - 4)) {
+                assert(v >= (int)ideal - 1 && v <= (int)ideal + 2);
+            }
+            if (smooth[f] == OVERLAY_FILTER_BILINEAR && x > 0) {
+                assert(v >= o.data[((size_t)(o.height / 2) * o.width + x - 1) * 4]);
+            }
+        }
+        free_overlay(&o);
+    }
+
+    /* The filters really differ */
+    Overlay a = resize(&src_noise, OVERLAY_FILTER_BOX, 50, 50);
+    Overlay b = resize(&src_noise, OVERLAY_FILTER_LANCZOS3, 50, 50);
+    assert(memcmp(a.data, b.data, (size_t)a.width * a.height * 4) != 0);
+    free_overlay(&a);
+    free_overlay(&b);
+
+    overlay_set_resize_filter(OVERLAY_FILTER_AUTO);
+    overlay_source_free(&src_noise);
+    overlay_source_free(&src_flat);
+    overlay_source_free(&src_ramp);
+    free(noise);
+    free(flat);
+    free(ramp);
+
+    printf("test_overlay_resample: OK (%d SIMD run(s) checked)\n", simd_checked);
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "overlay.h"
+#include "overlay_simd.h"
+#include "test_util.h"
+
+/* 37x29 = 1073 pixels: not a multiple of 4 or 8, so every SIMD tail runs */
+#define W 37
+#define H 29
+
+static void fill_pattern(unsigned char *buf, size_t sz) {
+    test_fill_pattern(buf, sz, 12345u);
+    /* make sure the alpha extremes are covered */
+    buf[3] = 0;
+    buf[7] = 255;
+}
+
+int main(void) {
+    const float opacities[] = {0.0f, 0.25f, 0.3f, 0.5f, 0.7f, 0.8f, 0.85f, 0.999f, 1.0f};
+    const OverlaySimdLevel levels[] = {
+        OVERLAY_SIMD_SSE2, OVERLAY_SIMD_AVX2, OVERLAY_SIMD_NEON
+    };
+    size_t sz = (size_t)W * H * 4;
+
+    unsigned char *src = (unsigned char *)malloc(sz);
+    unsigned char *ref = (unsigned char *)malloc(sz);
+    Overlay img;
+    memset(&img, 0, sizeof(img));
+    img.width = W;
+    img.height = H;
+    img.channels = 4;
+    img.data = (unsigned char *)malloc(sz);
+    if (!src || !ref || !img.data) {
+        fprintf(stderr, "malloc failed\n");
+        return 2;
+    }
+    fill_pattern(src, sz);
+
+    OverlaySimdLevel best = overlay_simd_detect();
+    printf("test_overlay_simd: detected level %d\n", (int)best);
+    assert(overlay_get_simd_level() == best);
+
+    int tested = 0;
+    int ok;
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+        if (!overlay_set_simd_level(levels[l])) continue;
+        tested++;
+        for (size_t o = 0; o < sizeof(opacities) / sizeof(opacities[0]); o++) {
+            for (int invert = 0; invert < 2; invert++) {
+                /* Scalar reference */
+                ok = overlay_set_simd_level(OVERLAY_SIMD_SCALAR);
+                assert(ok);
+                memcpy(img.data, src, sz);
+                img.cached_effects = 0;
+                img.cached_opacity = -1.0f;
+                apply_effects(&img, opacities[o], invert);
+                memcpy(ref, img.data, sz);
+
+                ok = overlay_set_simd_level(levels[l]);
+                assert(ok);
+                memcpy(img.data, src, sz);
+                img.cached_effects = 0;
+                img.cached_opacity = -1.0f;
+                apply_effects(&img, opacities[o], invert);
+                if (memcmp(ref, img.data, sz) != 0) {
+                    fprintf(stderr, "level %d mismatch at opacity=%.3f invert=%d\n",
+                            (int)levels[l], opacities[o], invert);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    /* Alpha table / fixed-point multiplier must reproduce the original
+       float expression for every opacity step the UI can produce */
+    for (int step = 0; step <= 1000; step++) {
+        float opacity = step / 1000.0f;
+        for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+            if (!overlay_set_simd_level(levels[l])) continue;
+            memcpy(img.data, src, sz);
+            img.cached_effects = 0;
+            img.cached_opacity = -1.0f;
+            apply_effects(&img, opacity, 0);
+            for (size_t i = 0; i < sz; i += 4) {
+                if (img.data[i + 3] != (unsigned char)(src[i + 3] * opacity) ||
+                    img.data[i] != src[i]) {
+                    fprintf(stderr, "level %d opacity %.3f: alpha %d expected %d\n",
+                            (int)levels[l], opacity, img.data[i + 3],
+                            (unsigned char)(src[i + 3] * opacity));
+                    return 1;
+                }
+            }
+        }
+    }
+
+    /* Opacity 1.0 (the default, and always once the presenter owns opacity)
+       must stay vectorized. Scalar reads alpha through alpha_lut and SIMD
+       keeps identity alpha as is, so a poisoned table shows which ran. */
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+        if (!overlay_set_simd_level(levels[l])) continue;
+        OverlayEffectParams params;
+        overlay_effect_params_init(&params, 1.0f, 1);
+        assert(params.alpha_identity);
+        memset(params.alpha_lut, 0, sizeof(params.alpha_lut));
+        unsigned char px[8 * 4], out[8 * 4];
+        memcpy(px, src, sizeof(px));
+        overlay_get_effect_kernel()(px, out, 8, &params);
+        for (size_t i = 0; i < sizeof(px); i += 4) {
+            if (out[i + 3] != px[i + 3] || out[i] != 255 - px[i]) {
+                fprintf(stderr, "level %d: invert at opacity 1.0 fell back to scalar\n",
+                        (int)levels[l]);
+                return 1;
+            }
+        }
+    }
+
+    /* Fused copy path: 1024x1024 is past the streaming-store threshold. The
+       destination is offset by one pixel so the aligned head is exercised. */
+    {
+        Overlay big;
+        memset(&big, 0, sizeof(big));
+        big.width = 1024;
+        big.height = 1024;
+        big.channels = 4;
+        size_t big_sz = (size_t)big.width * big.height * 4;
+        big.data = (unsigned char *)malloc(big_sz);
+        unsigned char *big_ref = (unsigned char *)malloc(big_sz);
+        unsigned char *big_dst = (unsigned char *)malloc(big_sz + 4);
+        if (!big.data || !big_ref || !big_dst) {
+            fprintf(stderr, "malloc failed\n");
+            return 2;
+        }
+        fill_pattern(big.data, big_sz);
+
+        ok = overlay_set_simd_level(OVERLAY_SIMD_SCALAR);
+        assert(ok);
+        ok = apply_effects_copy(&big, big_ref, 0.7f, 1);
+        assert(ok == 1);
+        for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+            if (!overlay_set_simd_level(levels[l])) continue;
+            for (int offset = 0; offset <= 4; offset += 4) {
+                memset(big_dst, 0, big_sz + 4);
+                ok = apply_effects_copy(&big, big_dst + offset, 0.7f, 1);
+                assert(ok == 1);
+                if (memcmp(big_ref, big_dst + offset, big_sz) != 0) {
+                    fprintf(stderr, "level %d: fused copy mismatch (offset %d)\n",
+                            (int)levels[l], offset);
+                    return 1;
+                }
+            }
+        }
+        free(big_dst);
+        free(big_ref);
+        free_overlay(&big);
+    }
+
+    overlay_set_simd_level(best);
+    free(src);
+    free(ref);
+    free_overlay(&img);
+
+    printf("test_overlay_simd: OK (%d SIMD level(s) checked)\n", tested);
+    return 0;
+}
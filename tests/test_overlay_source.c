@@ -0,0 +1,115 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "overlay.h"
+
+static const unsigned char png_1x1[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A,
+    0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01,
+    0x08, 0x04, 0x00, 0x00, 0x00, 0xB5, 0x1C, 0x0C,
+    0x02, 0x00, 0x00, 0x00, 0x0B, 0x49, 0x44, 0x41,
+    0x54, 0x78, 0xDA, 0x63, 0xFC, 0xFF, 0x1F, 0x00,
+    0x03, 0x03, 0x01, 0xFE, 0x08, 0x79, 0x80, 0xED,
+    0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44,
+    0xAE, 0x42, 0x60, 0x82
+};
+
+int main(void) {
+    /* Decoding once and resampling gives what load_overlay_mem gives */
+    OverlaySource src;
+    OverlayError err = overlay_source_load_mem(png_1x1, sizeof(png_1x1), &src);
+    assert(err == OVERLAY_OK);
+    assert(src.width == 1 && src.height == 1);
+
+    const int sizes[][2] = {{1, 1}, {2, 2}, {5, 3}, {16, 40}};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        Overlay a, b;
+        err = overlay_from_source(&src, sizes[i][0], sizes[i][1], &a);
+        assert(err == OVERLAY_OK);
+        err = load_overlay_mem(png_1x1, sizeof(png_1x1), sizes[i][0], sizes[i][1], &b);
+        assert(err == OVERLAY_OK);
+        assert(a.width == b.width && a.height == b.height);
+        assert(memcmp(a.data, b.data, (size_t)a.width * a.height * 4) == 0);
+        assert(a.data == a.base && a.data != src.pixels);
+        free_overlay(&a);
+        free_overlay(&b);
+    }
+    overlay_source_free(&src);
+    assert(src.pixels == NULL);
+
+    /* A larger caller-built source: sizing keeps the aspect ratio, a
+       same-size request is an exact copy, and overlays never write back */
+    OverlaySource big;
+    memset(&big, 0, sizeof(big));
+    big.width = 64;
+    big.height = 48;
+    big.pixels = (unsigned char *)malloc((size_t)big.width * big.height * 4);
+    assert(big.pixels != NULL);
+    for (int i = 0; i < big.width * big.height * 4; i++) big.pixels[i] = (unsigned char)(i * 31);
+
+    Overlay same;
+    err = overlay_from_source(&big, 64, 48, &same);
+    assert(err == OVERLAY_OK);
+    assert(same.width == 64 && same.height == 48);
+    assert(memcmp(same.data, big.pixels, (size_t)64 * 48 * 4) == 0);
+    apply_effects(&same, 0.5f, 1);
+    assert(big.pixels[3] == (unsigned char)(3 * 31));
+    free_overlay(&same);
+
+    Overlay half;
+    err = overlay_from_source(&big, 32, 100, &half);
+    assert(err == OVERLAY_OK);
+    assert(half.width == 32 && half.height == 24);
+    free_overlay(&half);
+
+    Overlay fit;
+    err = overlay_from_source(&big, 1000, 60, &fit);
+    assert(err == OVERLAY_OK);
+    assert(fit.width == 80 && fit.height == 60);
+    free_overlay(&fit);
+
+    err = overlay_from_source(NULL, 10, 10, &fit);
+    assert(err == OVERLAY_ERROR_NULL_PARAM);
+
+    /* Wrapped pixels are used in place and never freed by the source */
+    OverlaySource view;
+    err = overlay_source_wrap(big.pixels, big.width, big.height, &view);
+    assert(err == OVERLAY_OK);
+    assert(view.pixels == big.pixels && view.borrowed);
+    err = overlay_source_build_mips(&view);
+    assert(err == OVERLAY_OK);
+    err = overlay_from_source(&view, 64, 48, &same);
+    assert(err == OVERLAY_OK);
+    assert(memcmp(same.data, big.pixels, (size_t)64 * 48 * 4) == 0);
+    free_overlay(&same);
+    /* Only the pyramid is the source's own memory */
+    size_t mip_bytes = 0;
+    for (int i = 0; i < view.mip_count; i++) {
+        mip_bytes += (size_t)view.mips[i].width * view.mips[i].height * 4;
+    }
+    assert(view.mip_count > 0 && overlay_source_heap_bytes(&view) == mip_bytes);
+    assert(overlay_source_heap_bytes(&big) >= (size_t)64 * 48 * 4);
+    overlay_source_free(&view);
+    assert(view.pixels == NULL && big.pixels[5] == (unsigned char)(5 * 31));
+    assert(overlay_source_heap_bytes(&view) == 0);
+    err = overlay_source_wrap(NULL, 1, 1, &view);
+    assert(err == OVERLAY_ERROR_NULL_PARAM);
+
+    /* Whatever the build embedded, the default source decodes the same way */
+    OverlaySource def;
+    err = overlay_source_load_default(&def);
+    if (err == OVERLAY_OK) {
+        int w = 0, h = 0;
+        assert(def.borrowed == (get_default_keymap_rgba(&w, &h) != NULL));
+        assert(def.width > 0 && def.height > 0);
+        overlay_source_free(&def);
+    } else {
+        assert(err == OVERLAY_ERROR_FILE_NOT_FOUND && def.pixels == NULL);
+    }
+    overlay_source_free(&big);
+
+    printf("test_overlay_source: OK\n");
+    return 0;
+}
@@ -0,0 +1,336 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "overlay.h"
+#include "overlay_png.h"
+#include "test_util.h"
+
+/* Minimal PNG writer: IDAT is deflated with fixed Huffman codes (literals
+   plus distance-1 runs) or stored blocks, and split across several chunks */
+static void put_bits(TestBuf *b, unsigned int v, int n) {
+    b->bits |= v << b->nbits;
+    b->nbits += n;
+    while (b->nbits >= 8) {
+        test_buf_put(b, (unsigned char)b->bits);
+        b->bits >>= 8;
+        b->nbits -= 8;
+    }
+}
+
+/* Huffman codes are sent most significant bit first */
+static void put_code(TestBuf *b, unsigned int code, int n) {
+    unsigned int rev = 0;
+    for (int i = 0; i < n; i++) rev |= ((code >> i) & 1u) << (n - 1 - i);
+    put_bits(b, rev, n);
+}
+
+static void put_literal(TestBuf *b, unsigned int v) {
+    if (v < 144) put_code(b, 0x30 + v, 8);
+    else if (v < 256) put_code(b, 0x190 + v - 144, 9);
+    else put_code(b, v - 256, 7); /* 256..279 */
+}
+
+static void zlib(TestBuf *z, const unsigned char *raw, size_t len, int stored) {
+    if (stored) {
+        test_zlib_stored(z, raw, len, 1000);
+        return;
+    }
+    test_buf_put(z, 0x78);
+    test_buf_put(z, 0x01);
+    put_bits(z, 1, 1); /* final */
+    put_bits(z, 1, 2); /* fixed Huffman */
+    for (size_t i = 0; i < len;) {
+        size_t run = 0;
+        while (i > 0 && i + run < len && run < 10 && raw[i + run] == raw[i - 1]) run++;
+        if (run >= 3) {
+            put_literal(z, 257 + (unsigned int)(run - 3)); /* lengths 3..10 */
+            put_code(z, 0, 5);                             /* distance 1 */
+            i += run;
+        } else {
+            put_literal(z, raw[i++]);
+        }
+    }
+    put_literal(z, 256);
+    if (z->nbits) put_bits(z, 0, 8 - z->nbits);
+    test_buf_put32(z, test_adler32(raw, len));
+}
+
+static unsigned int g_seed = 12345;
+static unsigned char rnd(void) {
+    g_seed = g_seed * 1103515245u + 12345u;
+    return (unsigned char)(g_seed >> 16);
+}
+
+static int paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+static size_t png_stride(int w, int color, int depth) {
+    static const int samples[] = {1, 0, 3, 1, 2, 0, 4};
+    return ((size_t)w * samples[color] * depth + 7) / 8;
+}
+
+/* Encode packed rows, cycling through every filter type */
+static TestBuf write_png(const unsigned char *img, int w, int h, int color, int depth,
+                     int interlace, int with_trns, int stored) {
+    size_t stride = png_stride(w, color, depth);
+    int bpp = (int)(stride / w) ? (int)(stride / w) : 1;
+    unsigned char *raw = (unsigned char *)malloc((stride + 1) * h);
+    assert(raw != NULL);
+
+    for (int y = 0; y < h; y++) {
+        int f = y % 5;
+        const unsigned char *cur = img + (size_t)y * stride;
+        const unsigned char *prev = y ? cur - stride : NULL;
+        unsigned char *o = raw + (size_t)y * (stride + 1);
+        o[0] = (unsigned char)f;
+        for (size_t x = 0; x < stride; x++) {
+            int a = x >= (size_t)bpp ? cur[x - bpp] : 0;
+            int b = prev ? prev[x] : 0;
+            int c = prev && x >= (size_t)bpp ? prev[x - bpp] : 0;
+            int pred = f == 1 ? a : f == 2 ? b : f == 3 ? (a + b) / 2 : f == 4 ? paeth(a, b, c) : 0;
+            o[1 + x] = (unsigned char)(cur[x] - pred);
+        }
+    }
+
+    TestBuf png;
+    memset(&png, 0, sizeof(png));
+    static const unsigned char sig[] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+    for (int i = 0; i < 8; i++) test_buf_put(&png, sig[i]);
+
+    unsigned char ihdr[13] = {0};
+    ihdr[3] = (unsigned char)w;
+    ihdr[2] = (unsigned char)(w >> 8);
+    ihdr[7] = (unsigned char)h;
+    ihdr[6] = (unsigned char)(h >> 8);
+    ihdr[8] = (unsigned char)depth;
+    ihdr[9] = (unsigned char)color;
+    ihdr[12] = (unsigned char)interlace;
+    test_png_chunk(&png, "IHDR", ihdr, sizeof(ihdr));
+
+    if (color == 3) {
+        unsigned char plte[6 * 3];
+        for (int i = 0; i < 18; i++) plte[i] = (unsigned char)(i * 37 + 11);
+        test_png_chunk(&png, "PLTE", plte, sizeof(plte));
+        if (with_trns) {
+            static const unsigned char alpha[] = {0, 128, 255, 7};
+            test_png_chunk(&png, "tRNS", alpha, sizeof(alpha));
+        }
+    } else if (with_trns && (color == 0 || color == 2)) {
+        /* Key on the value the runs use, so some pixels really match */
+        unsigned char key[6];
+        for (int i = 0; i < 6; i++) key[i] = depth == 16 ? 0x55 : 0;
+        if (depth == 8) key[1] = key[3] = key[5] = 0x55;
+        if (depth < 8) key[1] = (unsigned char)(0x55 & ((1 << depth) - 1));
+        test_png_chunk(&png, "tRNS", key, color == 0 ? 2 : 6);
+    }
+
+    TestBuf z;
+    memset(&z, 0, sizeof(z));
+    zlib(&z, raw, (stride + 1) * h, stored);
+    for (size_t pos = 0; pos < z.len; pos += 37) {
+        test_png_chunk(&png, "IDAT", z.data + pos, z.len - pos > 37 ? 37 : z.len - pos);
+    }
+    test_png_chunk(&png, "IEND", NULL, 0);
+
+    free(z.data);
+    free(raw);
+    return png;
+}
+
+/* Random image of the given layout */
+static TestBuf make_png(int w, int h, int color, int depth, int with_trns, int stored) {
+    size_t stride = png_stride(w, color, depth);
+    unsigned char *img = (unsigned char *)malloc(stride * h);
+    assert(img != NULL);
+    for (size_t i = 0; i < stride * h; i++) {
+        /* Runs as well as noise, and palette indices that stay in range */
+        img[i] = (i / 7) % 3 == 0 ? 0x55 : rnd();
+        if (color == 3 && depth == 8) img[i] %= 6;
+        if (color == 3 && depth == 4) img[i] &= 0x55;
+    }
+    TestBuf png = write_png(img, w, h, color, depth, 0, with_trns, stored);
+    free(img);
+    return png;
+}
+
+/* Every row of the streaming decode equals stb_image's RGBA */
+static void check_rows(const unsigned char *png, size_t len) {
+    OverlaySource ref;
+    OverlayError err = overlay_source_load_mem(png, (int)len, &ref);
+    assert(err == OVERLAY_OK);
+
+    OverlayPngStream *s = overlay_png_open(png, len);
+    assert(s != NULL);
+    int w, h;
+    overlay_png_size(s, &w, &h);
+    assert(w == ref.width && h == ref.height);
+    unsigned char *row = (unsigned char *)malloc((size_t)w * 4);
+    assert(row != NULL);
+    for (int y = 0; y < h; y++) {
+        int got = overlay_png_read_row(s, row);
+        assert(got);
+        assert(memcmp(row, ref.pixels + (size_t)y * w * 4, (size_t)w * 4) == 0);
+    }
+    int extra = overlay_png_read_row(s, row);
+    assert(!extra);
+    free(row);
+    overlay_png_close(s);
+    overlay_source_free(&ref);
+}
+
+int main(void) {
+    /* Every colour type and bit depth, with and without tRNS */
+    static const int layouts[][2] = {
+        {0, 1}, {0, 2}, {0, 4}, {0, 8}, {0, 16},
+        {2, 8}, {2, 16},
+        {3, 1}, {3, 2}, {3, 4}, {3, 8},
+        {4, 8}, {4, 16},
+        {6, 8}, {6, 16}
+    };
+    int checked = 0;
+    for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) {
+        for (int trns = 0; trns < 2; trns++) {
+            for (int stored = 0; stored < 2; stored++) {
+                TestBuf png = make_png(13, 11, layouts[i][0], layouts[i][1], trns, stored);
+                check_rows(png.data, png.len);
+                free(png.data);
+                checked++;
+            }
+        }
+    }
+
+#ifdef KEYMAP_PNG_PATH
+    /* The real asset uses dynamic Huffman blocks */
+    {
+        FILE *f = fopen(KEYMAP_PNG_PATH, "rb");
+        assert(f != NULL);
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        unsigned char *bytes = (unsigned char *)malloc((size_t)size);
+        assert(bytes != NULL);
+        size_t got = fread(bytes, 1, (size_t)size, f);
+        assert(got == (size_t)size);
+        fclose(f);
+        check_rows(bytes, (size_t)size);
+        free(bytes);
+        checked++;
+    }
+#endif
+
+    /* load_overlay_mem streams; sizes match and a same-size load is exact */
+    TestBuf png = make_png(120, 90, 6, 8, 0, 0);
+    OverlaySource src;
+    OverlayError err = overlay_source_load_mem(png.data, (int)png.len, &src);
+    assert(err == OVERLAY_OK);
+
+    Overlay same;
+    err = load_overlay_mem(png.data, (int)png.len, 120, 90, &same);
+    assert(err == OVERLAY_OK);
+    assert(same.width == 120 && same.height == 90);
+    assert(memcmp(same.data, src.pixels, (size_t)120 * 90 * 4) == 0);
+    free_overlay(&same);
+
+    /* Resampled while decoding: same size as overlay_from_source, and
+       pipelined decode gives exactly the single-threaded result */
+    const int sizes[][2] = {{60, 60}, {37, 100}, {240, 180}, {1, 1}};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        Overlay a, b, ref;
+        overlay_set_thread_count(1);
+        err = load_overlay_mem(png.data, (int)png.len, sizes[i][0], sizes[i][1], &a);
+        assert(err == OVERLAY_OK);
+        overlay_set_thread_count(4);
+        overlay_set_parallel_threshold(0);
+        err = load_overlay_mem(png.data, (int)png.len, sizes[i][0], sizes[i][1], &b);
+        assert(err == OVERLAY_OK);
+        overlay_set_thread_count(0);
+        overlay_set_parallel_threshold(OVERLAY_PARALLEL_DEFAULT_MIN_PIXELS);
+
+        err = overlay_from_source(&src, sizes[i][0], sizes[i][1], &ref);
+        assert(err == OVERLAY_OK);
+        assert(a.width == ref.width && a.height == ref.height);
+        assert(b.width == ref.width && b.height == ref.height);
+        size_t n = (size_t)a.width * a.height * 4;
+        assert(memcmp(a.data, b.data, n) == 0);
+        assert(a.data == a.base);
+        free_overlay(&a);
+        free_overlay(&b);
+        free_overlay(&ref);
+    }
+    overlay_source_free(&src);
+    free(png.data);
+
+    /* Streamed and whole-image resizes share the weight tables, so they
+       agree exactly for every filter, box fast paths included */
+    png = make_png(64, 64, 6, 8, 0, 1);
+    err = overlay_source_load_mem(png.data, (int)png.len, &src);
+    assert(err == OVERLAY_OK);
+    const OverlayResizeFilter filters[] = {
+        OVERLAY_FILTER_AUTO, OVERLAY_FILTER_BOX, OVERLAY_FILTER_BILINEAR,
+        OVERLAY_FILTER_CATMULL_ROM, OVERLAY_FILTER_LANCZOS3
+    };
+    const int gsizes[][2] = {{32, 32}, {16, 16}, {128, 128}, {100, 100}, {23, 23}};
+    for (size_t f = 0; f < sizeof(filters) / sizeof(filters[0]); f++) {
+        overlay_set_resize_filter(filters[f]);
+        for (size_t i = 0; i < sizeof(gsizes) / sizeof(gsizes[0]); i++) {
+            Overlay a, ref;
+            err = load_overlay_mem(png.data, (int)png.len, gsizes[i][0], gsizes[i][1], &a);
+            assert(err == OVERLAY_OK);
+            err = overlay_from_source(&src, gsizes[i][0], gsizes[i][1], &ref);
+            assert(err == OVERLAY_OK);
+            assert(a.width == ref.width && a.height == ref.height);
+            assert(memcmp(a.data, ref.data, (size_t)a.width * a.height * 4) == 0);
+            free_overlay(&a);
+            free_overlay(&ref);
+        }
+    }
+    overlay_set_resize_filter(OVERLAY_FILTER_AUTO);
+    overlay_source_free(&src);
+    free(png.data);
+
+    /* Corrupt data fails cleanly on both paths instead of hanging */
+    png = make_png(120, 90, 2, 8, 0, 1);
+    size_t cut = png.len - 300; /* rows run out partway */
+    OverlayPngStream *truncated = overlay_png_open(png.data, cut);
+    assert(truncated != NULL);
+    overlay_png_close(truncated);
+    for (int threads = 1; threads <= 4; threads += 3) {
+        Overlay bad;
+        overlay_set_thread_count(threads);
+        overlay_set_parallel_threshold(0);
+        err = load_overlay_mem(png.data, (int)cut, 50, 50, &bad);
+        assert(err != OVERLAY_OK);
+    }
+    overlay_set_thread_count(0);
+    overlay_set_parallel_threshold(OVERLAY_PARALLEL_DEFAULT_MIN_PIXELS);
+    free(png.data);
+
+    /* Interlaced images are left to stb_image */
+    static const unsigned char pixel[] = {10, 20, 30, 40};
+    png = write_png(pixel, 1, 1, 6, 8, 1, 0, 0);
+    OverlayPngStream *interlaced = overlay_png_open(png.data, png.len);
+    assert(interlaced == NULL);
+    Overlay img;
+    err = load_overlay_mem(png.data, (int)png.len, 2, 2, &img);
+    assert(err == OVERLAY_OK);
+    assert(img.width == 2 && img.height == 2);
+    assert(img.data[0] == 10 && img.data[3] == 40);
+    free_overlay(&img);
+    free(png.data);
+
+    /* Not a PNG at all */
+    static const unsigned char junk[] = "definitely not an image";
+    OverlayPngStream *not_png = overlay_png_open(junk, sizeof(junk));
+    assert(not_png == NULL);
+    Overlay none;
+    err = load_overlay_mem(junk, sizeof(junk), 8, 8, &none);
+    assert(err == OVERLAY_ERROR_DECODE_FAILED);
+
+    printf("test_overlay_stream: OK (%d PNG layouts checked)\n", checked);
+    return 0;
+}
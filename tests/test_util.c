@@ -0,0 +1,100 @@
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+void test_fill_pattern(unsigned char *buf, size_t sz, unsigned int seed) {
+    for (size_t i = 0; i < sz; i++) {
+        seed = seed * 1103515245u + 12345u;
+        buf[i] = (unsigned char)(seed >> 16);
+    }
+}
+
+int test_same_pixels(const Overlay *a, const Overlay *b) {
+    return a->width == b->width && a->height == b->height &&
+           memcmp(a->data, b->data, (size_t)a->width * a->height * 4) == 0;
+}
+
+void test_buf_put(TestBuf *b, unsigned char v) {
+    if (b->len == b->cap) {
+        b->cap = b->cap ? b->cap * 2 : 256;
+        b->data = (unsigned char *)realloc(b->data, b->cap);
+        assert(b->data != NULL);
+    }
+    b->data[b->len++] = v;
+}
+
+void test_buf_put32(TestBuf *b, unsigned int v) {
+    test_buf_put(b, (unsigned char)(v >> 24));
+    test_buf_put(b, (unsigned char)(v >> 16));
+    test_buf_put(b, (unsigned char)(v >> 8));
+    test_buf_put(b, (unsigned char)v);
+}
+
+unsigned int test_crc32(const unsigned char *p, size_t n) {
+    unsigned int c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < n; i++) {
+        c ^= p[i];
+        for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1u)));
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+unsigned int test_adler32(const unsigned char *p, size_t n) {
+    unsigned int a = 1, b = 0;
+    for (size_t i = 0; i < n; i++) {
+        a = (a + p[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+void test_png_chunk(TestBuf *png, const char *type, const unsigned char *data, size_t len) {
+    test_buf_put32(png, (unsigned int)len);
+    size_t start = png->len;
+    for (int i = 0; i < 4; i++) test_buf_put(png, (unsigned char)type[i]);
+    for (size_t i = 0; i < len; i++) test_buf_put(png, data[i]);
+    test_buf_put32(png, test_crc32(png->data + start, png->len - start));
+}
+
+void test_zlib_stored(TestBuf *z, const unsigned char *raw, size_t len, size_t block) {
+    test_buf_put(z, 0x78);
+    test_buf_put(z, 0x01);
+    size_t pos = 0;
+    do {
+        size_t n = len - pos > block ? block : len - pos;
+        test_buf_put(z, pos + n == len ? 1 : 0);
+        test_buf_put(z, (unsigned char)n);
+        test_buf_put(z, (unsigned char)(n >> 8));
+        test_buf_put(z, (unsigned char)~n);
+        test_buf_put(z, (unsigned char)(~n >> 8));
+        for (size_t i = 0; i < n; i++) test_buf_put(z, raw[pos + i]);
+        pos += n;
+    } while (pos < len);
+    test_buf_put32(z, test_adler32(raw, len));
+}
+
+TestBuf test_encode_png(const unsigned char *rgba, int w, int h) {
+    TestBuf raw = {0}, z = {0}, png = {0};
+    for (int y = 0; y < h; y++) {
+        test_buf_put(&raw, 0);
+        for (int x = 0; x < w * 4; x++) test_buf_put(&raw, rgba[(size_t)y * w * 4 + x]);
+    }
+    test_zlib_stored(&z, raw.data, raw.len, 65535);
+
+    static const unsigned char sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    for (int i = 0; i < 8; i++) test_buf_put(&png, sig[i]);
+    unsigned char ihdr[13] = {0};
+    ihdr[0] = (unsigned char)(w >> 24); ihdr[1] = (unsigned char)(w >> 16);
+    ihdr[2] = (unsigned char)(w >> 8);  ihdr[3] = (unsigned char)w;
+    ihdr[4] = (unsigned char)(h >> 24); ihdr[5] = (unsigned char)(h >> 16);
+    ihdr[6] = (unsigned char)(h >> 8);  ihdr[7] = (unsigned char)h;
+    ihdr[8] = 8; /* bit depth */
+    ihdr[9] = 6; /* RGBA */
+    test_png_chunk(&png, "IHDR", ihdr, sizeof(ihdr));
+    test_png_chunk(&png, "IDAT", z.data, z.len);
+    test_png_chunk(&png, "IEND", NULL, 0);
+    free(raw.data);
+    free(z.data);
+    return png;
+}
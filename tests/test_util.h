@@ -0,0 +1,43 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+/* Fixtures shared by the test executables; build tests/test_util.c with
+   any test that includes this */
+
+#include <stddef.h>
+#include "overlay.h"
+
+/* Fill sz bytes with a reproducible pseudo-random pattern (the LCG from
+   the C standard's rand example, top bits); the seed picks the sequence */
+void test_fill_pattern(unsigned char *buf, size_t sz, unsigned int seed);
+
+/* Same size and identical RGBA pixels */
+int test_same_pixels(const Overlay *a, const Overlay *b);
+
+/* Growable byte buffer; bits/nbits accumulate LSB-first deflate output.
+   Start from all zeroes, free data when done. */
+typedef struct {
+    unsigned char *data;
+    size_t len;
+    size_t cap;
+    unsigned int bits;
+    int nbits;
+} TestBuf;
+
+void test_buf_put(TestBuf *b, unsigned char v);
+void test_buf_put32(TestBuf *b, unsigned int v); /* big endian */
+
+unsigned int test_crc32(const unsigned char *p, size_t n);
+unsigned int test_adler32(const unsigned char *p, size_t n);
+
+/* Append a PNG chunk: length, type, data and CRC */
+void test_png_chunk(TestBuf *png, const char *type, const unsigned char *data, size_t len);
+
+/* Append a zlib stream holding raw in stored blocks of at most block bytes */
+void test_zlib_stored(TestBuf *z, const unsigned char *raw, size_t len, size_t block);
+
+/* 8-bit RGBA PNG of w x h pixels: unfiltered rows, one IDAT of stored
+   blocks */
+TestBuf test_encode_png(const unsigned char *rgba, int w, int h);
+
+#endif /* TEST_UTIL_H */
@@ -0,0 +1,94 @@
+/* Build-time host tool: write any file as a C array header in one linear
+   pass, replacing the byte-at-a-time CMake loop in embed_keymap.cmake.
+   Usage: embed_asset <input> <output.h> <symbol>
+   Emits <symbol>_data[] and <symbol>_size, plus an include guard derived
+   from the symbol. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define BYTES_PER_LINE 16
+
+int main(int argc, char **argv) {
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s <input> <output.h> <symbol>\n", argv[0]);
+        return 1;
+    }
+    const char *symbol = argv[3];
+    for (const char *p = symbol; *p; p++) {
+        if (!isalnum((unsigned char)*p) && *p != '_') {
+            fprintf(stderr, "embed_asset: invalid symbol name %s\n", symbol);
+            return 1;
+        }
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (!in) {
+        fprintf(stderr, "embed_asset: cannot read %s\n", argv[1]);
+        return 1;
+    }
+    FILE *out = fopen(argv[2], "wb");
+    if (!out) {
+        fprintf(stderr, "embed_asset: cannot write %s\n", argv[2]);
+        fclose(in);
+        return 1;
+    }
+
+    char guard[256];
+    size_t n = 0;
+    for (const char *p = symbol; *p && n + 1 < sizeof(guard) - 2; p++) {
+        guard[n++] = (char)toupper((unsigned char)*p);
+    }
+    memcpy(guard + n, "_H", 3);
+
+    fprintf(out, "/* Generated from %s by embed_asset */\n", argv[1]);
+    fprintf(out, "#ifndef %s\n#define %s\n\n", guard, guard);
+    fprintf(out, "static const unsigned char %s_data[] = {\n", symbol);
+
+    /* Each byte becomes "0xNN, " from a table; lines go out in one write */
+    static const char hex[] = "0123456789abcdef";
+    unsigned char buf[65536];
+    char line[8 + BYTES_PER_LINE * 6];
+    size_t total = 0, got;
+    size_t col = 0, len = 0;
+    while ((got = fread(buf, 1, sizeof(buf), in)) > 0) {
+        for (size_t i = 0; i < got; i++) {
+            if (col == 0) {
+                memcpy(line, "    ", 4);
+                len = 4;
+            }
+            line[len++] = '0';
+            line[len++] = 'x';
+            line[len++] = hex[buf[i] >> 4];
+            line[len++] = hex[buf[i] & 15];
+            line[len++] = ',';
+            if (++col == BYTES_PER_LINE) {
+                line[len++] = '\n';
+                fwrite(line, 1, len, out);
+                col = 0;
+            } else {
+                line[len++] = ' ';
+            }
+        }
+        total += got;
+    }
+    if (col) {
+        line[len - 1] = '\n';
+        fwrite(line, 1, len, out);
+    }
+    int read_error = ferror(in);
+    fclose(in);
+
+    /* An empty array is not valid C */
+    if (total == 0) fputs("    0x00\n", out);
+    fprintf(out, "};\n\nstatic const unsigned int %s_size = %lu;\n\n", symbol, (unsigned long)total);
+    fprintf(out, "#endif /* %s */\n", guard);
+
+    if (fclose(out) != 0 || read_error) {
+        fprintf(stderr, "embed_asset: error converting %s\n", argv[1]);
+        remove(argv[2]);
+        return 1;
+    }
+    return 0;
+}
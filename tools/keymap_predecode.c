@@ -0,0 +1,172 @@
+/* Build-time host tool: decode a PNG with stb_image and write its straight
+   RGBA pixels as a C header, so the app can use the embedded keymap without
+   decoding it at startup (EMBED_KEYMAP_RGBA).
+   Usage: keymap_predecode <input.png> <output.h>
+
+   Converter mode: transcode an image once to QOI, which load_overlay and
+   overlay_source_load decode several times faster than PNG. Drop the result
+   in as keymap.qoi.
+   Usage: keymap_predecode --qoi <input.png> <output.qoi>
+
+   Bundle mode: pack one keymap pre-rendered at several resolutions (PNG or
+   QOI files, stored as they are) into a bundle; load_overlay decodes only
+   the variant nearest the window's size. Drop the result in as
+   keymap.bundle.
+   Usage: keymap_predecode --bundle <output.bundle> <input>... */
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "overlay_qoi.h"
+#include "overlay_bundle.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+static int write_file(const char *path, const unsigned char *data, size_t len) {
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        fprintf(stderr, "keymap_predecode: cannot write %s\n", path);
+        return 1;
+    }
+    size_t written = fwrite(data, 1, len, out);
+    if (fclose(out) != 0 || written != len) {
+        fprintf(stderr, "keymap_predecode: error writing %s\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+static int convert_qoi(const char *input, const char *output) {
+    int width, height, channels;
+    unsigned char *pixels = stbi_load(input, &width, &height, &channels, 4);
+    if (!pixels) {
+        fprintf(stderr, "keymap_predecode: cannot decode %s: %s\n", input, stbi_failure_reason());
+        return 1;
+    }
+    size_t len;
+    unsigned char *qoi = overlay_qoi_encode(pixels, width, height, &len);
+    stbi_image_free(pixels);
+    if (!qoi) {
+        fprintf(stderr, "keymap_predecode: cannot encode %s (%dx%d)\n", input, width, height);
+        return 1;
+    }
+
+    int err = write_file(output, qoi, len);
+    free(qoi);
+    if (err) return err;
+    printf("%s: %dx%d, %zu bytes\n", output, width, height, len);
+    return 0;
+}
+
+static unsigned char *read_file(const char *path, size_t *len) {
+    FILE *in = fopen(path, "rb");
+    if (!in) return NULL;
+    unsigned char *data = NULL;
+    long size = -1;
+    if (fseek(in, 0, SEEK_END) == 0) size = ftell(in);
+    if (size > 0 && fseek(in, 0, SEEK_SET) == 0) {
+        data = (unsigned char *)malloc((size_t)size);
+        if (data && fread(data, 1, (size_t)size, in) != (size_t)size) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(in);
+    *len = (size_t)size;
+    return data;
+}
+
+static int pack_bundle(const char *output, int count, char **inputs) {
+    if (count > OVERLAY_BUNDLE_MAX_VARIANTS) {
+        fprintf(stderr, "keymap_predecode: at most %d variants\n", OVERLAY_BUNDLE_MAX_VARIANTS);
+        return 1;
+    }
+    OverlayBundleVariant variants[OVERLAY_BUNDLE_MAX_VARIANTS];
+    int loaded = 0, err = 0;
+    for (; loaded < count; loaded++) {
+        const char *input = inputs[loaded];
+        size_t len;
+        unsigned char *data = read_file(input, &len);
+        if (!data) {
+            fprintf(stderr, "keymap_predecode: cannot read %s\n", input);
+            err = 1;
+            break;
+        }
+        /* Only the size is needed: the encoded bytes go in unchanged */
+        int width = 0, height = 0, channels;
+        OverlayQoiStream *qoi = overlay_qoi_open(data, len);
+        if (qoi) {
+            overlay_qoi_size(qoi, &width, &height);
+            overlay_qoi_close(qoi);
+        } else if (len > (size_t)INT_MAX ||
+                   !stbi_info_from_memory(data, (int)len, &width, &height, &channels)) {
+            fprintf(stderr, "keymap_predecode: %s is not an image\n", input);
+            free(data);
+            err = 1;
+            break;
+        }
+        variants[loaded].width = width;
+        variants[loaded].height = height;
+        variants[loaded].data = data;
+        variants[loaded].size = len;
+        printf("  %s: %dx%d\n", input, width, height);
+    }
+
+    if (!err) {
+        size_t len;
+        unsigned char *bundle = overlay_bundle_write(variants, count, &len);
+        if (bundle) {
+            err = write_file(output, bundle, len);
+            free(bundle);
+            if (!err) printf("%s: %d variants, %zu bytes\n", output, count, len);
+        } else {
+            fprintf(stderr, "keymap_predecode: cannot build %s\n", output);
+            err = 1;
+        }
+    }
+    for (int i = 0; i < loaded; i++) free((void *)variants[i].data);
+    return err;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 4 && strcmp(argv[1], "--qoi") == 0) return convert_qoi(argv[2], argv[3]);
+    if (argc >= 4 && strcmp(argv[1], "--bundle") == 0) return pack_bundle(argv[2], argc - 3, argv + 3);
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <input.png> <output.h>\n"
+                        "       %s --qoi <input.png> <output.qoi>\n"
+                        "       %s --bundle <output.bundle> <input>...\n", argv[0], argv[0], argv[0]);
+        return 1;
+    }
+
+    int width, height, channels;
+    unsigned char *pixels = stbi_load(argv[1], &width, &height, &channels, 4);
+    if (!pixels) {
+        fprintf(stderr, "keymap_predecode: cannot decode %s: %s\n", argv[1], stbi_failure_reason());
+        return 1;
+    }
+
+    FILE *out = fopen(argv[2], "w");
+    if (!out) {
+        fprintf(stderr, "keymap_predecode: cannot write %s\n", argv[2]);
+        stbi_image_free(pixels);
+        return 1;
+    }
+
+    size_t size = (size_t)width * height * 4;
+    fprintf(out, "/* Generated from %s by keymap_predecode: straight RGBA */\n", argv[1]);
+    fprintf(out, "#ifndef KEYMAP_RGBA_EMBEDDED_H\n#define KEYMAP_RGBA_EMBEDDED_H\n\n");
+    fprintf(out, "static const int embedded_keymap_rgba_width = %d;\n", width);
+    fprintf(out, "static const int embedded_keymap_rgba_height = %d;\n\n", height);
+    fprintf(out, "static const unsigned char embedded_keymap_rgba[%lu] = {\n", (unsigned long)size);
+    for (size_t i = 0; i < size; i++) {
+        fprintf(out, "%s%u,", i % 16 == 0 ? (i ? "\n    " : "    ") : "", pixels[i]);
+    }
+    fprintf(out, "\n};\n\n#endif /* KEYMAP_RGBA_EMBEDDED_H */\n");
+    stbi_image_free(pixels);
+
+    if (fclose(out) != 0) {
+        fprintf(stderr, "keymap_predecode: error writing %s\n", argv[2]);
+        return 1;
+    }
+    return 0;
+}
@@ -1,85 +1,189 @@
 #include <windows.h>
+#include <process.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include "ImageManager.h"
 #include "../shared/log.h"
+#include "../shared/overlay_disk_cache.h"
+#include "../shared/overlay_bytes.h"
+#include "../shared/overlay_layout.h"
+#include "../shared/overlay_bundle.h"
 
 static Config *g_config = NULL;
 static Overlay g_overlay;
-static unsigned char *g_original_image = NULL;
-static int g_original_image_size = 0;
-static float g_last_scale = -1.0f;
-static int g_last_custom_width = -1;
-static int g_last_custom_height = -1;
-static int g_last_use_custom = -1;
+static OverlayBytes g_original_image; /* mapped file or embedded keymap, never copied */
+static OverlaySource g_source; /* decoded once; size changes only resample */
+static uint64_t g_source_id; /* overlay_disk_cache_source_id of the mapped bytes */
+static int g_presenter_opacity = 0;
+
+/* The config a build reads, copied on the thread that asks for the build:
+   the menu keeps writing g_config while a background load runs */
+typedef struct {
+    float scale;
+    int custom_width;
+    int custom_height;
+    int use_custom;
+    int resize_filter;
+    int memory_lean;
+    float opacity; /* baked into the pixels; 1.0 when the window applies it */
+    int invert;
+} BuildParams;
+
+static BuildParams g_last = {-1.0f, -1, -1, -1}; /* size of the current overlay */
+static BuildParams g_load_params; /* image_manager_start_load's snapshot */
+static HANDLE g_load_thread = NULL; /* image_manager_start_load worker */
+static int g_load_result = 0;
+
+/* Opacity baked into the pixels; 1.0 when the window applies it instead */
+static float pixel_opacity(void) {
+    return g_presenter_opacity ? 1.0f : g_config->opacity;
+}
+
+static void snapshot_config(BuildParams *p) {
+    p->scale = g_config->scale;
+    p->custom_width = g_config->custom_width_px;
+    p->custom_height = g_config->custom_height_px;
+    p->use_custom = g_config->use_custom_size;
+    p->resize_filter = g_config->resize_filter;
+    p->memory_lean = g_config->memory_lean;
+    p->opacity = pixel_opacity();
+    p->invert = g_config->invert;
+}
 
 static int ensure_original_image(void) {
-    if (g_original_image) return 1;
+    if (g_original_image.data) return 1;
 
+    /* A layout description wins over a bitmap next to it, a bundle of
+       pre-rendered sizes (keymap_predecode --bundle) over a single one, and
+       a QOI transcode (keymap_predecode --qoi) over the PNG it came from */
     const char *search_paths[] = {
+        "keymap.json",
+        "assets\\keymap.json",
+        "..\\assets\\keymap.json",
+        "keymap.bundle",
+        "assets\\keymap.bundle",
+        "..\\assets\\keymap.bundle",
+        "keymap.qoi",
+        "assets\\keymap.qoi",
+        "..\\assets\\keymap.qoi",
         "keymap.png",
         "assets\\keymap.png",
         "..\\assets\\keymap.png",
         NULL
     };
+    if (overlay_bytes_open(search_paths, &g_original_image) != OVERLAY_OK) return 0;
+    g_source_id = overlay_disk_cache_source_id(g_original_image.data, g_original_image.size);
+    return 1;
+}
 
-    for (int i = 0; search_paths[i]; i++) {
-        FILE *f = fopen(search_paths[i], "rb");
-        if (f) {
-            fseek(f, 0, SEEK_END);
-            long sz = ftell(f);
-            fseek(f, 0, SEEK_SET);
-            if (sz > 0) {
-                g_original_image = (unsigned char *)malloc((size_t)sz);
-                if (!g_original_image) {
-                    fclose(f);
-                    return 0;
-                }
-                if (fread(g_original_image, 1, (size_t)sz, f) == (size_t)sz) {
-                    g_original_image_size = (int)sz;
-                    fclose(f);
-                    return 1;
-                }
-                free(g_original_image);
-                g_original_image = NULL;
-            }
-            fclose(f);
-        }
+/* Decode the image the first time it is needed */
+static OverlayError ensure_source(void) {
+    if (g_source.pixels) return OVERLAY_OK;
+    OverlayError err = g_original_image.kind == OVERLAY_BYTES_EMBEDDED_RGBA
+        ? overlay_source_wrap(g_original_image.data, g_original_image.width,
+                              g_original_image.height, &g_source)
+        : overlay_source_load_mem(g_original_image.data, (int)g_original_image.size, &g_source);
+    /* Optional: without the pyramid every resize reads the full source */
+    if (err == OVERLAY_OK && overlay_source_build_mips(&g_source) != OVERLAY_OK) {
+        logger_log("Mip pyramid incomplete; resizing from the full source");
     }
+    return err;
+}
 
-    int size = 0;
-    const unsigned char *data = get_default_keymap(&size);
-    if (data && size > 0) {
-        g_original_image = (unsigned char *)malloc((size_t)size);
-        if (!g_original_image) return 0;
-        memcpy(g_original_image, data, (size_t)size);
-        g_original_image_size = size;
-        return 1;
+/* Layout descriptions are rasterized straight at the target size: no
+   source to decode and no resize */
+static OverlayError render_layout(int max_w, int max_h) {
+    OverlayLayout *layout;
+    OverlayError err = overlay_layout_parse((const char *)g_original_image.data,
+                                            g_original_image.size, &layout);
+    if (err != OVERLAY_OK) return err;
+    err = overlay_layout_render(layout, max_w, max_h, &g_overlay);
+    overlay_layout_free(layout);
+    return err;
+}
+
+/* The file is only read while building, so it is unmapped afterwards:
+   keymap.png then stays free to replace (Windows) or rewrite in place
+   (a mapped file truncated under us faults on POSIX). The decoded source
+   and g_source_id cover later size changes; layouts and bundles map the
+   file again. Memory-lean mode drops the decoded source too and
+   ensure_source brings it back. */
+static void release_source(const BuildParams *p) {
+    size_t saved = 0;
+    if (p->memory_lean) {
+        saved = overlay_source_heap_bytes(&g_source);
+        if (g_original_image.kind == OVERLAY_BYTES_MAPPED) saved += g_original_image.size;
+        overlay_source_free(&g_source);
     }
+    overlay_bytes_release(&g_original_image);
+    if (saved > 0) logger_log("Memory-lean: released %zu bytes of source image", saved);
+}
 
-    return 0;
+/* Resized pixels for this size: mapped from the disk cache when a previous
+   run produced them, otherwise decoded, resized and written back for the
+   next start. Effects are applied either way. */
+static OverlayError build_overlay(const BuildParams *p, int max_w, int max_h) {
+    /* A decoded source needs nothing more from the file */
+    if (!g_source.pixels && !ensure_original_image()) return OVERLAY_ERROR_FILE_NOT_FOUND;
+    const char *dir = get_default_cache_dir();
+    overlay_set_resize_filter((OverlayResizeFilter)p->resize_filter);
+    uint64_t key = overlay_disk_cache_key(g_source_id, max_w, max_h, overlay_get_resize_filter());
+    if (overlay_disk_cache_load(dir, key, &g_overlay) == OVERLAY_OK) {
+        logger_log("Overlay pixels loaded from cache");
+        apply_effects(&g_overlay, p->opacity, p->invert);
+        release_source(p);
+        return OVERLAY_OK;
+    }
+
+    OverlayError result;
+    if (g_source.pixels) {
+        result = overlay_from_source(&g_source, max_w, max_h, &g_overlay);
+    } else if (overlay_layout_detect(g_original_image.data, g_original_image.size)) {
+        result = render_layout(max_w, max_h);
+    } else if (overlay_bundle_detect(g_original_image.data, g_original_image.size)) {
+        /* Only the variant nearest this size is decoded, so there is no
+           source worth keeping between sizes */
+        result = load_overlay_mem(g_original_image.data, (int)g_original_image.size,
+                                  max_w, max_h, &g_overlay);
+    } else {
+        result = ensure_source();
+        if (result == OVERLAY_OK) {
+            result = overlay_from_source(&g_source, max_w, max_h, &g_overlay);
+        }
+    }
+    if (result != OVERLAY_OK) {
+        release_source(p);
+        return result;
+    }
+
+    if (overlay_disk_cache_store(dir, key, &g_overlay) == OVERLAY_OK) {
+        overlay_disk_cache_evict(dir, OVERLAY_DISK_CACHE_MAX_BYTES, &key);
+    }
+    apply_effects(&g_overlay, p->opacity, p->invert);
+    release_source(p);
+    return OVERLAY_OK;
 }
 
 int image_manager_init(Config *config) {
     g_config = config;
     memset(&g_overlay, 0, sizeof(g_overlay));
+    memset(&g_source, 0, sizeof(g_source));
+    memset(&g_original_image, 0, sizeof(g_original_image));
     return 1;
 }
 
 void image_manager_cleanup(void) {
+    image_manager_wait_loaded();
     free_overlay(&g_overlay);
-    if (g_original_image) {
-        free(g_original_image);
-        g_original_image = NULL;
-        g_original_image_size = 0;
-    }
+    overlay_source_free(&g_source);
+    overlay_bytes_release(&g_original_image);
 }
 
-int image_manager_load_overlay(void) {
-    if (!ensure_original_image()) {
-        logger_log("Could not find keymap.png or embedded fallback");
+static int load_overlay_with(const BuildParams *p) {
+    if (!g_source.pixels && !ensure_original_image()) {
+        logger_log("Could not find keymap.json, keymap.png or embedded fallback");
         return 0;
     }
 
@@ -92,25 +196,24 @@ int image_manager_load_overlay(void) {
 
     int screen_w = mon.right - mon.left;
     int screen_h = mon.bottom - mon.top;
-    if (g_config->use_custom_size) {
+    if (p->use_custom) {
         /* Use custom pixel dimensions */
-        max_w = g_config->custom_width_px;
-        max_h = g_config->custom_height_px;
+        max_w = p->custom_width;
+        max_h = p->custom_height;
     } else {
         /* Apply configurable scaling to monitor dimensions */
-        max_w = (int)(screen_w * g_config->scale);
-        max_h = (int)(screen_h * g_config->scale);
+        max_w = (int)(screen_w * p->scale);
+        max_h = (int)(screen_h * p->scale);
     }
 
-    OverlayError result = load_overlay_mem(g_original_image, g_original_image_size,
-                                           max_w, max_h, &g_overlay);
+    OverlayError result = build_overlay(p, max_w, max_h);
     if (result != OVERLAY_OK) {
         const char *error_msg = "Unknown error";
         switch (result) {
             case OVERLAY_ERROR_FILE_NOT_FOUND:
-                error_msg = "Could not find keymap.png in any location"; break;
+                error_msg = "Could not find keymap.json or keymap.png in any location"; break;
             case OVERLAY_ERROR_DECODE_FAILED:
-                error_msg = "Could not decode image file"; break;
+                error_msg = "Could not decode image file or layout"; break;
             case OVERLAY_ERROR_OUT_OF_MEMORY:
                 error_msg = "Out of memory loading image"; break;
             case OVERLAY_ERROR_RESIZE_FAILED:
@@ -123,44 +226,72 @@ int image_manager_load_overlay(void) {
         return 0;
     }
 
-    apply_effects(&g_overlay, g_config->opacity, g_config->invert);
-    g_last_scale = g_config->scale;
-    g_last_custom_width = g_config->custom_width_px;
-    g_last_custom_height = g_config->custom_height_px;
-    g_last_use_custom = g_config->use_custom_size;
+    /* The size actually built: a menu change made during a background load
+       differs from it, so the next reload_if_needed picks it up */
+    g_last = *p;
 
     logger_log("Overlay loaded: %dx%d", g_overlay.width, g_overlay.height);
     return 1;
 }
 
+int image_manager_load_overlay(void) {
+    BuildParams p;
+    snapshot_config(&p);
+    return load_overlay_with(&p);
+}
+
+static unsigned __stdcall load_thread_proc(void *arg) {
+    g_load_result = load_overlay_with((const BuildParams *)arg);
+    return 0;
+}
+
+int image_manager_start_load(void) {
+    if (g_load_thread) return 1;
+    snapshot_config(&g_load_params);
+    g_load_thread = (HANDLE)_beginthreadex(NULL, 0, load_thread_proc, &g_load_params, 0, NULL);
+    if (g_load_thread) return 1;
+
+    logger_log("Could not start overlay loader thread; loading inline");
+    g_load_result = load_overlay_with(&g_load_params);
+    return g_load_result;
+}
+
+int image_manager_wait_loaded(void) {
+    if (g_load_thread) {
+        WaitForSingleObject(g_load_thread, INFINITE);
+        CloseHandle(g_load_thread);
+        g_load_thread = NULL;
+    }
+    return g_load_result;
+}
+
 int image_manager_reload_if_needed(void) {
-    if (fabsf(g_config->scale - g_last_scale) < 0.001f &&
-        g_config->custom_width_px == g_last_custom_width &&
-        g_config->custom_height_px == g_last_custom_height &&
-        g_config->use_custom_size == g_last_use_custom) {
-        return 0; /* No changes */
+    if (fabsf(g_config->scale - g_last.scale) < 0.001f &&
+        g_config->custom_width_px == g_last.custom_width &&
+        g_config->custom_height_px == g_last.custom_height &&
+        g_config->use_custom_size == g_last.use_custom) {
+        /* Same size: effect changes are one pass from the pristine base,
+           no decode or resize */
+        apply_effects(&g_overlay, pixel_opacity(), g_config->invert);
+        return 0;
     }
 
-    g_last_scale = g_config->scale;
-    g_last_custom_width = g_config->custom_width_px;
-    g_last_custom_height = g_config->custom_height_px;
-    g_last_use_custom = g_config->use_custom_size;
+    snapshot_config(&g_last);
 
     free_overlay(&g_overlay);
 
     int max_w, max_h;
-    if (g_config->use_custom_size) {
-        max_w = g_config->custom_width_px;
-        max_h = g_config->custom_height_px;
+    if (g_last.use_custom) {
+        max_w = g_last.custom_width;
+        max_h = g_last.custom_height;
     } else {
-        max_w = (int)(1920 * g_config->scale);
-        max_h = (int)(1080 * g_config->scale);
+        max_w = (int)(1920 * g_last.scale);
+        max_h = (int)(1080 * g_last.scale);
     }
 
-    OverlayError res = load_overlay_mem(g_original_image, g_original_image_size,
-                                        max_w, max_h, &g_overlay);
+    /* Resample from the decoded source; the PNG is decoded at most once */
+    OverlayError res = build_overlay(&g_last, max_w, max_h);
     if (res == OVERLAY_OK) {
-        apply_effects(&g_overlay, g_config->opacity, g_config->invert);
         logger_log("Overlay reloaded: %dx%d", g_overlay.width, g_overlay.height);
         return 1;
     }
@@ -170,7 +301,11 @@ int image_manager_reload_if_needed(void) {
 }
 
 void image_manager_apply_effects(void) {
-    apply_effects(&g_overlay, g_config->opacity, g_config->invert);
+    apply_effects(&g_overlay, pixel_opacity(), g_config->invert);
+}
+
+void image_manager_set_presenter_opacity(int enabled) {
+    g_presenter_opacity = enabled ? 1 : 0;
 }
 
 Overlay* image_manager_get_overlay(void) {
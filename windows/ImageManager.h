@@ -11,8 +11,18 @@ extern "C" {
 int image_manager_init(Config *config);
 void image_manager_cleanup(void);
 int image_manager_load_overlay(void);
+/* Run image_manager_load_overlay on a background thread (inline when no
+   thread can be started). Nothing else may touch the overlay until
+   image_manager_wait_loaded, which blocks for the rest of the work and
+   returns the load result. The config is read before this returns; size
+   changes made during the load are built by image_manager_reload_if_needed. */
+int image_manager_start_load(void);
+int image_manager_wait_loaded(void);
 int image_manager_reload_if_needed(void);
 void image_manager_apply_effects(void);
+/* Leave opacity to the presenter (OVERLAY_WINDOW_CAP_GLOBAL_ALPHA): pixel
+   passes then only apply invert */
+void image_manager_set_presenter_opacity(int enabled);
 Overlay* image_manager_get_overlay(void);
 int image_manager_get_dimensions(int *width, int *height);
 
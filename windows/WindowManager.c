@@ -1,7 +1,11 @@
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0601 /* UpdateLayeredWindowIndirect */
+#endif
 #include <windows.h>
 #include "WindowManager.h"
 #include "../shared/overlay.h"
 #include "../shared/config.h"
+#include "../shared/window.h"
 #include "../shared/log.h"
 
 static Config *g_config = NULL;
@@ -12,6 +16,7 @@ static HDC g_screen_dc = NULL;
 static HDC g_mem_dc = NULL;
 static void *g_bitmap_bits = NULL;
 static int g_visible = 0;
+static BYTE g_applied_alpha = 255; /* SourceConstantAlpha last composited */
 
 typedef struct {
     int target;
@@ -88,6 +93,18 @@ HWND window_manager_get_window(void) {
     return g_window;
 }
 
+/* Opacity is composited as SourceConstantAlpha; the DIB keeps full alpha */
+static BYTE config_alpha(void) {
+    float opacity = g_config ? g_config->opacity : 1.0f;
+    if (opacity < 0.0f) opacity = 0.0f;
+    if (opacity > 1.0f) opacity = 1.0f;
+    return (BYTE)(opacity * 255.0f + 0.5f);
+}
+
+int window_manager_get_caps(void) {
+    return OVERLAY_WINDOW_CAP_GLOBAL_ALPHA;
+}
+
 int window_manager_create_bitmap(void) {
     BITMAPV5HEADER bi = {0};
     bi.bV5Size = sizeof(BITMAPV5HEADER);
@@ -111,7 +128,9 @@ int window_manager_create_bitmap(void) {
                                 &g_bitmap_bits, NULL, 0);
     if (!g_bitmap) return 0;
 
-    memcpy(g_bitmap_bits, g_overlay->data, (size_t)g_overlay->width * g_overlay->height * 4);
+    /* AC_SRC_ALPHA wants premultiplied BGRA; convert in one pass */
+    apply_effects_format(g_overlay, g_bitmap_bits, 1.0f, 0, OVERLAY_FORMAT_BGRA_PREMUL);
+    overlay_clear_dirty(g_overlay);
     return 1;
 }
 
@@ -134,7 +153,8 @@ void window_manager_show_overlay(void) {
     SIZE size = {g_overlay->width, g_overlay->height};
     POINT src = {0, 0};
     POINT dst = {x, y};
-    BLENDFUNCTION bf = {AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
+    g_applied_alpha = config_alpha();
+    BLENDFUNCTION bf = {AC_SRC_OVER, 0, g_applied_alpha, AC_SRC_ALPHA};
 
     UpdateLayeredWindow(g_window, g_screen_dc, &dst, &size, g_mem_dc, &src, 0, &bf, ULW_ALPHA);
     ShowWindow(g_window, SW_SHOWNOACTIVATE);
@@ -171,8 +191,43 @@ int window_manager_is_visible(void) {
 }
 
 void window_manager_update_bitmap(void) {
-    if (g_bitmap_bits && g_overlay) {
-        memcpy(g_bitmap_bits, g_overlay->data, (size_t)g_overlay->width * g_overlay->height * 4);
+    if (!g_bitmap_bits || !g_overlay) return;
+
+    /* An opacity change is just a new constant alpha: no pixels to touch */
+    BYTE alpha = config_alpha();
+    int alpha_changed = alpha != g_applied_alpha;
+    if (g_overlay->dirty_count == 0 && !alpha_changed) return;
+
+    /* Only re-convert what changed since the last update */
+    RECT dirty = {g_overlay->width, g_overlay->height, 0, 0};
+    for (int i = 0; i < g_overlay->dirty_count; i++) {
+        const OverlayRect *r = &g_overlay->dirty[i];
+        apply_effects_format_rect(g_overlay, g_bitmap_bits, 1.0f, 0,
+                                  OVERLAY_FORMAT_BGRA_PREMUL, r);
+        if (r->x < dirty.left) dirty.left = r->x;
+        if (r->y < dirty.top) dirty.top = r->y;
+        if (r->x + r->width > dirty.right) dirty.right = r->x + r->width;
+        if (r->y + r->height > dirty.bottom) dirty.bottom = r->y + r->height;
+    }
+    overlay_clear_dirty(g_overlay);
+
+    /* A visible window only needs the changed area recomposed, unless the
+       constant alpha changed, which recomposes all of it */
+    if (g_visible) {
+        SIZE size = {g_overlay->width, g_overlay->height};
+        POINT src = {0, 0};
+        BLENDFUNCTION bf = {AC_SRC_OVER, 0, alpha, AC_SRC_ALPHA};
+        UPDATELAYEREDWINDOWINFO info = {0};
+        info.cbSize = sizeof(info);
+        info.hdcDst = g_screen_dc;
+        info.psize = &size;
+        info.hdcSrc = g_mem_dc;
+        info.pptSrc = &src;
+        info.pblend = &bf;
+        info.dwFlags = ULW_ALPHA;
+        info.prcDirty = alpha_changed || dirty.right <= dirty.left ? NULL : &dirty;
+        UpdateLayeredWindowIndirect(g_window, &info);
+        g_applied_alpha = alpha;
     }
 }
 
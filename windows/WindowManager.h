@@ -18,6 +18,7 @@ void window_manager_hide_overlay(void);
 void window_manager_toggle_overlay(void);
 int window_manager_is_visible(void);
 void window_manager_update_bitmap(void);
+int window_manager_get_caps(void); /* OVERLAY_WINDOW_CAP_* from shared/window.h */
 int window_manager_get_monitor_count(void);
 RECT window_manager_get_monitor_rect(int monitor_index);
 
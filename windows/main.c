@@ -18,13 +18,65 @@
 #include "HotkeyManager.h"
 #include "MenuController.h"
 #include "prefs_win32.h"
+#include "window.h"
 
 static Config g_config;
 static HWND g_hidden_window = NULL;
+static LARGE_INTEGER g_start_time;
+static int g_overlay_ready = 0; /* 1 = bitmap built, -1 = loading failed */
 
 /* Control IDs */
 #define ID_PREFS_OPEN 8
 
+static double ms_since_start(void) {
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    return (double)(now.QuadPart - g_start_time.QuadPart) * 1000.0 / (double)freq.QuadPart;
+}
+
+/* Lazy mode: the first show (or menu change) finishes the background load
+   and builds the bitmap; later calls return at once */
+static int ensure_overlay_ready(void) {
+    if (g_overlay_ready) return g_overlay_ready > 0;
+
+    double wait_start = ms_since_start();
+    if (!image_manager_wait_loaded()) {
+        logger_log("Failed to load overlay image");
+        g_overlay_ready = -1;
+        return 0;
+    }
+    if (!window_manager_create_bitmap()) {
+        logger_log("Failed to create bitmap");
+        g_overlay_ready = -1;
+        return 0;
+    }
+    g_overlay_ready = 1;
+    double now = ms_since_start();
+    logger_log("Time to first show: %.1f ms (%.1f ms waiting on the overlay)",
+               now, now - wait_start);
+    return 1;
+}
+
+static void show_overlay(void) {
+    if (ensure_overlay_ready()) window_manager_show_overlay();
+}
+
+static void toggle_overlay(void) {
+    if (window_manager_is_visible() || ensure_overlay_ready()) {
+        window_manager_toggle_overlay();
+    }
+}
+
+/* Menu changes: reload only when the size changed; otherwise the effects
+   were re-derived in place and the same-sized bitmap just needs refreshing */
+static void on_config_changed(void) {
+    if (!ensure_overlay_ready()) return;
+    if (!image_manager_reload_if_needed()) {
+        window_manager_update_bitmap();
+    }
+}
+
 
 
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
@@ -84,6 +136,8 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrev, LPSTR lpCmdLine, int nShow)
         }
     }
 
+    QueryPerformanceCounter(&g_start_time);
+
     g_config = get_default_config();
     load_config(&g_config, NULL);
 
@@ -98,6 +152,11 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrev, LPSTR lpCmdLine, int nShow)
         return 1;
     }
 
+    /* The layered window composites opacity itself, so pixel passes skip it
+       and opacity changes never reprocess the image */
+    image_manager_set_presenter_opacity(
+        (window_manager_get_caps() & OVERLAY_WINDOW_CAP_GLOBAL_ALPHA) != 0);
+
     if (!hotkey_manager_init(&g_config)) {
         logger_log("Failed to initialize hotkey manager");
         image_manager_cleanup();
@@ -105,8 +164,11 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrev, LPSTR lpCmdLine, int nShow)
         return 1;
     }
 
-    // Load overlay image
-    if (!image_manager_load_overlay()) {
+    /* Load overlay image: in lazy mode decode and resize in the background
+       while the tray and hotkey come up */
+    if (g_config.lazy_load) {
+        image_manager_start_load();
+    } else if (!image_manager_load_overlay()) {
         logger_log("Failed to load overlay image");
         hotkey_manager_cleanup();
         image_manager_cleanup();
@@ -135,13 +197,16 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrev, LPSTR lpCmdLine, int nShow)
         return 1;
     }
 
-    if (!window_manager_create_bitmap()) {
-        logger_log("Failed to create bitmap");
-        window_manager_cleanup();
-        hotkey_manager_cleanup();
-        image_manager_cleanup();
-        logger_close();
-        return 1;
+    if (!g_config.lazy_load) {
+        if (!window_manager_create_bitmap()) {
+            logger_log("Failed to create bitmap");
+            window_manager_cleanup();
+            hotkey_manager_cleanup();
+            image_manager_cleanup();
+            logger_close();
+            return 1;
+        }
+        g_overlay_ready = 1;
     }
 
     /* Initialize menu controller */
@@ -155,13 +220,13 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrev, LPSTR lpCmdLine, int nShow)
     }
 
     /* Setup callbacks */
-    hotkey_manager_set_toggle_callback(window_manager_toggle_overlay);
+    hotkey_manager_set_toggle_callback(toggle_overlay);
 
     menu_controller_set_callbacks(
-        window_manager_show_overlay,      // show
+        show_overlay,                     // show
         window_manager_hide_overlay,      // hide
-        window_manager_toggle_overlay,    // toggle
-        image_manager_reload_if_needed    // config changed
+        toggle_overlay,                   // toggle
+        on_config_changed                 // config changed
     );
 
     /* Register hotkey */
@@ -175,6 +240,8 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrev, LPSTR lpCmdLine, int nShow)
         return 1;
     }
 
+    logger_log("Time to tray and hotkey: %.1f ms", ms_since_start());
+
     /* Message loop */
     MSG msg;
     while (GetMessage(&msg, NULL, 0, 0)) {
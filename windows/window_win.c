@@ -1,6 +1,9 @@
 #include "window_win.h"
+#include "../shared/window.h"
+#include "../shared/overlay.h"
 #include <windows.h>
 #include <stdlib.h>
+#include <string.h>
 
 struct OverlayWindow {
     HWND window;
@@ -10,6 +13,7 @@ struct OverlayWindow {
     void *bitmap_bits;
     int width;
     int height;
+    BYTE alpha; /* SourceConstantAlpha from set_overlay_opacity */
 };
 
 static LRESULT CALLBACK OverlayWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
@@ -34,6 +38,7 @@ OverlayWindow* create_overlay_window(int width, int height) {
 
     overlay->width = width;
     overlay->height = height;
+    overlay->alpha = 255;
 
     // Get screen DC for layered window
     overlay->screen_dc = GetDC(NULL);
@@ -142,7 +147,12 @@ void set_overlay_opacity(OverlayWindow* window, float opacity) {
     POINT src = {0, 0};
     POINT dst = {0, 0}; // Will be set by position
 
-    BLENDFUNCTION bf = {AC_SRC_OVER, 0, (BYTE)(opacity * 255), AC_SRC_ALPHA};
+    if (opacity < 0.0f) opacity = 0.0f;
+    if (opacity > 1.0f) opacity = 1.0f;
+    window->alpha = (BYTE)(opacity * 255.0f + 0.5f);
+
+    // Pixels are untouched: the compositor applies the constant alpha
+    BLENDFUNCTION bf = {AC_SRC_OVER, 0, window->alpha, AC_SRC_ALPHA};
 
     // Get current position
     RECT rect;
@@ -154,6 +164,11 @@ void set_overlay_opacity(OverlayWindow* window, float opacity) {
                        window->mem_dc, &src, 0, &bf, ULW_ALPHA);
 }
 
+int get_overlay_window_caps(OverlayWindow* window) {
+    (void)window;
+    return OVERLAY_WINDOW_CAP_GLOBAL_ALPHA;
+}
+
 void set_overlay_click_through(OverlayWindow* window, int enabled) {
     if (!window || !window->window) return;
 
@@ -182,8 +197,14 @@ void update_overlay_content(OverlayWindow* window, const unsigned char* rgba_dat
                            int width, int height) {
     if (!window || !rgba_data || !window->bitmap_bits) return;
 
-    // Copy RGBA data to bitmap
-    memcpy(window->bitmap_bits, rgba_data, (size_t)width * height * 4);
+    // Convert straight RGBA to the premultiplied BGRA the layered window expects
+    Overlay view;
+    memset(&view, 0, sizeof(view));
+    view.data = (unsigned char *)rgba_data;
+    view.width = width;
+    view.height = height;
+    view.channels = 4;
+    apply_effects_format(&view, (unsigned char *)window->bitmap_bits, 1.0f, 0, OVERLAY_FORMAT_BGRA_PREMUL);
 
     // Update window content
     SelectObject(window->mem_dc, window->bitmap);
@@ -192,7 +213,7 @@ void update_overlay_content(OverlayWindow* window, const unsigned char* rgba_dat
     POINT src = {0, 0};
     POINT dst = {0, 0}; // Will be set by position
 
-    BLENDFUNCTION bf = {AC_SRC_OVER, 0, 255, AC_SRC_ALPHA}; // Default full opacity
+    BLENDFUNCTION bf = {AC_SRC_OVER, 0, window->alpha, AC_SRC_ALPHA};
 
     // Get current position
     RECT rect;